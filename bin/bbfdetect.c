@@ -39,23 +39,37 @@ int main(int argc, char** argv)
 			size_t len = 1024;
 			char* file = (char*)malloc(len);
 			ssize_t read;
-			while((read = getline(&file, &len, r)) != -1)
+			// decode a batch of images concurrently, and then detect objects on them one by one
+			char* files[64];
+			ccv_dense_matrix_t* images[64];
+			for (;;)
 			{
-				while(read > 1 && isspace(file[read - 1]))
-					read--;
-				file[read] = 0;
-				image = 0;
-				ccv_read(file, &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
-				assert(image != 0);
-				ccv_array_t* seq = ccv_bbf_detect_objects(image, &cascade, 1, ccv_bbf_default_params);
-				printf("%s %d\n", file, seq->rnum);
-				for (i = 0; i < seq->rnum; i++)
+				int j, count = 0;
+				while (count < 64 && (read = getline(&file, &len, r)) != -1)
 				{
-					ccv_comp_t* comp = (ccv_comp_t*)ccv_array_get(seq, i);
-					printf("%d %d %d %d %f\n", comp->rect.x, comp->rect.y, comp->rect.width, comp->rect.height, comp->classification.confidence);
+					while(read > 1 && isspace(file[read - 1]))
+						read--;
+					file[read] = 0;
+					files[count++] = strdup(file);
+				}
+				if (count == 0)
+					break;
+				ccv_read_batch((const void* const*)files, 0, count, images, 0, CCV_IO_GRAY | CCV_IO_ANY_FILE, 0, 0);
+				for (j = 0; j < count; j++)
+				{
+					image = images[j];
+					assert(image != 0);
+					ccv_array_t* seq = ccv_bbf_detect_objects(image, &cascade, 1, ccv_bbf_default_params);
+					printf("%s %d\n", files[j], seq->rnum);
+					for (i = 0; i < seq->rnum; i++)
+					{
+						ccv_comp_t* comp = (ccv_comp_t*)ccv_array_get(seq, i);
+						printf("%d %d %d %d %f\n", comp->rect.x, comp->rect.y, comp->rect.width, comp->rect.height, comp->classification.confidence);
+					}
+					ccv_array_free(seq);
+					ccv_matrix_free(image);
+					free(files[j]);
 				}
-				ccv_array_free(seq);
-				ccv_matrix_free(image);
 			}
 			free(file);
 			fclose(r);
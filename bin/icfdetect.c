@@ -11,8 +11,15 @@ static unsigned int get_current_time(void)
 
 int main(int argc, char** argv)
 {
-	assert(argc >= 3);
 	int i;
+	ccv_icf_param_t params = ccv_icf_default_params;
+	// an optional --approximate after the base directory (or in place of it) turns on the approximate feature pyramid
+	if (!strcmp(argv[argc - 1], "--approximate"))
+	{
+		params.flags |= CCV_ICF_APPROXIMATE;
+		--argc;
+	}
+	assert(argc >= 3);
 	ccv_enable_default_cache();
 	ccv_dense_matrix_t* image = 0;
 	ccv_icf_classifier_cascade_t* cascade = ccv_icf_read_classifier_cascade(argv[2]);
@@ -20,7 +27,7 @@ int main(int argc, char** argv)
 	if (image != 0)
 	{
 		unsigned int elapsed_time = get_current_time();
-		ccv_array_t* seq = ccv_icf_detect_objects(image, &cascade, 1, ccv_icf_default_params);
+		ccv_array_t* seq = ccv_icf_detect_objects(image, &cascade, 1, params);
 		elapsed_time = get_current_time() - elapsed_time;
 		for (i = 0; i < seq->rnum; i++)
 		{
@@ -39,23 +46,44 @@ int main(int argc, char** argv)
 			size_t len = 1024;
 			char* file = (char*)malloc(len);
 			ssize_t read;
-			while((read = getline(&file, &len, r)) != -1)
+			// decode a batch of images concurrently, and then detect objects on them one by one
+			char* files[64];
+			ccv_dense_matrix_t* images[64];
+			int total = 0;
+			unsigned int elapsed_time = 0;
+			for (;;)
 			{
-				while(read > 1 && isspace(file[read - 1]))
-					read--;
-				file[read] = 0;
-				image = 0;
-				ccv_read(file, &image, CCV_IO_ANY_FILE | CCV_IO_RGB_COLOR);
-				assert(image != 0);
-				ccv_array_t* seq = ccv_icf_detect_objects(image, &cascade, 1, ccv_icf_default_params);
-				for (i = 0; i < seq->rnum; i++)
+				int j, count = 0;
+				while (count < 64 && (read = getline(&file, &len, r)) != -1)
+				{
+					while(read > 1 && isspace(file[read - 1]))
+						read--;
+					file[read] = 0;
+					files[count++] = strdup(file);
+				}
+				if (count == 0)
+					break;
+				ccv_read_batch((const void* const*)files, 0, count, images, 0, CCV_IO_ANY_FILE | CCV_IO_RGB_COLOR, 0, 0);
+				for (j = 0; j < count; j++)
 				{
-					ccv_comp_t* comp = (ccv_comp_t*)ccv_array_get(seq, i);
-					printf("%s %d %d %d %d %f\n", file, comp->rect.x, comp->rect.y, comp->rect.width, comp->rect.height, comp->classification.confidence);
+					image = images[j];
+					assert(image != 0);
+					unsigned int start_time = get_current_time();
+					ccv_array_t* seq = ccv_icf_detect_objects(image, &cascade, 1, params);
+					elapsed_time += get_current_time() - start_time;
+					total += seq->rnum;
+					for (i = 0; i < seq->rnum; i++)
+					{
+						ccv_comp_t* comp = (ccv_comp_t*)ccv_array_get(seq, i);
+						printf("%s %d %d %d %d %f\n", files[j], comp->rect.x, comp->rect.y, comp->rect.width, comp->rect.height, comp->classification.confidence);
+					}
+					ccv_array_free(seq);
+					ccv_matrix_free(image);
+					free(files[j]);
 				}
-				ccv_array_free(seq);
-				ccv_matrix_free(image);
 			}
+			// the detections on stdout are what icfvldtr.rb reads, keep the timing on stderr
+			fprintf(stderr, "total : %d in time %dms\n", total, elapsed_time);
 			free(file);
 			fclose(r);
 		}
@@ -0,0 +1,66 @@
+#include <ccv.h>
+#include <ccv_internal.h>
+#include <nnc/ccv_nnc.h>
+#include <nnc/ccv_nnc_easy.h>
+#include <3rdparty/dsfmt/dSFMT.h>
+#include <sys/time.h>
+#include <ctype.h>
+
+static unsigned int get_current_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+#define BATCH_SIZE (1024)
+#define INPUT_DIM (1024)
+#define OUTPUT_DIM (1024)
+
+// compares ccv_gemm (built-in blocked gemm if ccv is compiled without BLAS) against the nnc GEMM command on BLAS.
+int main(int argc, char** argv)
+{
+	ccv_nnc_init();
+	ccv_disable_cache();
+	ccv_nnc_tensor_t* a = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(32F, BATCH_SIZE, INPUT_DIM), 0);
+	ccv_nnc_tensor_t* w = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(32F, OUTPUT_DIM, INPUT_DIM), 0);
+	ccv_nnc_tensor_t* bias = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(32F, OUTPUT_DIM), 0);
+	ccv_nnc_tensor_t* b = ccv_nnc_tensor_new(0, CPU_TENSOR_NHWC(32F, BATCH_SIZE, OUTPUT_DIM), 0);
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	int i;
+	for (i = 0; i < INPUT_DIM * OUTPUT_DIM; i++)
+		w->data.f32[i] = dsfmt_genrand_open_close(&dsfmt) / INPUT_DIM;
+	for (i = 0; i < BATCH_SIZE * INPUT_DIM; i++)
+		a->data.f32[i] = dsfmt_genrand_open_close(&dsfmt);
+	for (i = 0; i < OUTPUT_DIM; i++)
+		bias->data.f32[i] = 0;
+	const double gflop = 2.0 * BATCH_SIZE * INPUT_DIM * OUTPUT_DIM / 1e9;
+	ccv_nnc_cmd_t forw_cmd = CMD_GEMM_FORWARD(NO_TRANSPOSE, TRANSPOSE(0, 1));
+	forw_cmd.backend = CCV_NNC_BACKEND_CPU_OPT;
+	forw_cmd.algorithm = -1; // Uses BLAS if available.
+	unsigned int elapsed_time = get_current_time();
+	ccv_nnc_cmd_exec(forw_cmd, ccv_nnc_no_hint, 0, TENSOR_LIST(a, w, bias), TENSOR_LIST(b), 0);
+	elapsed_time = get_current_time() - elapsed_time;
+#if (defined HAVE_CBLAS || defined HAVE_ACCELERATE_FRAMEWORK)
+	printf("%u ms (%.2f GFLOPS) for BLAS\n", elapsed_time, gflop * 1000 / ccv_max(elapsed_time, 1));
+#else
+	printf("%u ms (%.2f GFLOPS) for nnc optimized\n", elapsed_time, gflop * 1000 / ccv_max(elapsed_time, 1));
+#endif
+	ccv_dense_matrix_t da = ccv_dense_matrix(BATCH_SIZE, INPUT_DIM, CCV_32F | CCV_C1, a->data.f32, 0);
+	ccv_dense_matrix_t dw = ccv_dense_matrix(OUTPUT_DIM, INPUT_DIM, CCV_32F | CCV_C1, w->data.f32, 0);
+	ccv_dense_matrix_t* db = 0;
+	elapsed_time = get_current_time();
+	ccv_gemm(&da, &dw, 1, 0, 0, CCV_B_TRANSPOSE, (ccv_matrix_t**)&db, 0);
+	elapsed_time = get_current_time() - elapsed_time;
+	printf("%u ms (%.2f GFLOPS) for ccv_gemm\n", elapsed_time, gflop * 1000 / ccv_max(elapsed_time, 1));
+	for (i = 0; i < BATCH_SIZE * OUTPUT_DIM; i++)
+		if (fabs(b->data.f32[i] - db->data.f32[i]) > 1e-4)
+			printf("output[%d]: %f %f\n", i, b->data.f32[i], db->data.f32[i]);
+	ccv_matrix_free(db);
+	ccv_nnc_tensor_free(a);
+	ccv_nnc_tensor_free(w);
+	ccv_nnc_tensor_free(bias);
+	ccv_nnc_tensor_free(b);
+	return 0;
+}
@@ -162,6 +162,19 @@ typedef union {
 	} terminal;
 } ccv_cache_index_t;
 
+typedef struct {
+	uint64_t hit; /**< The number of lookups (get / out) found the object. */
+	uint64_t miss; /**< The number of lookups found nothing. */
+	uint64_t put; /**< The number of objects put into the cache. */
+	uint64_t evict; /**< The number of objects evicted to make room for new ones. */
+	uint64_t saved; /**< The bytes of objects returned by hits. */
+} ccv_cache_stats_t;
+
+enum {
+	CCV_CACHE_LRU = 0, /**< Evict the least recently put object. */
+	CCV_CACHE_GDSF = 1, /**< Greedy-Dual-Size style, objects with higher recompute cost per byte stay longer. */
+};
+
 typedef struct {
 	ccv_cache_index_t origin;
 	uint32_t rnum;
@@ -169,6 +182,8 @@ typedef struct {
 	size_t up;
 	size_t size;
 	ccv_cache_index_free_f ffree[16];
+	ccv_cache_stats_t stats[16]; /**< Statistics per type, rnum / size are the current occupancy. */
+	int policy; /**< The eviction policy, CCV_CACHE_LRU by default, can be changed any time. */
 } ccv_cache_t;
 
 /* I made it as generic as possible */
@@ -185,7 +200,7 @@ void ccv_cache_init(ccv_cache_t* cache, size_t up, int cache_types, ccv_cache_in
  * Get an object from cache for its signature. 0 if cannot find the object.
  * @param cache The cache.
  * @param sign The signature.
- * @param type The type of the object.
+ * @param type The type of the object. If it cannot find the object, the miss is counted against the type it points to.
  * @return The pointer to the object.
  */
 void* ccv_cache_get(ccv_cache_t* cache, uint64_t sign, uint8_t* type);
@@ -200,10 +215,21 @@ void* ccv_cache_get(ccv_cache_t* cache, uint64_t sign, uint8_t* type);
  */
 int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uint8_t type);
 /**
- * Get an object from cache for its signature and then remove that object from the cache. 0 if cannot find the object.
+ * Put an object to cache with its signature, size, type and a hint of how expensive it is to recompute. The hint only matters with CCV_CACHE_GDSF policy.
  * @param cache The cache.
  * @param sign The signature.
+ * @param x The pointer to the object.
+ * @param size The size of the object.
  * @param type The type of the object.
+ * @param cost The approximate number of operations to recompute the object, 0 if unknown.
+ * @return 0 - success, 1 - replace, -1 - failure.
+ */
+int ccv_cache_put_with_cost(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uint8_t type, uint64_t cost);
+/**
+ * Get an object from cache for its signature and then remove that object from the cache. 0 if cannot find the object.
+ * @param cache The cache.
+ * @param sign The signature.
+ * @param type The type of the object. If it cannot find the object, the miss is counted against the type it points to.
  * @return The pointer to the object.
  */
 void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type);
@@ -214,6 +240,12 @@ void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type);
  * @return -1 if cannot find the object, otherwise return 0.
  */
 int ccv_cache_delete(ccv_cache_t* cache, uint64_t sign);
+/**
+ * Evict objects from cache, the least recently put ones (or the ones with the lowest priority with CCV_CACHE_GDSF) first, until the cache takes no more than given size.
+ * @param cache The cache.
+ * @param size The size in bytes the cache should fit in.
+ */
+void ccv_cache_shrink(ccv_cache_t* cache, size_t size);
 /**
  * Clean up the cache, free all objects inside and other memory space occupied.
  * @param cache The cache.
@@ -279,6 +311,17 @@ CCV_WARN_UNUSED(ccv_dense_matrix_t*) ccv_dense_matrix_renew(ccv_dense_matrix_t*
  * @return The newly created matrix object.
  */
 CCV_WARN_UNUSED(ccv_dense_matrix_t*) ccv_dense_matrix_new(int rows, int cols, int type, void* data, uint64_t sig);
+/**
+ * Create a dense matrix with its data section in a memory-mapped region. The matrix owns the region, it will be unmapped when the matrix is freed.
+ * @param rows Rows of the matrix.
+ * @param cols Columns of the matrix.
+ * @param type The data type and channels, as in ccv_dense_matrix_new.
+ * @param map The start of the region returned by mmap.
+ * @param size The size of the region.
+ * @param offset Where the data section starts within the region.
+ * @return The newly created matrix object.
+ */
+CCV_WARN_UNUSED(ccv_dense_matrix_t*) ccv_dense_matrix_new_mapped(int rows, int cols, int type, void* map, size_t size, size_t offset);
 /**
  * This method will return a dense matrix allocated on stack, with a data pointer to a custom memory region.
  * @param rows Rows of the matrix.
@@ -447,7 +490,7 @@ uint64_t ccv_cache_generate_signature(const char* msg, int len, uint64_t sig_sta
  */
 void ccv_drain_cache(void);
 /**
- * Drain up and disable the application-wide cache.
+ * Drain up and disable the application-wide cache (both the thread-local one and the shared one).
  */
 void ccv_disable_cache(void);
 /**
@@ -459,6 +502,115 @@ void ccv_enable_default_cache(void);
  * @param size The upper limit of the cache, in bytes.
  */
 void ccv_enable_cache(size_t size);
+/**
+ * Enable a application-wide cache that is shared across threads, thus, a matrix derived on one thread can be reused on another. The cache is split into lock-protected shards by signature, and bounded by given memory size in total (rather than per thread or per shard), thus, an object as large as the whole budget can still be cached. When the total goes over the budget, the other shards evict their least recently put objects in proportion to their size. If the thread-local cache is enabled on a thread as well, that thread will use its own cache instead. Enable / disable it when no other threads are using ccv.
+ * @param size The upper limit of the cache, in bytes.
+ */
+void ccv_enable_shared_cache(size_t size);
+
+/**
+ * Set the eviction policy of the application-wide cache (the thread-local one, and the shared one if enabled). Call it after the cache is enabled.
+ * @param policy CCV_CACHE_LRU or CCV_CACHE_GDSF.
+ */
+void ccv_set_cache_policy(int policy);
+/**
+ * Give the cache a hint of how expensive it is to recompute the matrix of this signature. It is used by CCV_CACHE_GDSF policy when the matrix is put into the cache (that is, when it is freed), thus, call it any time before the matrix is freed, from the same thread. Hints are kept in a small per-thread table, a later hint for another signature can take the place of this one.
+ * @param sig The signature of the matrix.
+ * @param cost The approximate number of operations to recompute the matrix.
+ */
+void ccv_cache_cost_hint(uint64_t sig, uint64_t cost);
+
+typedef struct {
+	uint32_t rnum; /**< The number of objects currently in the cache. */
+	size_t size; /**< The bytes currently occupied. */
+	size_t up; /**< The upper limit of the cache, in bytes. */
+	ccv_cache_stats_t matrix; /**< Statistics of ccv_dense_matrix_t objects. */
+	ccv_cache_stats_t array; /**< Statistics of ccv_array_t objects. */
+} ccv_cache_usage_t;
+
+/**
+ * Get the occupancy and the hit / miss / eviction statistics of the application-wide cache. It is the cache of the calling thread if enabled, otherwise the shared one summed over all shards.
+ * @return The usage of the cache.
+ */
+ccv_cache_usage_t ccv_cache_usage(void);
+
+typedef struct {
+	uint64_t hit; /**< The number of matrices read from the disk cache by this process. */
+	uint64_t miss; /**< The number of lookups found nothing by this process. */
+	uint64_t put; /**< The number of matrices written to the disk cache by this process. */
+	uint64_t reset; /**< The number of times the disk cache is full and started over by this process. */
+	uint32_t rnum; /**< The number of matrices currently in the disk cache. */
+	size_t size; /**< The bytes of matrix data currently in the disk cache. */
+} ccv_disk_cache_stats_t;
+
+/**
+ * Enable a disk cache backed by a memory-mapped file as the second tier of the application-wide cache. Matrices with derived signature are written to it when freed, and are looked up from it when the in-memory cache misses. Since signatures are derived from the content and the operations, the file can be reused after restart, and be shared by processes on the same host. When the file is full, it starts over. Enable / disable it when no other threads are using ccv.
+ * @param path The file to store the cache. If it is a valid disk cache already, it is used as is (with its own size).
+ * @param size The size of the file, in bytes.
+ * @return 0 for success, -1 if the file cannot be created or mapped.
+ */
+int ccv_enable_disk_cache(const char* path, size_t size);
+/**
+ * Disable the disk cache. The file is kept.
+ */
+void ccv_disable_disk_cache(void);
+/**
+ * Get statistics of the disk cache.
+ * @return The statistics, all zeros if the disk cache is not enabled.
+ */
+ccv_disk_cache_stats_t ccv_disk_cache_stats(void);
+
+typedef struct {
+	char name[32]; /**< The operation derived the signature, such as "ccv_sobel", or "unknown". */
+	uint64_t hit; /**< The number of lookups found the object. */
+	uint64_t miss; /**< The number of lookups found nothing. */
+	uint64_t put; /**< The number of objects put into the cache. */
+	uint64_t saved; /**< The bytes of objects returned by hits. */
+} ccv_cache_origin_stats_t;
+
+/**
+ * Start to break down cache lookups of this thread by the operation that derived the signature. It is not free (every signature generated is remembered for a while), thus, use it for tuning only.
+ */
+void ccv_enable_cache_origin_stats(void);
+/**
+ * Stop and discard the per-operation breakdown of this thread.
+ */
+void ccv_disable_cache_origin_stats(void);
+/**
+ * Get the per-operation breakdown of cache lookups of this thread.
+ * @param origins The array to be filled, can be 0.
+ * @param size The size of the array.
+ * @return The number of operations recorded so far, the first one is always "unknown".
+ */
+int ccv_cache_origin_stats(ccv_cache_origin_stats_t* origins, int size);
+
+typedef struct {
+	uint64_t alloc; /**< The number of matrices allocated through the pool. */
+	uint64_t reuse; /**< The number of allocations served by a recycled buffer. */
+	uint64_t malloc; /**< The number of allocations that have to call ccmalloc. */
+	uint64_t recycle; /**< The number of buffers returned to the pool. */
+	uint64_t free; /**< The number of buffers freed because the pool is full. */
+	size_t size; /**< The bytes currently retained by the pool. */
+} ccv_matrix_pool_stats_t;
+
+/**
+ * Enable a thread-local pool for dense matrix buffers. Matrices that are not picked up by the cache (for example, temporaries without signature) are recycled by size classes (header plus data, rounded up to at most 25% more) rather than going back to ccfree. This is useful when the same shapes are allocated over and over again, such as processing frames of a video.
+ * @param size The upper limit of bytes the pool retains, in bytes.
+ */
+void ccv_enable_matrix_pool(size_t size);
+/**
+ * Free all buffers retained by the matrix pool of this thread.
+ */
+void ccv_drain_matrix_pool(void);
+/**
+ * Drain up and disable the matrix pool of this thread.
+ */
+void ccv_disable_matrix_pool(void);
+/**
+ * Get the allocation counts of the matrix pool of this thread since it is enabled, thus, you can measure how many ccmalloc calls are saved.
+ * @return The statistics of the matrix pool.
+ */
+ccv_matrix_pool_stats_t ccv_matrix_pool_stats(void);
 
 #define ccv_get_dense_matrix_cell_by(type, x, row, col, ch) \
 	(((type) & CCV_32S) ? (void*)((x)->data.i32 + ((row) * (x)->cols + (col)) * CCV_GET_CHANNEL(type) + (ch)) : \
@@ -552,7 +704,7 @@ enum {
  * Read image from a file. This function has soft dependencies on [LibJPEG](http://libjpeg.sourceforge.net/) and [LibPNG](http://www.libpng.org/pub/png/libpng.html). No these libraries, no JPEG nor PNG read support. However, ccv does support BMP read natively (it is a simple format after all).
  * @param in The file name.
  * @param x The output image.
- * @param type CCV_IO_ANY_FILE, accept any file format. CCV_IO_GRAY, convert to grayscale image. CCV_IO_RGB_COLOR, convert to color image.
+ * @param type CCV_IO_ANY_FILE, accept any file format. CCV_IO_GRAY, convert to grayscale image. CCV_IO_RGB_COLOR, convert to color image. With CCV_IO_NO_COPY, a CCV_IO_BINARY_FILE is memory-mapped rather than read, the matrix data points into the mapping (copy-on-write), which is unmapped when the matrix is freed. Such matrix has no signature.
  */
 /**
  * @fn int ccv_read(const void* data, ccv_dense_matrix_t** x, int type, int size)
@@ -580,6 +732,27 @@ int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, in
 // this is a way to implement function-signature based dispatch, you can call either
 // ccv_read(in, x, type) or ccv_read(in, x, type, rows, cols, scanline)
 // notice that you can implement this with va_* functions, but that is not type-safe
+/**
+ * Read image from a file or a region of memory like ccv_read, but the image only needs to be as large as max_dimension on its larger side. JPEG images are decoded at 1/2, 1/4 or 1/8 scale in the DCT domain, whichever is the smallest but still no smaller than max_dimension, which is much faster and uses less memory for large images. Other formats are read at full size. Thus, you still need ccv_resample to get the exact size.
+ * @param in The file name, or the data memory.
+ * @param x The output image.
+ * @param type CCV_IO_ANY_FILE or CCV_IO_ANY_STREAM (and the specific formats), in conjunction with CCV_IO_GRAY or CCV_IO_RGB_COLOR.
+ * @param size The size of that data memory region, 0 for a file.
+ * @param max_dimension The larger side of the image you need, 0 to read at full size.
+ */
+int ccv_read_scaled(const void* in, ccv_dense_matrix_t** x, int type, int size, int max_dimension);
+/**
+ * Read a batch of images from files or regions of memory concurrently on a bounded number of threads. Each image is read the same way as ccv_read_scaled.
+ * @param ins The file names, or the data memory regions.
+ * @param sizes The sizes of the data memory regions, 0 for files.
+ * @param count The number of images.
+ * @param xs The output images, in the same order as ins. The image is 0 if it cannot be read.
+ * @param status The return value for each image, CCV_IO_FINAL if read, CCV_IO_ERROR if it cannot be read for any reason (including streams on platforms without fmemopen / funopen). It can be 0 if you don't need it.
+ * @param type CCV_IO_ANY_FILE or CCV_IO_ANY_STREAM (and the specific formats), in conjunction with CCV_IO_GRAY or CCV_IO_RGB_COLOR.
+ * @param max_dimension The larger side of the images you need, 0 to read at full size.
+ * @param threads The maximum number of threads to use, 0 for the number of processors.
+ */
+void ccv_read_batch(const void* const* ins, const int* sizes, int count, ccv_dense_matrix_t** xs, int* status, int type, int max_dimension, int threads);
 /**
  * Write image to a file. This function has soft dependencies on [LibJPEG](http://libjpeg.sourceforge.net/) and [LibPNG](http://www.libpng.org/pub/png/libpng.html). No these libraries, no JPEG nor PNG write support.
  * @param mat The input image.
@@ -638,6 +811,16 @@ double ccv_normalize(ccv_matrix_t* a, ccv_matrix_t** b, int btype, int flag);
  * @param padding_pattern CCV_NO_PADDING - the first row and the first column in the output matrix is the same as the input matrix. CCV_PADDING_ZERO - the first row and the first column in the output matrix is zero, thus, the output matrix size is 1 larger than the input matrix.
  */
 void ccv_sat(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int padding_pattern);
+/**
+ * Generate the [Summed Area Table](https://en.wikipedia.org/wiki/Summed_area_table) and the summed area table of squares in one pass, this is what you need to compute variance of any rectangle in constant time.
+ * @param a The input matrix.
+ * @param b The output matrix of summed area table.
+ * @param btype The type of output matrix of summed area table, if 0, ccv will try to match the input matrix for appropriate type.
+ * @param c The output matrix of summed area table of squares.
+ * @param ctype The type of output matrix of summed area table of squares, if 0, ccv will use CCV_64S for integer input and match the input matrix otherwise.
+ * @param padding_pattern CCV_NO_PADDING or CCV_PADDING_ZERO, same as in ccv_sat.
+ */
+void ccv_sat_sqsat(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int btype, ccv_dense_matrix_t** c, int ctype, int padding_pattern);
 /**
  * Dot product of two matrix.
  * @param a The input matrix.
@@ -697,7 +880,7 @@ enum {
 };
 
 /**
- * General purpose matrix multiplication. This function has a hard dependency on [cblas](http://www.netlib.org/blas/) library.
+ * General purpose matrix multiplication. It uses [cblas](http://www.netlib.org/blas/) library if available, otherwise falls back to a built-in blocked implementation.
  *
  * As general as it is, it computes:
  *
@@ -963,6 +1146,16 @@ typedef int(*ccv_array_group_f)(const void*, const void*, void*);
  * @param data Any extra user data.
  */
 int ccv_array_group(ccv_array_t* array, ccv_array_t** index, ccv_array_group_f gfunc, void* data);
+typedef ccv_rect_t(*ccv_array_group_bound_f)(const void*, void*);
+/**
+ * Group elements in the array from its similarity, with the same result as ccv_array_group. Rather than comparing every pair, it puts elements into a spatial grid by their bounds, and only compares a pair when their bounds intersect. Use it when there are many elements, such as raw detection windows.
+ * @param array The array.
+ * @param index The output index, same group element will have the same index.
+ * @param gfunc int ccv_array_group_f(const void* a, const void* b, void* data). Return 1 if a and b are in the same group.
+ * @param bfunc ccv_rect_t ccv_array_group_bound_f(const void* a, void* data). Return the bound of a, gfunc can only return 1 for a and b if their bounds intersect. An empty bound (with zero width or height) means a can be grouped with anything.
+ * @param data Any extra user data.
+ */
+int ccv_array_group_with_bound(ccv_array_t* array, ccv_array_t** index, ccv_array_group_f gfunc, ccv_array_group_bound_f bfunc, void* data);
 void ccv_make_array_immutable(ccv_array_t* array);
 void ccv_make_array_mutable(ccv_array_t* array);
 /**
@@ -1190,6 +1383,14 @@ void ccv_flip(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int btype, int type
  * @param sigma The sigma factor in Gaussian filtering kernel.
  */
 void ccv_blur(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, double sigma);
+/**
+ * Approximate [Gaussian blur](https://en.wikipedia.org/wiki/Gaussian_blur) with a recursive (IIR) filter. Its cost per pixel is a constant regardless of sigma, thus, it is preferable to ccv_blur for large sigma.
+ * @param a The input matrix.
+ * @param b The output matrix.
+ * @param type The type of output matrix, if 0, ccv will try to match the input matrix for appropriate type.
+ * @param sigma The sigma factor in Gaussian filtering kernel, it has to be no less than 0.5.
+ */
+void ccv_blur_recursive(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, double sigma);
 /** @} */
 
 /**
@@ -1200,14 +1401,18 @@ void ccv_blur(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, double si
 
 enum {
 	CCV_RGB_TO_YUV = 0x01,
+	CCV_YUV_TO_RGB = 0x02,
+	CCV_RGB_TO_GRAY = 0x03,
+	CCV_GRAY_TO_RGB = 0x04,
+	CCV_RGB_TO_LUV = 0x05,
 };
 
 /**
  * Convert matrix from one color space representation to another.
  * @param a The input matrix.
  * @param b The output matrix.
- * @param type The type of output matrix, if 0, ccv will use the sample type as the input matrix.
- * @param flag **CCV_RGB_TO_YUV** to convert from RGB color space to YUV color space.
+ * @param type The type of output matrix, if 0, ccv will use the sample type as the input matrix (CCV_32F for **CCV_RGB_TO_LUV**).
+ * @param flag **CCV_RGB_TO_YUV** to convert from RGB color space to YUV color space, **CCV_YUV_TO_RGB** for the reverse. **CCV_RGB_TO_GRAY** to convert to gray scale the same way ccv_read with CCV_IO_GRAY does, **CCV_GRAY_TO_RGB** for the reverse. **CCV_RGB_TO_LUV** to convert to LUV color space, scaled to 0~255 (as used in ICF and SCD).
  */
 void ccv_color_transform(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int flag);
 /**
@@ -1268,6 +1473,42 @@ void ccv_sample_down(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, in
  * @param src_y Shift the start point by src_y.
  */
 void ccv_sample_up(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int src_x, int src_y);
+
+typedef struct {
+	ccv_dense_matrix_t* a; /**< The source image, it is not owned by the pyramid. */
+	ccv_array_t* levels; /**< The levels built so far, each one is built only once. */
+} ccv_pyramid_t;
+
+/**
+ * Create an image pyramid on a given image. The pyramid is empty at first, levels are built lazily when they are asked for and cached until the pyramid is freed, thus, detectors that run on the same pyramid (ccv_bbf_detect_objects_in_pyramid, ccv_scd_detect_objects_in_pyramid, ccv_icf_detect_objects_in_pyramid and ccv_dpm_detect_objects_in_pyramid) build each level they share only once. A pyramid is not thread-safe.
+ * @param a The source image, it has to outlive the pyramid.
+ * @return An empty image pyramid.
+ */
+CCV_WARN_UNUSED(ccv_pyramid_t*) ccv_pyramid_new(ccv_dense_matrix_t* a);
+/**
+ * Get the level resampled from a given level with ccv_resample, build it if it is not in the pyramid yet.
+ * @param pyramid The image pyramid.
+ * @param level The level to resample from, it is either the source image or a level returned by the pyramid.
+ * @param rows The new row.
+ * @param cols The new column.
+ * @param type The interpolation method, see ccv_resample.
+ * @return The resampled level, it is owned by the pyramid.
+ */
+ccv_dense_matrix_t* ccv_pyramid_resample(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* level, int rows, int cols, int type);
+/**
+ * Get the level downsampled from a given level with ccv_sample_down, build it if it is not in the pyramid yet.
+ * @param pyramid The image pyramid.
+ * @param level The level to downsample from, it is either the source image or a level returned by the pyramid.
+ * @param src_x Shift the start point by src_x.
+ * @param src_y Shift the start point by src_y.
+ * @return The downsampled level, it is owned by the pyramid.
+ */
+ccv_dense_matrix_t* ccv_pyramid_sample_down(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* level, int src_x, int src_y);
+/**
+ * Free the image pyramid and all its levels, the source image is left untouched.
+ * @param pyramid The image pyramid.
+ */
+void ccv_pyramid_free(ccv_pyramid_t* pyramid);
 /** @} */
 
 /**
@@ -1318,6 +1559,16 @@ void ccv_perspective_transform(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, in
  * @param size The window size for HOG (default to 8)
  */
 void ccv_hog(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int b_type, int sbin, int size);
+/**
+ * Compute HOG for every level of an image pyramid in one call, it is the same as calling ccv_hog on each level, but the levels are computed in parallel (thus, order the levels from the largest to the smallest to keep threads busy).
+ * @param a The array of input matrices.
+ * @param b The array of output matrices, each one is treated the same as **b** in ccv_hog (0 to allocate a new one).
+ * @param count The number of levels.
+ * @param b_type The type of output matrices, if 0, ccv will try to match the input matrix for appropriate type.
+ * @param sbin The number of bins for orientation (default to 9).
+ * @param size The window size for HOG (default to 8)
+ */
+void ccv_hog_pyramid(ccv_dense_matrix_t** a, ccv_dense_matrix_t** b, int count, int b_type, int sbin, int size);
 /**
  * [Canny edge detector](https://en.wikipedia.org/wiki/Canny_edge_detector) implementation. For performance reason, this is a clean-up reimplementation of OpenCV's Canny edge detector, it has very similar performance characteristic as the OpenCV one. As of today, ccv's Canny edge detector only works with CCV_8U or CCV_32S dense matrix type.
  * @param a The input matrix.
@@ -1355,6 +1606,41 @@ typedef struct {
  * @param min_eigen The minimal eigen-value to pass optical flow computation
  */
 void ccv_optical_flow_lucas_kanade(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_array_t* point_a, ccv_array_t** point_b, ccv_size_t win_size, int level, double min_eigen);
+
+/**
+ * The image pyramid of a frame for Lucas Kanade optical flow. When tracking through a video, a frame is the next frame of one call and the first frame of the following call (or both, to compute the forward-backward error), keep its pyramid around, and it only needs to be built once.
+ */
+typedef struct {
+	int level; /**< The number of levels, including the frame itself */
+	uint64_t sig; /**< The signature of the frame */
+	ccv_dense_matrix_t** pyr; /**< A copy of the frame, and the downsampled ones on the following levels */
+	ccv_dense_matrix_t** dx; /**< The horizontal gradient of each level, computed when the pyramid is first used as the first frame */
+	ccv_dense_matrix_t** dy; /**< The vertical gradient of each level, computed along with the horizontal ones */
+} ccv_optical_flow_pyramid_t;
+
+/**
+ * Build the image pyramid of a frame for Lucas Kanade optical flow.
+ * @param a The frame, 8-bit single channel
+ * @param win_size The window size to compute each optical flow, the pyramid stops at the level too small for it
+ * @param level How many image pyramids to be used for the computation
+ * @return The image pyramid of the frame
+ */
+CCV_WARN_UNUSED(ccv_optical_flow_pyramid_t*) ccv_optical_flow_pyramid_new(ccv_dense_matrix_t* a, ccv_size_t win_size, int level);
+/**
+ * Free the image pyramid.
+ * @param pyramid The image pyramid
+ */
+void ccv_optical_flow_pyramid_free(ccv_optical_flow_pyramid_t* pyramid);
+/**
+ * Lucas Kanade optical flow on the image pyramids built with **ccv_optical_flow_pyramid_new**, the result is the same as **ccv_optical_flow_lucas_kanade** on the frames.
+ * @param a The image pyramid of the first frame
+ * @param b The image pyramid of the next frame, it has to be built with the same window size and level
+ * @param point_a The points in first frame, of **ccv_decimal_point_t** type
+ * @param point_b The output points in the next frame, of **ccv_decimal_point_with_status_t** type
+ * @param win_size The window size to compute each optical flow, it must be the one the pyramids built with
+ * @param min_eigen The minimal eigen-value to pass optical flow computation
+ */
+void ccv_optical_flow_lucas_kanade_pyramid(ccv_optical_flow_pyramid_t* a, ccv_optical_flow_pyramid_t* b, ccv_array_t* point_a, ccv_array_t** point_b, ccv_size_t win_size, double min_eigen);
 /** @} */
 
 /* modern computer vision algorithms */
@@ -1373,6 +1659,7 @@ typedef struct {
 	int hist_th_q_no;
 	float normalize_threshold;
 	int normalize_method;
+	int step; /**< Compute the descriptors only on every step pixels in both directions, 0 or 1 computes them on every pixel. */
 } ccv_daisy_param_t;
 
 enum {
@@ -1389,6 +1676,15 @@ enum {
  * @param params A **ccv_daisy_param_t** structure that defines various aspect of the feature extractor.
  */
 void ccv_daisy(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, ccv_daisy_param_t params);
+/**
+ * Compute DAISY descriptors only at the given points, the smoothed orientation layers are still computed on the whole image, but the descriptors are not. Each row of the output matrix is the descriptor of the point at the same index, points outside of the image get a zero descriptor.
+ * @param a The input matrix.
+ * @param points An array of **ccv_point_t**.
+ * @param b The output matrix.
+ * @param type The type of output matrix, if 0, ccv will try to match the input matrix for appropriate type.
+ * @param params A **ccv_daisy_param_t** structure that defines various aspect of the feature extractor, the step is ignored.
+ */
+void ccv_daisy_points(ccv_dense_matrix_t* a, ccv_array_t* points, ccv_dense_matrix_t** b, int type, ccv_daisy_param_t params);
 /** @} */
 
 /* sift related methods */
@@ -1654,6 +1950,15 @@ void ccv_dpm_mixture_model_new(char** posfiles, ccv_rect_t* bboxes, int posnum,
  * @return A **ccv_array_t** of **ccv_root_comp_t** that contains the root bounding box as well as its parts.
  */
 CCV_WARN_UNUSED(ccv_array_t*) ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model_t** model, int count, ccv_dpm_param_t params);
+/**
+ * Using a DPM mixture model to detect objects in a given image pyramid, the levels it needs are built in the pyramid if they are not there yet, thus, they can be shared with other detectors running on the same image.
+ * @param pyramid The image pyramid of the input image, see ccv_pyramid_new.
+ * @param model An array of mixture models.
+ * @param count How many mixture models you've passed in.
+ * @param params A **ccv_dpm_param_t** structure that defines various aspects of the detector.
+ * @return A **ccv_array_t** of **ccv_root_comp_t** that contains the root bounding box as well as its parts.
+ */
+CCV_WARN_UNUSED(ccv_array_t*) ccv_dpm_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, ccv_dpm_mixture_model_t** model, int count, ccv_dpm_param_t params);
 /**
  * Read DPM mixture model from a model file.
  * @param directory The model file for DPM mixture model.
@@ -1752,6 +2057,15 @@ void ccv_bbf_classifier_cascade_new(ccv_dense_matrix_t** posimg, int posnum, cha
  * @return A **ccv_array_t** of **ccv_comp_t** for detection results.
  */
 CCV_WARN_UNUSED(ccv_array_t*) ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_cascade_t** cascade, int count, ccv_bbf_param_t params);
+/**
+ * Using a BBF classifier cascade to detect objects in a given image pyramid, the levels it needs are built in the pyramid if they are not there yet, thus, they can be shared with other detectors running on the same image.
+ * @param pyramid The image pyramid of the input image, see ccv_pyramid_new.
+ * @param cascade An array of classifier cascades.
+ * @param count How many classifier cascades you've passed in.
+ * @param params A **ccv_bbf_param_t** structure that defines various aspects of the detector.
+ * @return A **ccv_array_t** of **ccv_comp_t** for detection results.
+ */
+CCV_WARN_UNUSED(ccv_array_t*) ccv_bbf_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, ccv_bbf_classifier_cascade_t** cascade, int count, ccv_bbf_param_t params);
 /**
  * Read BBF classifier cascade from working directory.
  * @param directory The working directory that trains a BBF classifier cascade.
@@ -1893,6 +2207,7 @@ typedef struct {
 	float nnc_verify_thres; // computed dynamically from negative examples
 	double var_thres; // computed dynamically from the supplied same
 	uint64_t frame_signature;
+	ccv_optical_flow_pyramid_t* pyr; // the image pyramid of the last frame, for short-term tracking
 	int count;
 	void* sfmt;
 	void* dsfmt;
@@ -1984,9 +2299,13 @@ typedef struct {
 	ccv_icf_classifier_cascade_t* cascade;
 } ccv_icf_multiscale_classifier_cascade_t; // Type B, scale the classifier
 
+enum {
+	CCV_ICF_APPROXIMATE = 0x01,
+};
+
 typedef struct {
 	int min_neighbors; /**< 0: no grouping afterwards. 1: group objects that intersects each other. > 1: group objects that intersects each other, and only passes these that have at least **min_neighbors** intersected objects. */
-	int flags;
+	int flags; /**< CCV_ICF_APPROXIMATE, compute the channel features exactly once per octave, and approximate the interval images in between with the power law of Fast Feature Pyramids for Object Detection (P. Dollar, R. Appel, S. Belongie, and P. Perona, PAMI 2014), it only affects classifier cascades of CCV_ICF_CLASSIFIER_TYPE_A, and trades a little accuracy for speed. */
 	int step_through; /**< The step size for detection. */
 	int interval; /**< Interval images between the full size image and the half size one. e.g. 2 will generate 2 images in between full size image and half size one: image with full size, image with 5/6 size, image with 2/3 size, image with 1/2 size. */
 	float threshold;
@@ -2065,6 +2384,15 @@ void ccv_icf_multiscale_classifier_cascade_free(ccv_icf_multiscale_classifier_ca
  * @return A **ccv_array_t** of **ccv_comp_t** with detection results.
  */
 CCV_WARN_UNUSED(ccv_array_t*) ccv_icf_detect_objects(ccv_dense_matrix_t* a, void* cascade, int count, ccv_icf_param_t params);
+/**
+ * Using a ICF classifier cascade to detect objects in a given image pyramid, the levels it needs are built in the pyramid if they are not there yet, thus, they can be shared with other detectors running on the same image.
+ * @param pyramid The image pyramid of the input image, see ccv_pyramid_new.
+ * @param cascade An array of classifier cascades.
+ * @param count How many classifier cascades you've passed in.
+ * @param params A **ccv_icf_param_t** structure that defines various aspects of the detector.
+ * @return A **ccv_array_t** of **ccv_comp_t** with detection results.
+ */
+CCV_WARN_UNUSED(ccv_array_t*) ccv_icf_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, void* cascade, int count, ccv_icf_param_t params);
 /** @} */
 
 /* SCD: SURF-Cascade Detector
@@ -2207,6 +2535,15 @@ void ccv_scd(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type);
  * @return A **ccv_array_t** of **ccv_comp_t** with detection results.
  */
 CCV_WARN_UNUSED(ccv_array_t*) ccv_scd_detect_objects(ccv_dense_matrix_t* a, ccv_scd_classifier_cascade_t** cascades, int count, ccv_scd_param_t params);
+/**
+ * Using a SCD classifier cascade to detect objects in a given image pyramid, the levels it needs are built in the pyramid if they are not there yet, thus, they can be shared with other detectors running on the same image.
+ * @param pyramid The image pyramid of the input image, see ccv_pyramid_new.
+ * @param cascades An array of classifier cascades.
+ * @param count How many classifier cascades you've passed in.
+ * @param params A **ccv_scd_param_t** structure that defines various aspects of the detector.
+ * @return A **ccv_array_t** of **ccv_comp_t** with detection results.
+ */
+CCV_WARN_UNUSED(ccv_array_t*) ccv_scd_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, ccv_scd_classifier_cascade_t** cascades, int count, ccv_scd_param_t params);
 /** @} */
 
 /* categorization types and methods for training */
@@ -5,6 +5,11 @@
 #elif HAVE_CBLAS
 #include <cblas.h>
 #endif
+#if defined(HAVE_SSE2)
+#include <emmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
 
 double ccv_trace(ccv_matrix_t* mat)
 {
@@ -76,62 +81,225 @@ double ccv_normalize(ccv_matrix_t* a, ccv_matrix_t** b, int btype, int flag)
 	return db->tb.f64 = sum;
 }
 
-void ccv_sat(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int padding_pattern)
+#define CCV_SAT_BAND_COLS (512)
+
+/* the in-row prefix sum of 8-bit single channel input into 32-bit integer, and optionally, the prefix sum of
+ * its square into 64-bit integer, it is computed 8 at a time by shift-and-add in register, the carry from
+ * the previous block is broadcasted and added on top, returns how many are done */
+static int _ccv_sat_row_8u(const unsigned char* a, int* b, int64_t* c, const int count)
 {
-	ccv_declare_derived_signature(sig, a->sig != 0, ccv_sign_with_format(20, "ccv_sat(%d)", padding_pattern), a->sig, CCV_EOF_SIGN);
-	int safe_type = (a->type & CCV_8U) ? ((a->rows * a->cols >= 0x808080) ? CCV_64S : CCV_32S) : ((a->type & CCV_32S) ? CCV_64S : a->type);
-	type = (type == 0) ? CCV_GET_DATA_TYPE(safe_type) | CCV_GET_CHANNEL(a->type) : CCV_GET_DATA_TYPE(type) | CCV_GET_CHANNEL(a->type);
-	int ch = CCV_GET_CHANNEL(a->type);
-	int i, j;
-	unsigned char* a_ptr = a->data.u8;
-	ccv_dense_matrix_t* db;
-	unsigned char* b_ptr;
-	switch (padding_pattern)
+	int i = 0;
+#if defined(HAVE_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	__m128i carry = zero, carry64 = zero;
+	for (; i < count - 7; i += 8)
 	{
-		case CCV_NO_PADDING:
-			db = *b = ccv_dense_matrix_renew(*b, a->rows, a->cols, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), type, sig);
-			ccv_object_return_if_cached(, db);
-			b_ptr = db->data.u8;
+		__m128i x = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(a + i)), zero);
+		// 8 * 255 still fits in 16-bit
+		__m128i y = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+		y = _mm_add_epi16(y, _mm_slli_si128(y, 4));
+		y = _mm_add_epi16(y, _mm_slli_si128(y, 8));
+		__m128i y0 = _mm_add_epi32(_mm_unpacklo_epi16(y, zero), carry);
+		__m128i y1 = _mm_add_epi32(_mm_unpackhi_epi16(y, zero), carry);
+		_mm_storeu_si128((__m128i*)(b + i), y0);
+		_mm_storeu_si128((__m128i*)(b + i + 4), y1);
+		carry = _mm_shuffle_epi32(y1, 0xff);
+		if (c)
+		{
+			// 255 * 255 fits in 16-bit unsigned, and 4 of them fits in 32-bit
+			__m128i x2 = _mm_mullo_epi16(x, x);
+			__m128i z0 = _mm_unpacklo_epi16(x2, zero);
+			__m128i z1 = _mm_unpackhi_epi16(x2, zero);
+			z0 = _mm_add_epi32(z0, _mm_slli_si128(z0, 4));
+			z0 = _mm_add_epi32(z0, _mm_slli_si128(z0, 8));
+			z1 = _mm_add_epi32(z1, _mm_slli_si128(z1, 4));
+			z1 = _mm_add_epi32(z1, _mm_slli_si128(z1, 8));
+			__m128i w0 = _mm_add_epi64(_mm_unpacklo_epi32(z0, zero), carry64);
+			__m128i w1 = _mm_add_epi64(_mm_unpackhi_epi32(z0, zero), carry64);
+			_mm_storeu_si128((__m128i*)(c + i), w0);
+			_mm_storeu_si128((__m128i*)(c + i + 2), w1);
+			carry64 = _mm_shuffle_epi32(w1, 0xee);
+			w0 = _mm_add_epi64(_mm_unpacklo_epi32(z1, zero), carry64);
+			w1 = _mm_add_epi64(_mm_unpackhi_epi32(z1, zero), carry64);
+			_mm_storeu_si128((__m128i*)(c + i + 4), w0);
+			_mm_storeu_si128((__m128i*)(c + i + 6), w1);
+			carry64 = _mm_shuffle_epi32(w1, 0xee);
+		}
+	}
+#elif defined(HAVE_NEON)
+	int32x4_t carry = vdupq_n_s32(0);
+	const uint16x8_t zero = vdupq_n_u16(0);
+	for (; i < count - 7; i += 8)
+	{
+		uint16x8_t x = vmovl_u8(vld1_u8(a + i));
+		uint16x8_t y = vaddq_u16(x, vextq_u16(zero, x, 7));
+		y = vaddq_u16(y, vextq_u16(zero, y, 6));
+		y = vaddq_u16(y, vextq_u16(zero, y, 4));
+		int32x4_t y0 = vaddq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(y))), carry);
+		int32x4_t y1 = vaddq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(y))), carry);
+		vst1q_s32(b + i, y0);
+		vst1q_s32(b + i + 4, y1);
+		carry = vdupq_n_s32(vgetq_lane_s32(y1, 3));
+	}
+	if (c)
+	{
+		int64_t sum = 0;
+		int j;
+		for (j = 0; j < i; j++)
+			c[j] = (sum += a[j] * a[j]);
+	}
+#endif
+	return i;
+}
+
+/* in-row prefix sum, for the sum and the squared sum respectively, start is where a vectorized prefix sum stopped */
+static void _ccv_sat_row(const unsigned char* a_ptr, const int a_type, unsigned char* b_ptr, const int b_type, const int start, const int count, const int ch)
+{
+	int j;
 #define for_block(_for_set_b, _for_get_b, _for_get) \
-			for (j = 0; j < ch; j++) \
-				_for_set_b(b_ptr, j, _for_get(a_ptr, j)); \
-			for (j = ch; j < a->cols * ch; j++) \
-				_for_set_b(b_ptr, j, _for_get_b(b_ptr, j - ch) + _for_get(a_ptr, j)); \
-			a_ptr += a->step; \
-			b_ptr += db->step; \
-			for (i = 1; i < a->rows; i++) \
-			{ \
-				for (j = 0; j < ch; j++) \
-					_for_set_b(b_ptr, j, _for_get_b(b_ptr - db->step, j) + _for_get(a_ptr, j)); \
-				for (j = ch; j < a->cols * ch; j++) \
-					_for_set_b(b_ptr, j, _for_get_b(b_ptr, j - ch) - _for_get_b(b_ptr - db->step, j - ch) + _for_get_b(b_ptr - db->step, j) + _for_get(a_ptr, j)); \
-				a_ptr += a->step; \
-				b_ptr += db->step; \
-			}
-			ccv_matrix_setter_getter(db->type, ccv_matrix_getter, a->type, for_block);
+	for (j = start; j < ch; j++) \
+		_for_set_b(b_ptr, j, _for_get(a_ptr, j)); \
+	for (j = ccv_max(start, ch); j < count; j++) \
+		_for_set_b(b_ptr, j, _for_get_b(b_ptr, j - ch) + _for_get(a_ptr, j));
+	ccv_matrix_setter_getter(b_type, ccv_matrix_getter, a_type, for_block);
 #undef for_block
-			break;
-		case CCV_PADDING_ZERO:
-			db = *b = ccv_dense_matrix_renew(*b, a->rows + 1, a->cols + 1, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), type, sig);
-			ccv_object_return_if_cached(, db);
-			b_ptr = db->data.u8;
-#define for_block(_for_set_b, _for_get_b, _for_get) \
-			for (j = 0; j < db->cols * ch; j++) \
-				_for_set_b(b_ptr, j, 0); \
-			b_ptr += db->step; \
-			for (i = 0; i < a->rows; i++) \
-			{ \
-				for (j = 0; j < ch; j++) \
-					_for_set_b(b_ptr, j, 0); \
-				for (j = ch; j < db->cols * ch; j++) \
-					_for_set_b(b_ptr, j, _for_get_b(b_ptr, j - ch) - _for_get_b(b_ptr - db->step, j - ch) + _for_get_b(b_ptr - db->step, j) + _for_get(a_ptr, j - ch)); \
-				a_ptr += a->step; \
-				b_ptr += db->step; \
-			}
-			ccv_matrix_setter_getter(db->type, ccv_matrix_getter, a->type, for_block);
+}
+
+static void _ccv_sat_sq_row(const unsigned char* a_ptr, const int a_type, unsigned char* c_ptr, const int c_type, const int start, const int count, const int ch)
+{
+	int j;
+#define for_block(_for_type_c, _for_set_c, _for_get_c, _for_get) \
+	for (j = start; j < ch; j++) \
+		_for_set_c(c_ptr, j, (_for_type_c)_for_get(a_ptr, j) * _for_get(a_ptr, j)); \
+	for (j = ccv_max(start, ch); j < count; j++) \
+		_for_set_c(c_ptr, j, _for_get_c(c_ptr, j - ch) + (_for_type_c)_for_get(a_ptr, j) * _for_get(a_ptr, j));
+	ccv_matrix_typeof_setter_getter(c_type, ccv_matrix_getter, a_type, for_block);
 #undef for_block
+}
+
+/* adds the previous row of prefix sums on top of the current one */
+static void _ccv_sat_accumulate(unsigned char* b_ptr, const unsigned char* p_ptr, const int type, const int count)
+{
+	int j = 0;
+#if defined(HAVE_SSE2)
+	switch (CCV_GET_DATA_TYPE(type))
+	{
+		case CCV_32S:
+			for (; j < count - 3; j += 4)
+				_mm_storeu_si128((__m128i*)((int*)b_ptr + j), _mm_add_epi32(_mm_loadu_si128((const __m128i*)((int*)b_ptr + j)), _mm_loadu_si128((const __m128i*)((const int*)p_ptr + j))));
+			break;
+		case CCV_64S:
+			for (; j < count - 1; j += 2)
+				_mm_storeu_si128((__m128i*)((int64_t*)b_ptr + j), _mm_add_epi64(_mm_loadu_si128((const __m128i*)((int64_t*)b_ptr + j)), _mm_loadu_si128((const __m128i*)((const int64_t*)p_ptr + j))));
+			break;
+		case CCV_32F:
+			for (; j < count - 3; j += 4)
+				_mm_storeu_ps((float*)b_ptr + j, _mm_add_ps(_mm_loadu_ps((float*)b_ptr + j), _mm_loadu_ps((const float*)p_ptr + j)));
+			break;
+		case CCV_64F:
+			for (; j < count - 1; j += 2)
+				_mm_storeu_pd((double*)b_ptr + j, _mm_add_pd(_mm_loadu_pd((double*)b_ptr + j), _mm_loadu_pd((const double*)p_ptr + j)));
 			break;
 	}
+#elif defined(HAVE_NEON)
+	switch (CCV_GET_DATA_TYPE(type))
+	{
+		case CCV_32S:
+			for (; j < count - 3; j += 4)
+				vst1q_s32((int*)b_ptr + j, vaddq_s32(vld1q_s32((int*)b_ptr + j), vld1q_s32((const int*)p_ptr + j)));
+			break;
+		case CCV_64S:
+			for (; j < count - 1; j += 2)
+				vst1q_s64((int64_t*)b_ptr + j, vaddq_s64(vld1q_s64((int64_t*)b_ptr + j), vld1q_s64((const int64_t*)p_ptr + j)));
+			break;
+		case CCV_32F:
+			for (; j < count - 3; j += 4)
+				vst1q_f32((float*)b_ptr + j, vaddq_f32(vld1q_f32((float*)b_ptr + j), vld1q_f32((const float*)p_ptr + j)));
+			break;
+	}
+#endif
+#define for_block(_, _for_set, _for_get) \
+	for (; j < count; j++) \
+		_for_set(b_ptr, j, _for_get(b_ptr, j) + _for_get(p_ptr, j));
+	ccv_matrix_setter_getter(type, for_block);
+#undef for_block
+}
+
+/* the summed area table is computed in two passes, first is the in-row prefix sum, row by row in parallel, and
+ * then the vertical accumulation, column band by column band in parallel. The squared sum (if dc is provided) is
+ * computed alongside while the row is still hot in cache */
+static void _ccv_sat(ccv_dense_matrix_t* a, ccv_dense_matrix_t* db, ccv_dense_matrix_t* dc, int padding_pattern)
+{
+	const int ch = CCV_GET_CHANNEL(a->type);
+	const int count = a->cols * ch;
+	unsigned char* b_data = db->data.u8;
+	unsigned char* c_data = dc ? dc->data.u8 : 0;
+	if (padding_pattern == CCV_PADDING_ZERO)
+	{
+		memset(db->data.u8, 0, db->step);
+		b_data += db->step + ch * CCV_GET_DATA_TYPE_SIZE(db->type);
+		if (dc)
+		{
+			memset(dc->data.u8, 0, dc->step);
+			c_data += dc->step + ch * CCV_GET_DATA_TYPE_SIZE(dc->type);
+		}
+	}
+	const int vectorized = (ch == 1 && CCV_GET_DATA_TYPE(a->type) == CCV_8U && CCV_GET_DATA_TYPE(db->type) == CCV_32S);
+	const int sq_vectorized = (vectorized && (!dc || CCV_GET_DATA_TYPE(dc->type) == CCV_64S));
+	parallel_for(i, a->rows) {
+		unsigned char* a_ptr = a->data.u8 + i * a->step;
+		unsigned char* b_ptr = b_data + i * db->step;
+		unsigned char* c_ptr = dc ? c_data + i * dc->step : 0;
+		if (padding_pattern == CCV_PADDING_ZERO)
+		{
+			memset(b_ptr - ch * CCV_GET_DATA_TYPE_SIZE(db->type), 0, ch * CCV_GET_DATA_TYPE_SIZE(db->type));
+			if (dc)
+				memset(c_ptr - ch * CCV_GET_DATA_TYPE_SIZE(dc->type), 0, ch * CCV_GET_DATA_TYPE_SIZE(dc->type));
+		}
+		int start = vectorized ? _ccv_sat_row_8u(a_ptr, (int*)b_ptr, sq_vectorized ? (int64_t*)c_ptr : 0, count) : 0;
+		_ccv_sat_row(a_ptr, a->type, b_ptr, db->type, start, count, ch);
+		if (dc)
+			_ccv_sat_sq_row(a_ptr, a->type, c_ptr, dc->type, sq_vectorized ? start : 0, count, ch);
+	} parallel_endfor
+	parallel_for(t, (count + CCV_SAT_BAND_COLS - 1) / CCV_SAT_BAND_COLS) {
+		int i;
+		const int band = ccv_min(CCV_SAT_BAND_COLS, count - t * CCV_SAT_BAND_COLS);
+		for (i = 1; i < a->rows; i++)
+		{
+			_ccv_sat_accumulate(b_data + i * db->step + t * CCV_SAT_BAND_COLS * CCV_GET_DATA_TYPE_SIZE(db->type), b_data + (i - 1) * db->step + t * CCV_SAT_BAND_COLS * CCV_GET_DATA_TYPE_SIZE(db->type), db->type, band);
+			if (dc)
+				_ccv_sat_accumulate(c_data + i * dc->step + t * CCV_SAT_BAND_COLS * CCV_GET_DATA_TYPE_SIZE(dc->type), c_data + (i - 1) * dc->step + t * CCV_SAT_BAND_COLS * CCV_GET_DATA_TYPE_SIZE(dc->type), dc->type, band);
+		}
+	} parallel_endfor
+}
+
+void ccv_sat(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int padding_pattern)
+{
+	ccv_declare_derived_signature(sig, a->sig != 0, ccv_sign_with_format(20, "ccv_sat(%d)", padding_pattern), a->sig, CCV_EOF_SIGN);
+	int safe_type = (a->type & CCV_8U) ? ((a->rows * a->cols >= 0x808080) ? CCV_64S : CCV_32S) : ((a->type & CCV_32S) ? CCV_64S : a->type);
+	type = (type == 0) ? CCV_GET_DATA_TYPE(safe_type) | CCV_GET_CHANNEL(a->type) : CCV_GET_DATA_TYPE(type) | CCV_GET_CHANNEL(a->type);
+	const int padding = (padding_pattern == CCV_PADDING_ZERO) ? 1 : 0;
+	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, a->rows + padding, a->cols + padding, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), type, sig);
+	ccv_object_return_if_cached(, db);
+	ccv_cache_cost_hint(db->sig, (uint64_t)a->rows * a->cols * CCV_GET_CHANNEL(a->type) * 2);
+	_ccv_sat(a, db, 0, padding_pattern);
+}
+
+void ccv_sat_sqsat(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int btype, ccv_dense_matrix_t** c, int ctype, int padding_pattern)
+{
+	ccv_declare_derived_signature(bsig, a->sig != 0, ccv_sign_with_format(20, "ccv_sat(%d)", padding_pattern), a->sig, CCV_EOF_SIGN);
+	ccv_declare_derived_signature(csig, a->sig != 0, ccv_sign_with_format(20, "ccv_sqsat(%d)", padding_pattern), a->sig, CCV_EOF_SIGN);
+	int safe_type = (a->type & CCV_8U) ? ((a->rows * a->cols >= 0x808080) ? CCV_64S : CCV_32S) : ((a->type & CCV_32S) ? CCV_64S : a->type);
+	btype = (btype == 0) ? CCV_GET_DATA_TYPE(safe_type) | CCV_GET_CHANNEL(a->type) : CCV_GET_DATA_TYPE(btype) | CCV_GET_CHANNEL(a->type);
+	int sq_safe_type = (a->type & (CCV_8U | CCV_32S)) ? CCV_64S : a->type;
+	ctype = (ctype == 0) ? CCV_GET_DATA_TYPE(sq_safe_type) | CCV_GET_CHANNEL(a->type) : CCV_GET_DATA_TYPE(ctype) | CCV_GET_CHANNEL(a->type);
+	const int padding = (padding_pattern == CCV_PADDING_ZERO) ? 1 : 0;
+	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, a->rows + padding, a->cols + padding, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), btype, bsig);
+	ccv_dense_matrix_t* dc = *c = ccv_dense_matrix_renew(*c, a->rows + padding, a->cols + padding, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), ctype, csig);
+	assert(db && dc);
+	ccv_object_return_if_cached(, db, dc);
+	ccv_revive_object_if_cached(db, dc);
+	_ccv_sat(a, db, dc, padding_pattern);
 }
 
 double ccv_sum(ccv_matrix_t* mat, int flag)
@@ -305,6 +473,251 @@ void ccv_scale(ccv_matrix_t* a, ccv_matrix_t** b, int type, double ds)
 	}
 }
 
+#if !(defined HAVE_CBLAS || defined HAVE_ACCELERATE_FRAMEWORK)
+/* the built-in gemm when no BLAS is available, it follows the usual Goto's scheme: a kc x nc panel of B is
+ * packed to fit in L2 / L3, a mc x kc block of A is packed (and scaled by alpha) to fit in L1 / L2, and
+ * a register-blocked micro kernel computes CCV_GEMM_MR x CCV_GEMM_NR of the output out of the packed data.
+ * The mc x kc blocks of A are independent, thus, run in parallel. */
+#define CCV_GEMM_MC (96)
+#define CCV_GEMM_KC (256)
+#define CCV_GEMM_NC (2048)
+#define CCV_GEMM_MR (4)
+#define CCV_GEMM_32F_NR (8)
+#define CCV_GEMM_64F_NR (4)
+
+static void _ccv_gemm_kernel_32f(const int kc, const float* ap, const float* bp, float* c, const int ldc)
+{
+	int i, p;
+#if defined(HAVE_SSE2)
+	__m128 c00 = _mm_setzero_ps(), c01 = _mm_setzero_ps();
+	__m128 c10 = _mm_setzero_ps(), c11 = _mm_setzero_ps();
+	__m128 c20 = _mm_setzero_ps(), c21 = _mm_setzero_ps();
+	__m128 c30 = _mm_setzero_ps(), c31 = _mm_setzero_ps();
+	for (p = 0; p < kc; p++)
+	{
+		__m128 b0 = _mm_load_ps(bp);
+		__m128 b1 = _mm_load_ps(bp + 4);
+		__m128 a0 = _mm_set1_ps(ap[0]);
+		__m128 a1 = _mm_set1_ps(ap[1]);
+		__m128 a2 = _mm_set1_ps(ap[2]);
+		__m128 a3 = _mm_set1_ps(ap[3]);
+		c00 = _mm_add_ps(c00, _mm_mul_ps(a0, b0));
+		c01 = _mm_add_ps(c01, _mm_mul_ps(a0, b1));
+		c10 = _mm_add_ps(c10, _mm_mul_ps(a1, b0));
+		c11 = _mm_add_ps(c11, _mm_mul_ps(a1, b1));
+		c20 = _mm_add_ps(c20, _mm_mul_ps(a2, b0));
+		c21 = _mm_add_ps(c21, _mm_mul_ps(a2, b1));
+		c30 = _mm_add_ps(c30, _mm_mul_ps(a3, b0));
+		c31 = _mm_add_ps(c31, _mm_mul_ps(a3, b1));
+		ap += CCV_GEMM_MR;
+		bp += CCV_GEMM_32F_NR;
+	}
+	__m128 cs[CCV_GEMM_MR][2] = { { c00, c01 }, { c10, c11 }, { c20, c21 }, { c30, c31 } };
+	for (i = 0; i < CCV_GEMM_MR; i++)
+	{
+		_mm_storeu_ps(c, _mm_add_ps(_mm_loadu_ps(c), cs[i][0]));
+		_mm_storeu_ps(c + 4, _mm_add_ps(_mm_loadu_ps(c + 4), cs[i][1]));
+		c += ldc;
+	}
+#elif defined(HAVE_NEON)
+	float32x4_t cs[CCV_GEMM_MR][2];
+	for (i = 0; i < CCV_GEMM_MR; i++)
+		cs[i][0] = cs[i][1] = vdupq_n_f32(0);
+	for (p = 0; p < kc; p++)
+	{
+		float32x4_t b0 = vld1q_f32(bp);
+		float32x4_t b1 = vld1q_f32(bp + 4);
+		for (i = 0; i < CCV_GEMM_MR; i++)
+		{
+			cs[i][0] = vmlaq_n_f32(cs[i][0], b0, ap[i]);
+			cs[i][1] = vmlaq_n_f32(cs[i][1], b1, ap[i]);
+		}
+		ap += CCV_GEMM_MR;
+		bp += CCV_GEMM_32F_NR;
+	}
+	for (i = 0; i < CCV_GEMM_MR; i++)
+	{
+		vst1q_f32(c, vaddq_f32(vld1q_f32(c), cs[i][0]));
+		vst1q_f32(c + 4, vaddq_f32(vld1q_f32(c + 4), cs[i][1]));
+		c += ldc;
+	}
+#else
+	int j;
+	float cs[CCV_GEMM_MR][CCV_GEMM_32F_NR] = {{0}};
+	for (p = 0; p < kc; p++)
+	{
+		for (i = 0; i < CCV_GEMM_MR; i++)
+			for (j = 0; j < CCV_GEMM_32F_NR; j++)
+				cs[i][j] += ap[i] * bp[j];
+		ap += CCV_GEMM_MR;
+		bp += CCV_GEMM_32F_NR;
+	}
+	for (i = 0; i < CCV_GEMM_MR; i++)
+	{
+		for (j = 0; j < CCV_GEMM_32F_NR; j++)
+			c[j] += cs[i][j];
+		c += ldc;
+	}
+#endif
+}
+
+static void _ccv_gemm_kernel_64f(const int kc, const double* ap, const double* bp, double* c, const int ldc)
+{
+	int i, p;
+#if defined(HAVE_SSE2)
+	__m128d c00 = _mm_setzero_pd(), c01 = _mm_setzero_pd();
+	__m128d c10 = _mm_setzero_pd(), c11 = _mm_setzero_pd();
+	__m128d c20 = _mm_setzero_pd(), c21 = _mm_setzero_pd();
+	__m128d c30 = _mm_setzero_pd(), c31 = _mm_setzero_pd();
+	for (p = 0; p < kc; p++)
+	{
+		__m128d b0 = _mm_load_pd(bp);
+		__m128d b1 = _mm_load_pd(bp + 2);
+		__m128d a0 = _mm_set1_pd(ap[0]);
+		__m128d a1 = _mm_set1_pd(ap[1]);
+		__m128d a2 = _mm_set1_pd(ap[2]);
+		__m128d a3 = _mm_set1_pd(ap[3]);
+		c00 = _mm_add_pd(c00, _mm_mul_pd(a0, b0));
+		c01 = _mm_add_pd(c01, _mm_mul_pd(a0, b1));
+		c10 = _mm_add_pd(c10, _mm_mul_pd(a1, b0));
+		c11 = _mm_add_pd(c11, _mm_mul_pd(a1, b1));
+		c20 = _mm_add_pd(c20, _mm_mul_pd(a2, b0));
+		c21 = _mm_add_pd(c21, _mm_mul_pd(a2, b1));
+		c30 = _mm_add_pd(c30, _mm_mul_pd(a3, b0));
+		c31 = _mm_add_pd(c31, _mm_mul_pd(a3, b1));
+		ap += CCV_GEMM_MR;
+		bp += CCV_GEMM_64F_NR;
+	}
+	__m128d cs[CCV_GEMM_MR][2] = { { c00, c01 }, { c10, c11 }, { c20, c21 }, { c30, c31 } };
+	for (i = 0; i < CCV_GEMM_MR; i++)
+	{
+		_mm_storeu_pd(c, _mm_add_pd(_mm_loadu_pd(c), cs[i][0]));
+		_mm_storeu_pd(c + 2, _mm_add_pd(_mm_loadu_pd(c + 2), cs[i][1]));
+		c += ldc;
+	}
+#else
+	int j;
+	double cs[CCV_GEMM_MR][CCV_GEMM_64F_NR] = {{0}};
+	for (p = 0; p < kc; p++)
+	{
+		for (i = 0; i < CCV_GEMM_MR; i++)
+			for (j = 0; j < CCV_GEMM_64F_NR; j++)
+				cs[i][j] += ap[i] * bp[j];
+		ap += CCV_GEMM_MR;
+		bp += CCV_GEMM_64F_NR;
+	}
+	for (i = 0; i < CCV_GEMM_MR; i++)
+	{
+		for (j = 0; j < CCV_GEMM_64F_NR; j++)
+			c[j] += cs[i][j];
+		c += ldc;
+	}
+#endif
+}
+
+static void _ccv_gemm_blocked(ccv_dense_matrix_t* da, ccv_dense_matrix_t* db, double alpha, double beta, int transpose, ccv_dense_matrix_t* dd)
+{
+	const int m = dd->rows, n = dd->cols, k = (transpose & CCV_A_TRANSPOSE) ? da->rows : da->cols;
+	const int lda = da->cols, ldb = db->cols, ldd = dd->cols;
+	const int a_row_inc = (transpose & CCV_A_TRANSPOSE) ? 1 : lda, a_col_inc = (transpose & CCV_A_TRANSPOSE) ? lda : 1;
+	const int b_row_inc = (transpose & CCV_B_TRANSPOSE) ? 1 : ldb, b_col_inc = (transpose & CCV_B_TRANSPOSE) ? ldb : 1;
+	int i, jc, pc;
+#define for_block(_type, _NR, _kernel, _data) \
+	do { \
+		const _type* const a_ptr = da->data._data; \
+		const _type* const b_ptr = db->data._data; \
+		_type* const d_ptr = dd->data._data; \
+		const _type alpha_t = (_type)alpha; \
+		if (beta == 0) \
+			memset(d_ptr, 0, sizeof(_type) * m * ldd); \
+		else if (beta != 1) \
+			for (i = 0; i < m * ldd; i++) \
+				d_ptr[i] *= beta; \
+		const int npanel = (ccv_min(CCV_GEMM_NC, n) + _NR - 1) / _NR; \
+		_type* bpack = 0; \
+		ccmemalign((void**)&bpack, 16, sizeof(_type) * CCV_GEMM_KC * _NR * npanel); \
+		for (jc = 0; jc < n; jc += CCV_GEMM_NC) \
+		{ \
+			const int nc = ccv_min(CCV_GEMM_NC, n - jc); \
+			for (pc = 0; pc < k; pc += CCV_GEMM_KC) \
+			{ \
+				const int kc = ccv_min(CCV_GEMM_KC, k - pc); \
+				parallel_for(jr, (nc + _NR - 1) / _NR) { \
+					int p, x; \
+					const int nr = ccv_min(_NR, nc - jr * _NR); \
+					_type* bp = bpack + jr * _NR * kc; \
+					const _type* b = b_ptr + pc * b_row_inc + (jc + jr * _NR) * b_col_inc; \
+					for (p = 0; p < kc; p++) \
+					{ \
+						for (x = 0; x < nr; x++) \
+							bp[x] = b[x * b_col_inc]; \
+						for (; x < _NR; x++) \
+							bp[x] = 0; \
+						bp += _NR; \
+						b += b_row_inc; \
+					} \
+				} parallel_endfor \
+				parallel_for(ic, (m + CCV_GEMM_MC - 1) / CCV_GEMM_MC) { \
+					int ir, jr, p, x, y; \
+					const int mc = ccv_min(CCV_GEMM_MC, m - ic * CCV_GEMM_MC); \
+					_type* apack = 0; \
+					ccmemalign((void**)&apack, 16, sizeof(_type) * CCV_GEMM_MC * kc); \
+					for (ir = 0; ir < mc; ir += CCV_GEMM_MR) \
+					{ \
+						const int mr = ccv_min(CCV_GEMM_MR, mc - ir); \
+						_type* ap = apack + ir * kc; \
+						const _type* a = a_ptr + (ic * CCV_GEMM_MC + ir) * a_row_inc + pc * a_col_inc; \
+						for (p = 0; p < kc; p++) \
+						{ \
+							for (y = 0; y < mr; y++) \
+								ap[y] = alpha_t * a[y * a_row_inc]; \
+							for (; y < CCV_GEMM_MR; y++) \
+								ap[y] = 0; \
+							ap += CCV_GEMM_MR; \
+							a += a_col_inc; \
+						} \
+					} \
+					for (jr = 0; jr < nc; jr += _NR) \
+					{ \
+						const int nr = ccv_min(_NR, nc - jr); \
+						for (ir = 0; ir < mc; ir += CCV_GEMM_MR) \
+						{ \
+							const int mr = ccv_min(CCV_GEMM_MR, mc - ir); \
+							_type* d = d_ptr + (ic * CCV_GEMM_MC + ir) * ldd + jc + jr; \
+							if (mr == CCV_GEMM_MR && nr == _NR) \
+								_kernel(kc, apack + ir * kc, bpack + jr * kc, d, ldd); \
+							else { \
+								/* at the edges, computes a full tile out of the zero-padded data and only takes what we need */ \
+								_type tile[CCV_GEMM_MR * _NR]; \
+								memset(tile, 0, sizeof(tile)); \
+								_kernel(kc, apack + ir * kc, bpack + jr * kc, tile, _NR); \
+								for (y = 0; y < mr; y++) \
+									for (x = 0; x < nr; x++) \
+										d[y * ldd + x] += tile[y * _NR + x]; \
+							} \
+						} \
+					} \
+					ccfree(apack); \
+				} parallel_endfor \
+			} \
+		} \
+		ccfree(bpack); \
+	} while (0)
+	switch (CCV_GET_DATA_TYPE(dd->type))
+	{
+		case CCV_32F:
+			for_block(float, CCV_GEMM_32F_NR, _ccv_gemm_kernel_32f, f32);
+			break;
+		case CCV_64F:
+			for_block(double, CCV_GEMM_64F_NR, _ccv_gemm_kernel_64f, f64);
+			break;
+		default:
+			assert(0 && "ccv_gemm only supports CCV_32F and CCV_64F");
+	}
+#undef for_block
+}
+#endif
+
 void ccv_gemm(ccv_matrix_t* a, ccv_matrix_t* b, double alpha, ccv_matrix_t* c, double beta, int transpose, ccv_matrix_t** d, int type)
 {
 	ccv_dense_matrix_t* da = ccv_get_dense_matrix(a);
@@ -337,6 +750,6 @@ void ccv_gemm(ccv_matrix_t* a, ccv_matrix_t* b, double alpha, ccv_matrix_t* c, d
 			break;
 	}
 #else
-	assert(0 && "You need a BLAS compatible library for this function, e.g. libatlas.");
+	_ccv_gemm_blocked(da, db, alpha, beta, transpose, dd);
 #endif
 }
@@ -1,193 +1,242 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 #if defined(HAVE_SSE2)
-#include <xmmintrin.h>
+#include <emmintrin.h>
 #elif defined(HAVE_NEON)
 #include <arm_neon.h>
 #endif
 
+/* the difference of two rows of 8-bit pixels into 32-bit integer or float, it is the central part of
+ * all the 1x3 / 3x1 / diagonal sobel filters, returns how many are done, the rest falls back to the generic loop */
+static int _ccv_sobel_sub_8u(const unsigned char* p, const unsigned char* q, unsigned char* b, const int count, const int btype)
+{
+	int i = 0;
+#if defined(HAVE_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	if (CCV_GET_DATA_TYPE(btype) == CCV_32S)
+	{
+		int* bi = (int*)b;
+		for (; i < count - 15; i += 16)
+		{
+			__m128i p16 = _mm_loadu_si128((const __m128i*)(p + i));
+			__m128i q16 = _mm_loadu_si128((const __m128i*)(q + i));
+			__m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(p16, zero), _mm_unpacklo_epi8(q16, zero));
+			__m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(p16, zero), _mm_unpackhi_epi8(q16, zero));
+			_mm_storeu_si128((__m128i*)(bi + i), _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16));
+			_mm_storeu_si128((__m128i*)(bi + i + 4), _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16));
+			_mm_storeu_si128((__m128i*)(bi + i + 8), _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16));
+			_mm_storeu_si128((__m128i*)(bi + i + 12), _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16));
+		}
+	} else if (CCV_GET_DATA_TYPE(btype) == CCV_32F) {
+		float* bf = (float*)b;
+		for (; i < count - 15; i += 16)
+		{
+			__m128i p16 = _mm_loadu_si128((const __m128i*)(p + i));
+			__m128i q16 = _mm_loadu_si128((const __m128i*)(q + i));
+			__m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(p16, zero), _mm_unpacklo_epi8(q16, zero));
+			__m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(p16, zero), _mm_unpackhi_epi8(q16, zero));
+			_mm_storeu_ps(bf + i, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16)));
+			_mm_storeu_ps(bf + i + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16)));
+			_mm_storeu_ps(bf + i + 8, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16)));
+			_mm_storeu_ps(bf + i + 12, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16)));
+		}
+	}
+#elif defined(HAVE_NEON)
+	if (CCV_GET_DATA_TYPE(btype) == CCV_32S)
+	{
+		int* bi = (int*)b;
+		for (; i < count - 7; i += 8)
+		{
+			int16x8_t d = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(p + i), vld1_u8(q + i)));
+			vst1q_s32(bi + i, vmovl_s16(vget_low_s16(d)));
+			vst1q_s32(bi + i + 4, vmovl_s16(vget_high_s16(d)));
+		}
+	} else if (CCV_GET_DATA_TYPE(btype) == CCV_32F) {
+		float* bf = (float*)b;
+		for (; i < count - 7; i += 8)
+		{
+			int16x8_t d = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(p + i), vld1_u8(q + i)));
+			vst1q_f32(bf + i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(d))));
+			vst1q_f32(bf + i + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(d))));
+		}
+	}
+#endif
+	return i;
+}
+
 /* sobel filter is fundamental to many other high-level algorithms,
- * here includes 2 special case impl (for 1x3/3x1, 3x3) and one general impl */
+ * here includes 2 special case impl (for 1x3/3x1, 3x3) and one general impl,
+ * every one of them computes an output row out of a few input rows, thus, rows run in parallel */
 void ccv_sobel(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int dx, int dy)
 {
 	ccv_declare_derived_signature(sig, a->sig != 0, ccv_sign_with_format(64, "ccv_sobel(%d,%d)", dx, dy), a->sig, CCV_EOF_SIGN);
 	type = (type == 0) ? CCV_32S | CCV_GET_CHANNEL(a->type) : CCV_GET_DATA_TYPE(type) | CCV_GET_CHANNEL(a->type);
 	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, a->rows, a->cols, CCV_GET_CHANNEL(a->type) | CCV_ALL_DATA_TYPE, type, sig);
 	ccv_object_return_if_cached(, db);
-	int i, j, k, c, ch = CCV_GET_CHANNEL(a->type);
-	unsigned char* a_ptr = a->data.u8;
-	unsigned char* b_ptr = db->data.u8;
+	int i, ch = CCV_GET_CHANNEL(a->type);
+	const int count = a->cols * ch;
+	const int bsize = CCV_GET_DATA_TYPE_SIZE(db->type);
+	const int vectorized = (CCV_GET_DATA_TYPE(a->type) == CCV_8U && (CCV_GET_DATA_TYPE(db->type) == CCV_32S || CCV_GET_DATA_TYPE(db->type) == CCV_32F));
 	if (dx == 1 && dy == 0)
 	{
 		assert(a->cols >= 3);
 		/* special case 1: 1x3 or 3x1 window */
 #define for_block(_for_get, _for_set) \
-		for (i = 0; i < a->rows; i++) \
-		{ \
+		parallel_for(i, a->rows) { \
+			int j, k; \
+			unsigned char* a_ptr = a->data.u8 + i * a->step; \
+			unsigned char* b_ptr = db->data.u8 + i * db->step; \
 			for (k = 0; k < ch; k++) \
 				_for_set(b_ptr, k, 2 * (_for_get(a_ptr, ch + k) - _for_get(a_ptr, k))); \
-			for (j = 1; j < a->cols - 1; j++) \
-				for (k = 0; k < ch; k++) \
-					_for_set(b_ptr, j * ch + k, _for_get(a_ptr, (j + 1) * ch + k) - _for_get(a_ptr, (j - 1) * ch + k)); \
+			j = vectorized ? _ccv_sobel_sub_8u(a_ptr + 2 * ch, a_ptr, b_ptr + ch * bsize, count - 2 * ch, db->type) : 0; \
+			for (j += ch; j < count - ch; j++) \
+				_for_set(b_ptr, j, _for_get(a_ptr, j + ch) - _for_get(a_ptr, j - ch)); \
 			for (k = 0; k < ch; k++) \
 				_for_set(b_ptr, (a->cols - 1) * ch + k, 2 * (_for_get(a_ptr, (a->cols - 1) * ch + k) - _for_get(a_ptr, (a->cols - 2) * ch + k))); \
-			b_ptr += db->step; \
-			a_ptr += a->step; \
-		}
+		} parallel_endfor
 		ccv_matrix_getter(a->type, ccv_matrix_setter, db->type, for_block);
 #undef for_block
 	} else if (dx == 0 && dy == 1) {
 		assert(a->rows >= 3);
 		/* special case 1: 1x3 or 3x1 window */
 #define for_block(_for_get, _for_set) \
-		for (j = 0; j < a->cols; j++) \
-			for (k = 0; k < ch; k++) \
-				_for_set(b_ptr, j * ch + k, 2 * (_for_get(a_ptr + a->step, j * ch + k) - _for_get(a_ptr, j * ch + k))); \
-		a_ptr += a->step; \
-		b_ptr += db->step; \
-		for (i = 1; i < a->rows - 1; i++) \
-		{ \
-			for (j = 0; j < a->cols; j++) \
-				for (k = 0; k < ch; k++) \
-					_for_set(b_ptr, j * ch + k, _for_get(a_ptr + a->step, j * ch + k) - _for_get(a_ptr - a->step, j * ch + k)); \
-			a_ptr += a->step; \
-			b_ptr += db->step; \
-		} \
-		for (j = 0; j < a->cols; j++) \
-			for (k = 0; k < ch; k++) \
-				_for_set(b_ptr, j * ch + k, 2 * (_for_get(a_ptr, j * ch + k) - _for_get(a_ptr - a->step, j * ch + k)));
+		parallel_for(i, a->rows) { \
+			int j; \
+			unsigned char* b_ptr = db->data.u8 + i * db->step; \
+			if (i == 0 || i == a->rows - 1) \
+			{ \
+				unsigned char* a_ptr = a->data.u8 + (i == 0 ? 0 : i - 1) * a->step; \
+				for (j = 0; j < count; j++) \
+					_for_set(b_ptr, j, 2 * (_for_get(a_ptr + a->step, j) - _for_get(a_ptr, j))); \
+			} else { \
+				unsigned char* a_ptr = a->data.u8 + i * a->step; \
+				j = vectorized ? _ccv_sobel_sub_8u(a_ptr + a->step, a_ptr - a->step, b_ptr, count, db->type) : 0; \
+				for (; j < count; j++) \
+					_for_set(b_ptr, j, _for_get(a_ptr + a->step, j) - _for_get(a_ptr - a->step, j)); \
+			} \
+		} parallel_endfor
 		ccv_matrix_getter(a->type, ccv_matrix_setter, db->type, for_block);
 #undef for_block
 	} else if ((dx == 1 && dy == 1) || (dx == -1 && dy == -1)) {
 		/* special case 2: 3x3 window with diagonal direction */
 		assert(a->rows >= 3 && a->cols >= 3);
 #define for_block(_for_get, _for_set) \
-		for (j = 0; j < a->cols - 1; j++) \
-			for (k = 0; k < ch; k++) \
-				_for_set(b_ptr, j * ch + k, 2 * (_for_get(a_ptr + a->step, (j + 1) * ch + k) - _for_get(a_ptr, j * ch + k))); \
-		for (k = 0; k < ch; k++) \
-			_for_set(b_ptr, (a->cols - 1) * ch + k, 2 * (_for_get(a_ptr + a->step, (a->cols - 1) * ch + k) - _for_get(a_ptr, (a->cols - 1) * ch + k))); \
-		a_ptr += a->step; \
-		b_ptr += db->step; \
-		for (i = 1; i < a->rows - 1; i++) \
-		{ \
-			for (k = 0; k < ch; k++) \
-				_for_set(b_ptr, k, 2 * (_for_get(a_ptr + a->step, ch + k) - _for_get(a_ptr, k))); \
-			for (j = 1; j < a->cols - 1; j++) \
+		parallel_for(i, a->rows) { \
+			int j, k; \
+			unsigned char* a_ptr = a->data.u8 + i * a->step; \
+			unsigned char* b_ptr = db->data.u8 + i * db->step; \
+			if (i == 0) \
+			{ \
+				for (j = 0; j < a->cols - 1; j++) \
+					for (k = 0; k < ch; k++) \
+						_for_set(b_ptr, j * ch + k, 2 * (_for_get(a_ptr + a->step, (j + 1) * ch + k) - _for_get(a_ptr, j * ch + k))); \
 				for (k = 0; k < ch; k++) \
-					_for_set(b_ptr, j * ch + k, _for_get(a_ptr + a->step, (j + 1) * ch + k) - _for_get(a_ptr - a->step, (j - 1) * ch + k)); \
-			for (k = 0; k < ch; k++) \
-				_for_set(b_ptr, (a->cols - 1) * ch + k, 2 * (_for_get(a_ptr, (a->cols - 1) * ch + k) - _for_get(a_ptr - a->step, (a->cols - 2) * ch + k))); \
-			a_ptr += a->step; \
-			b_ptr += db->step; \
-		} \
-		for (k = 0; k < ch; k++) \
-			_for_set(b_ptr, k, 2 * (_for_get(a_ptr, k) - _for_get(a_ptr - a->step, k))); \
-		for (j = 1; j < a->cols; j++) \
-			for (k = 0; k < ch; k++) \
-				_for_set(b_ptr, j * ch + k, 2 * (_for_get(a_ptr, j * ch + k) - _for_get(a_ptr - a->step, (j - 1) * ch + k)));
+					_for_set(b_ptr, (a->cols - 1) * ch + k, 2 * (_for_get(a_ptr + a->step, (a->cols - 1) * ch + k) - _for_get(a_ptr, (a->cols - 1) * ch + k))); \
+			} else if (i == a->rows - 1) { \
+				for (k = 0; k < ch; k++) \
+					_for_set(b_ptr, k, 2 * (_for_get(a_ptr, k) - _for_get(a_ptr - a->step, k))); \
+				for (j = 1; j < a->cols; j++) \
+					for (k = 0; k < ch; k++) \
+						_for_set(b_ptr, j * ch + k, 2 * (_for_get(a_ptr, j * ch + k) - _for_get(a_ptr - a->step, (j - 1) * ch + k))); \
+			} else { \
+				for (k = 0; k < ch; k++) \
+					_for_set(b_ptr, k, 2 * (_for_get(a_ptr + a->step, ch + k) - _for_get(a_ptr, k))); \
+				j = vectorized ? _ccv_sobel_sub_8u(a_ptr + a->step + 2 * ch, a_ptr - a->step, b_ptr + ch * bsize, count - 2 * ch, db->type) : 0; \
+				for (j += ch; j < count - ch; j++) \
+					_for_set(b_ptr, j, _for_get(a_ptr + a->step, j + ch) - _for_get(a_ptr - a->step, j - ch)); \
+				for (k = 0; k < ch; k++) \
+					_for_set(b_ptr, (a->cols - 1) * ch + k, 2 * (_for_get(a_ptr, (a->cols - 1) * ch + k) - _for_get(a_ptr - a->step, (a->cols - 2) * ch + k))); \
+			} \
+		} parallel_endfor
 		ccv_matrix_getter(a->type, ccv_matrix_setter, db->type, for_block);
 #undef for_block
 	} else if ((dx == 1 && dy == -1) || (dx == -1 && dy == 1)) {
 		/* special case 2: 3x3 window with diagonal direction */
 		assert(a->rows >= 3 && a->cols >= 3);
 #define for_block(_for_get, _for_set) \
-		for (k = 0; k < ch; k++) \
-			_for_set(b_ptr, k, 2 * (_for_get(a_ptr + a->step, k) - _for_get(a_ptr, k))); \
-		for (j = 1; j < a->cols; j++) \
-			for (k = 0; k < ch; k++) \
-				_for_set(b_ptr, j * ch + k, 2 * (_for_get(a_ptr + a->step, (j - 1) * ch + k) - _for_get(a_ptr, j * ch + k))); \
-		a_ptr += a->step; \
-		b_ptr += db->step; \
-		for (i = 1; i < a->rows - 1; i++) \
-		{ \
-			for (k = 0; k < ch; k++) \
-				_for_set(b_ptr, k, 2 * (_for_get(a_ptr, k) - _for_get(a_ptr - a->step, ch + k))); \
-			for (j = 1; j < a->cols - 1; j++) \
+		parallel_for(i, a->rows) { \
+			int j, k; \
+			unsigned char* a_ptr = a->data.u8 + i * a->step; \
+			unsigned char* b_ptr = db->data.u8 + i * db->step; \
+			if (i == 0) \
+			{ \
 				for (k = 0; k < ch; k++) \
-					_for_set(b_ptr, j * ch + k, _for_get(a_ptr + a->step, (j - 1) * ch + k) - _for_get(a_ptr - a->step, (j + 1) * ch + k)); \
-			for (k = 0; k < ch; k++) \
-				_for_set(b_ptr, (a->cols - 1) * ch + k, 2 * (_for_get(a_ptr + a->step, (a->cols - 2) * ch + k) - _for_get(a_ptr, (a->cols - 1) * ch + k))); \
-			a_ptr += a->step; \
-			b_ptr += db->step; \
-		} \
-		for (j = 0; j < a->cols - 1; j++) \
-			for (k = 0; k < ch; k++) \
-				_for_set(b_ptr, j * ch + k, 2 * (_for_get(a_ptr, j * ch + k) - _for_get(a_ptr - a->step, (j + 1) * ch + k))); \
-		for (k = 0; k < ch; k++) \
-			_for_set(b_ptr, (a->cols - 1) * ch + k, 2 * (_for_get(a_ptr, (a->cols - 1) * ch + k) - _for_get(a_ptr - a->step, (a->cols - 1) * ch + k)));
+					_for_set(b_ptr, k, 2 * (_for_get(a_ptr + a->step, k) - _for_get(a_ptr, k))); \
+				for (j = 1; j < a->cols; j++) \
+					for (k = 0; k < ch; k++) \
+						_for_set(b_ptr, j * ch + k, 2 * (_for_get(a_ptr + a->step, (j - 1) * ch + k) - _for_get(a_ptr, j * ch + k))); \
+			} else if (i == a->rows - 1) { \
+				for (j = 0; j < a->cols - 1; j++) \
+					for (k = 0; k < ch; k++) \
+						_for_set(b_ptr, j * ch + k, 2 * (_for_get(a_ptr, j * ch + k) - _for_get(a_ptr - a->step, (j + 1) * ch + k))); \
+				for (k = 0; k < ch; k++) \
+					_for_set(b_ptr, (a->cols - 1) * ch + k, 2 * (_for_get(a_ptr, (a->cols - 1) * ch + k) - _for_get(a_ptr - a->step, (a->cols - 1) * ch + k))); \
+			} else { \
+				for (k = 0; k < ch; k++) \
+					_for_set(b_ptr, k, 2 * (_for_get(a_ptr, k) - _for_get(a_ptr - a->step, ch + k))); \
+				j = vectorized ? _ccv_sobel_sub_8u(a_ptr + a->step, a_ptr - a->step + 2 * ch, b_ptr + ch * bsize, count - 2 * ch, db->type) : 0; \
+				for (j += ch; j < count - ch; j++) \
+					_for_set(b_ptr, j, _for_get(a_ptr + a->step, j - ch) - _for_get(a_ptr - a->step, j + ch)); \
+				for (k = 0; k < ch; k++) \
+					_for_set(b_ptr, (a->cols - 1) * ch + k, 2 * (_for_get(a_ptr + a->step, (a->cols - 2) * ch + k) - _for_get(a_ptr, (a->cols - 1) * ch + k))); \
+			} \
+		} parallel_endfor
 		ccv_matrix_getter(a->type, ccv_matrix_setter, db->type, for_block);
 #undef for_block
 	} else if (dx == 3 && dy == 0) {
 		assert(a->rows >= 3 && a->cols >= 3);
-		/* special case 3: 3x3 window, corresponding sigma = 0.85 */
-		unsigned char* buf = (unsigned char*)alloca(db->step);
+		/* special case 3: 3x3 window, corresponding sigma = 0.85, the vertical smoothing of a row goes to a buffer first */
 #define for_block(_for_get, _for_set_b, _for_get_b) \
-		for (j = 0; j < a->cols; j++) \
-			for (k = 0; k < ch; k++) \
-				_for_set_b(b_ptr, j * ch + k, _for_get(a_ptr + a->step, j * ch + k) + 3 * _for_get(a_ptr, j * ch + k)); \
-		a_ptr += a->step; \
-		b_ptr += db->step; \
-		for (i = 1; i < a->rows - 1; i++) \
-		{ \
-			for (j = 0; j < a->cols; j++) \
-				for (k = 0; k < ch; k++) \
-					_for_set_b(b_ptr, j * ch + k, _for_get(a_ptr + a->step, j * ch + k) + 2 * _for_get(a_ptr, j * ch + k) + _for_get(a_ptr - a->step, j * ch + k)); \
-			a_ptr += a->step; \
-			b_ptr += db->step; \
-		} \
-		for (j = 0; j < a->cols; j++) \
+		parallel_for(i, a->rows) { \
+			int j, k; \
+			unsigned char* a_ptr = a->data.u8 + i * a->step; \
+			unsigned char* b_ptr = db->data.u8 + i * db->step; \
+			unsigned char* buf = (unsigned char*)ccmalloc(db->step); \
+			if (i == 0) \
+				for (j = 0; j < count; j++) \
+					_for_set_b(buf, j, _for_get(a_ptr + a->step, j) + 3 * _for_get(a_ptr, j)); \
+			else if (i == a->rows - 1) \
+				for (j = 0; j < count; j++) \
+					_for_set_b(buf, j, 3 * _for_get(a_ptr, j) + _for_get(a_ptr - a->step, j)); \
+			else \
+				for (j = 0; j < count; j++) \
+					_for_set_b(buf, j, _for_get(a_ptr + a->step, j) + 2 * _for_get(a_ptr, j) + _for_get(a_ptr - a->step, j)); \
 			for (k = 0; k < ch; k++) \
-				_for_set_b(b_ptr, j * ch + k, 3 * _for_get(a_ptr, j * ch + k) + _for_get(a_ptr - a->step, j * ch + k)); \
-		b_ptr = db->data.u8; \
-		for (i = 0; i < a->rows; i++) \
-		{ \
-			for (k = 0; k < ch; k++) \
-				_for_set_b(buf, k, _for_get_b(b_ptr, ch + k) - _for_get_b(b_ptr, k)); \
-			for (j = 1; j < a->cols - 1; j++) \
-				for (k = 0; k < ch; k++) \
-					_for_set_b(buf, j * ch + k, _for_get_b(b_ptr, (j + 1) * ch + k) - _for_get_b(b_ptr, (j - 1) * ch + k)); \
+				_for_set_b(b_ptr, k, _for_get_b(buf, ch + k) - _for_get_b(buf, k)); \
+			for (j = ch; j < count - ch; j++) \
+				_for_set_b(b_ptr, j, _for_get_b(buf, j + ch) - _for_get_b(buf, j - ch)); \
 			for (k = 0; k < ch; k++) \
-				_for_set_b(buf, (a->cols - 1) * ch + k, _for_get_b(b_ptr, (a->cols - 1) * ch + k) - _for_get_b(b_ptr, (a->cols - 2) * ch + k)); \
-			memcpy(b_ptr, buf, db->step); \
-			b_ptr += db->step; \
-		}
+				_for_set_b(b_ptr, (a->cols - 1) * ch + k, _for_get_b(buf, (a->cols - 1) * ch + k) - _for_get_b(buf, (a->cols - 2) * ch + k)); \
+			ccfree(buf); \
+		} parallel_endfor
 		ccv_matrix_getter(a->type, ccv_matrix_setter_getter, db->type, for_block);
 #undef for_block
 	} else if (dx == 0 && dy == 3) {
 		assert(a->rows >= 3 && a->cols >= 3);
-		/* special case 3: 3x3 window, corresponding sigma = 0.85 */
-		unsigned char* buf = (unsigned char*)alloca(db->step);
+		/* special case 3: 3x3 window, corresponding sigma = 0.85, the vertical difference of a row goes to a buffer first */
 #define for_block(_for_get, _for_set_b, _for_get_b) \
-		for (j = 0; j < a->cols; j++) \
+		parallel_for(i, a->rows) { \
+			int j, k; \
+			unsigned char* a_ptr = a->data.u8 + i * a->step; \
+			unsigned char* b_ptr = db->data.u8 + i * db->step; \
+			unsigned char* buf = (unsigned char*)ccmalloc(db->step); \
+			if (i == 0) \
+				for (j = 0; j < count; j++) \
+					_for_set_b(buf, j, _for_get(a_ptr + a->step, j) - _for_get(a_ptr, j)); \
+			else if (i == a->rows - 1) \
+				for (j = 0; j < count; j++) \
+					_for_set_b(buf, j, _for_get(a_ptr, j) - _for_get(a_ptr - a->step, j)); \
+			else \
+				for (j = 0; j < count; j++) \
+					_for_set_b(buf, j, _for_get(a_ptr + a->step, j) - _for_get(a_ptr - a->step, j)); \
 			for (k = 0; k < ch; k++) \
-				_for_set_b(b_ptr, j * ch + k, _for_get(a_ptr + a->step, j * ch + k) - _for_get(a_ptr, j * ch + k)); \
-		a_ptr += a->step; \
-		b_ptr += db->step; \
-		for (i = 1; i < a->rows - 1; i++) \
-		{ \
-			for (j = 0; j < a->cols; j++) \
-				for (k = 0; k < ch; k++) \
-					_for_set_b(b_ptr, j * ch + k, _for_get(a_ptr + a->step, j * ch + k) - _for_get(a_ptr - a->step, j * ch + k)); \
-			a_ptr += a->step; \
-			b_ptr += db->step; \
-		} \
-		for (j = 0; j < a->cols; j++) \
-			for (k = 0; k < ch; k++) \
-				_for_set_b(b_ptr, j * ch + k, _for_get(a_ptr, j * ch + k) - _for_get(a_ptr - a->step, j * ch + k)); \
-		b_ptr = db->data.u8; \
-		for (i = 0; i < a->rows; i++) \
-		{ \
+				_for_set_b(b_ptr, k, _for_get_b(buf, ch + k) + 3 * _for_get_b(buf, k)); \
+			for (j = ch; j < count - ch; j++) \
+				_for_set_b(b_ptr, j, _for_get_b(buf, j + ch) + 2 * _for_get_b(buf, j) + _for_get_b(buf, j - ch)); \
 			for (k = 0; k < ch; k++) \
-				_for_set_b(buf, k, _for_get_b(b_ptr, ch + k) + 3 * _for_get_b(b_ptr, k)); \
-			for (j = 1; j < a->cols - 1; j++) \
-				for (k = 0; k < ch; k++) \
-					_for_set_b(buf, j * ch + k, _for_get_b(b_ptr, (j + 1) * ch + k) + 2 * _for_get_b(b_ptr, j * ch + k) + _for_get_b(b_ptr, (j - 1) * ch + k)); \
-			for (k = 0; k < ch; k++) \
-				_for_set_b(buf, (a->cols - 1) * ch + k, _for_get_b(b_ptr, (a->cols - 2) * ch + k) + 3 * _for_get_b(b_ptr, (a->cols - 1) * ch + k)); \
-			memcpy(b_ptr, buf, db->step); \
-			b_ptr += db->step; \
-		}
+				_for_set_b(b_ptr, (a->cols - 1) * ch + k, _for_get_b(buf, (a->cols - 2) * ch + k) + 3 * _for_get_b(buf, (a->cols - 1) * ch + k)); \
+			ccfree(buf); \
+		} parallel_endfor
 		ccv_matrix_getter(a->type, ccv_matrix_setter_getter, db->type, for_block);
 #undef for_block
 	} else {
@@ -228,10 +277,14 @@ void ccv_sobel(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int dx,
 			df = gf;
 			gf = tf;
 		}
-		unsigned char* buf = (unsigned char*)alloca(sizeof(double) * ch * (fsz + ccv_max(a->rows, a->cols)));
+		// the horizontal pass goes to an intermediate matrix, and the vertical pass goes row by row from there
+		ccv_dense_matrix_t* dt = ccv_dense_matrix_new(a->rows, a->cols, CCV_GET_DATA_TYPE(db->type) | CCV_GET_CHANNEL(db->type), 0, 0);
 #define for_block(_for_get, _for_type_b, _for_set_b, _for_get_b) \
-		for (i = 0; i < a->rows; i++) \
-		{ \
+		parallel_for(i, a->rows) { \
+			int j, k, c; \
+			unsigned char* a_ptr = a->data.u8 + i * a->step; \
+			unsigned char* t_ptr = dt->data.u8 + i * dt->step; \
+			unsigned char* buf = (unsigned char*)ccmalloc(sizeof(_for_type_b) * ch * (fsz + a->cols)); \
 			for (j = 0; j < hfz; j++) \
 				for (k = 0; k < ch; k++) \
 					_for_set_b(buf, j * ch + k, _for_get(a_ptr, k)); \
@@ -248,37 +301,30 @@ void ccv_sobel(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int dx,
 					_for_type_b sum = 0; \
 					for (k = 0; k < fsz; k++) \
 						sum += _for_get_b(buf, (j + k) * ch + c) * _for_get_b(df, k); \
-					_for_set_b(b_ptr, j * ch + c, sum, 8); \
+					_for_set_b(t_ptr, j * ch + c, sum, 8); \
 				} \
 			} \
-			a_ptr += a->step; \
-			b_ptr += db->step; \
-		} \
-		b_ptr = db->data.u8; \
-		for (i = 0; i < a->cols; i++) \
-		{ \
-			for (j = 0; j < hfz; j++) \
-				for (k = 0; k < ch; k++) \
-					_for_set_b(buf, j * ch + k, _for_get_b(b_ptr, i * ch + k)); \
-			for (j = 0; j < a->rows; j++) \
-				for (k = 0; k < ch; k++) \
-					_for_set_b(buf, (j + hfz) * ch + k, _for_get_b(b_ptr + j * db->step, i * ch + k)); \
-			for (j = a->rows; j < a->rows + hfz; j++) \
-				for (k = 0; k < ch; k++) \
-					_for_set_b(buf, (j + hfz) * ch + k, _for_get_b(b_ptr + (a->rows - 1) * db->step, i * ch + k)); \
-			for (j = 0; j < a->rows; j++) \
+			ccfree(buf); \
+		} parallel_endfor \
+		parallel_for(i, a->rows) { \
+			int j, k; \
+			unsigned char* b_ptr = db->data.u8 + i * db->step; \
+			_for_type_b* sum = (_for_type_b*)ccmalloc(sizeof(_for_type_b) * count); \
+			for (j = 0; j < count; j++) \
+				sum[j] = 0; \
+			for (k = 0; k < fsz; k++) \
 			{ \
-				for (c = 0; c < ch; c++) \
-				{ \
-					_for_type_b sum = 0; \
-					for (k = 0; k < fsz; k++) \
-						sum += _for_get_b(buf, (j + k) * ch + c) * _for_get_b(gf, k); \
-					_for_set_b(b_ptr + j * db->step, i * ch + c, sum, 8); \
-				} \
+				unsigned char* t_ptr = dt->data.u8 + ccv_clamp(i + k - hfz, 0, a->rows - 1) * dt->step; \
+				for (j = 0; j < count; j++) \
+					sum[j] += _for_get_b(t_ptr, j) * _for_get_b(gf, k); \
 			} \
-		}
+			for (j = 0; j < count; j++) \
+				_for_set_b(b_ptr, j, sum[j], 8); \
+			ccfree(sum); \
+		} parallel_endfor
 		ccv_matrix_getter(a->type, ccv_matrix_typeof_setter_getter, db->type, for_block);
 #undef for_block
+		ccv_matrix_free(dt);
 	}
 }
 
@@ -341,13 +387,52 @@ void ccv_gradient(ccv_dense_matrix_t* a, ccv_dense_matrix_t** theta, int ttype,
 	assert(dtheta && dm);
 	ccv_object_return_if_cached(, dtheta, dm);
 	ccv_revive_object_if_cached(dtheta, dm);
-	ccv_dense_matrix_t* tx = 0;
-	ccv_dense_matrix_t* ty = 0;
-	ccv_sobel(a, &tx, CCV_32F | ch, dx, 0);
-	ccv_sobel(a, &ty, CCV_32F | ch, 0, dy);
-	_ccv_atan2(tx->data.f32, ty->data.f32, dtheta->data.f32, dm->data.f32, ch * a->rows * a->cols);
-	ccv_matrix_free(tx);
-	ccv_matrix_free(ty);
+	const int count = a->cols * ch;
+	if (dx == 1 && dy == 1)
+	{
+		assert(a->rows >= 3 && a->cols >= 3);
+		/* the most common 1x3 / 3x1 case, computes both derivatives of a row into buffers, and
+		 * then the angle and magnitude out of them, without ever materializing the two sobel matrices */
+		const int vectorized = (CCV_GET_DATA_TYPE(a->type) == CCV_8U);
+#define for_block(_, _for_get) \
+		parallel_for(i, a->rows) { \
+			int j, k; \
+			float* tx = (float*)ccmalloc(sizeof(float) * count * 2); \
+			float* ty = tx + count; \
+			unsigned char* a_ptr = a->data.u8 + i * a->step; \
+			for (k = 0; k < ch; k++) \
+				tx[k] = 2 * (_for_get(a_ptr, ch + k) - _for_get(a_ptr, k)); \
+			j = vectorized ? _ccv_sobel_sub_8u(a_ptr + 2 * ch, a_ptr, (unsigned char*)(tx + ch), count - 2 * ch, CCV_32F) : 0; \
+			for (j += ch; j < count - ch; j++) \
+				tx[j] = _for_get(a_ptr, j + ch) - _for_get(a_ptr, j - ch); \
+			for (k = 0; k < ch; k++) \
+				tx[(a->cols - 1) * ch + k] = 2 * (_for_get(a_ptr, (a->cols - 1) * ch + k) - _for_get(a_ptr, (a->cols - 2) * ch + k)); \
+			if (i == 0 || i == a->rows - 1) \
+			{ \
+				unsigned char* p_ptr = (i == 0) ? a_ptr : a_ptr - a->step; \
+				for (j = 0; j < count; j++) \
+					ty[j] = 2 * (_for_get(p_ptr + a->step, j) - _for_get(p_ptr, j)); \
+			} else { \
+				j = vectorized ? _ccv_sobel_sub_8u(a_ptr + a->step, a_ptr - a->step, (unsigned char*)ty, count, CCV_32F) : 0; \
+				for (; j < count; j++) \
+					ty[j] = _for_get(a_ptr + a->step, j) - _for_get(a_ptr - a->step, j); \
+			} \
+			_ccv_atan2(tx, ty, (float*)(dtheta->data.u8 + i * dtheta->step), (float*)(dm->data.u8 + i * dm->step), count); \
+			ccfree(tx); \
+		} parallel_endfor
+		ccv_matrix_getter(a->type, for_block);
+#undef for_block
+	} else {
+		ccv_dense_matrix_t* tx = 0;
+		ccv_dense_matrix_t* ty = 0;
+		ccv_sobel(a, &tx, CCV_32F | ch, dx, 0);
+		ccv_sobel(a, &ty, CCV_32F | ch, 0, dy);
+		parallel_for(i, a->rows) {
+			_ccv_atan2((float*)(tx->data.u8 + i * tx->step), (float*)(ty->data.u8 + i * ty->step), (float*)(dtheta->data.u8 + i * dtheta->step), (float*)(dm->data.u8 + i * dm->step), count);
+		} parallel_endfor
+		ccv_matrix_free(tx);
+		ccv_matrix_free(ty);
+	}
 }
 
 static void _ccv_flip_y_self(ccv_dense_matrix_t* a)
@@ -415,6 +500,22 @@ void ccv_flip(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int btype, int type
 		_ccv_flip_x_self(db);
 }
 
+/* accumulates one filter tap for a row, it is the inner loop of both passes of the separable Gaussian blur */
+static void _ccv_blur_accumulate_32f(float* acc, const float* row, const float f, const int count)
+{
+	int i = 0;
+#if defined(HAVE_SSE2)
+	__m128 f4 = _mm_set1_ps(f);
+	for (; i < count - 3; i += 4)
+		_mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(row + i), f4)));
+#elif defined(HAVE_NEON)
+	for (; i < count - 3; i += 4)
+		vst1q_f32(acc + i, vmlaq_n_f32(vld1q_f32(acc + i), vld1q_f32(row + i), f));
+#endif
+	for (; i < count; i++)
+		acc[i] += row[i] * f;
+}
+
 void ccv_blur(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, double sigma)
 {
 	ccv_declare_derived_signature(sig, a->sig != 0, ccv_sign_with_format(64, "ccv_blur(%la)", sigma), a->sig, CCV_EOF_SIGN);
@@ -424,10 +525,10 @@ void ccv_blur(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, double si
 	int fsz = ccv_max(1, (int)(4.0 * sigma + 1.0 - 1e-8)) * 2 + 1;
 	int hfz = fsz / 2;
 	assert(hfz > 0);
-	unsigned char* buf = (unsigned char*)alloca(sizeof(double) * ccv_max(hfz * 2 + a->rows, (hfz * 2 + a->cols) * CCV_GET_CHANNEL(a->type)));
+	ccv_cache_cost_hint(db->sig, (uint64_t)a->rows * a->cols * CCV_GET_CHANNEL(a->type) * fsz * 2);
 	unsigned char* filter = (unsigned char*)alloca(sizeof(double) * fsz);
 	double tw = 0;
-	int i, j, k, ch = CCV_GET_CHANNEL(a->type);
+	int i, ch = CCV_GET_CHANNEL(a->type);
 	assert(fsz > 0);
 	for (i = 0; i < fsz; i++)
 		tw += ((double*)filter)[i] = exp(-((i - hfz) * (i - hfz)) / (2.0 * sigma * sigma));
@@ -442,56 +543,204 @@ void ccv_blur(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, double si
 		for (i = 0; i < fsz; i++)
 			ccv_set_value(no_8u_type, filter, i, ((double*)filter)[i] * tw, 0);
 	}
-	/* horizontal */
-	unsigned char* a_ptr = a->data.u8;
-	unsigned char* b_ptr = db->data.u8;
 	assert(ch > 0);
+	const int count = a->cols * ch;
+	const int vectorized = (CCV_GET_DATA_TYPE(no_8u_type) == CCV_32F);
+	// the horizontal pass goes to an intermediate matrix of the output type (thus, rounds the same), then the vertical pass
+	// goes row by row (rather than column by column), both passes accumulate filter taps across the whole row in turn
+	ccv_dense_matrix_t* dt = ccv_dense_matrix_new(a->rows, a->cols, CCV_GET_DATA_TYPE(db->type) | CCV_GET_CHANNEL(db->type), 0, 0);
+	/* horizontal */
 #define for_block(_for_type, _for_set_b, _for_get_b, _for_set_a, _for_get_a) \
-	for (i = 0; i < a->rows; i++) \
-	{ \
+	parallel_for(i, a->rows) { \
+		int j, k; \
+		unsigned char* a_ptr = a->data.u8 + i * a->step; \
+		unsigned char* t_ptr = dt->data.u8 + i * dt->step; \
+		unsigned char* buf = (unsigned char*)ccmalloc(sizeof(_for_type) * (count + (hfz * 2 + a->cols) * ch)); \
+		_for_type* acc = (_for_type*)buf + (hfz * 2 + a->cols) * ch; \
 		for (j = 0; j < hfz; j++) \
 			for (k = 0; k < ch; k++) \
 				_for_set_b(buf, j * ch + k, _for_get_a(a_ptr, k)); \
-		for (j = 0; j < a->cols * ch; j++) \
+		for (j = 0; j < count; j++) \
 			_for_set_b(buf, j + hfz * ch, _for_get_a(a_ptr, j)); \
 		for (j = a->cols; j < hfz + a->cols; j++) \
 			for (k = 0; k < ch; k++) \
 				_for_set_b(buf, j * ch + hfz * ch + k, _for_get_a(a_ptr, (a->cols - 1) * ch + k)); \
-		for (j = 0; j < a->cols * ch; j++) \
+		for (j = 0; j < count; j++) \
+			acc[j] = 0; \
+		for (k = 0; k < fsz; k++) \
+			if (vectorized) \
+				_ccv_blur_accumulate_32f((float*)acc, (float*)buf + k * ch, ((float*)filter)[k], count); \
+			else \
+				for (j = 0; j < count; j++) \
+					acc[j] += _for_get_b(buf, k * ch + j) * _for_get_b(filter, k); \
+		for (j = 0; j < count; j++) \
 		{ \
-			_for_type sum = 0; \
-			for (k = 0; k < fsz; k++) \
-				sum += _for_get_b(buf, k * ch + j) * _for_get_b(filter, k); \
-			_for_set_b(buf, j, sum, 8); \
+			_for_set_b(acc, j, acc[j], 8); \
+			_for_set_a(t_ptr, j, _for_get_b(acc, j)); \
 		} \
-		for (j = 0; j < a->cols * ch; j++) \
-			_for_set_a(b_ptr, j, _for_get_b(buf, j)); \
-		a_ptr += a->step; \
-		b_ptr += db->step; \
-	}
+		ccfree(buf); \
+	} parallel_endfor
 	ccv_matrix_typeof_setter_getter(no_8u_type, ccv_matrix_setter, db->type, ccv_matrix_getter, a->type, for_block);
 #undef for_block
 	/* vertical */
-	b_ptr = db->data.u8;
 #define for_block(_for_type, _for_set_b, _for_get_b, _for_set_a, _for_get_a) \
-	for (i = 0; i < a->cols * ch; i++) \
-	{ \
-		for (j = 0; j < hfz; j++) \
-			_for_set_b(buf, j, _for_get_a(b_ptr, i)); \
-		for (j = 0; j < a->rows; j++) \
-			_for_set_b(buf, j + hfz, _for_get_a(b_ptr + j * db->step, i)); \
-		for (j = a->rows; j < hfz + a->rows; j++) \
-			_for_set_b(buf, j + hfz, _for_get_a(b_ptr + (a->rows - 1) * db->step, i)); \
-		for (j = 0; j < a->rows; j++) \
+	parallel_for(i, a->rows) { \
+		int j, k; \
+		unsigned char* b_ptr = db->data.u8 + i * db->step; \
+		_for_type* acc = (_for_type*)ccmalloc(sizeof(_for_type) * count); \
+		for (j = 0; j < count; j++) \
+			acc[j] = 0; \
+		for (k = 0; k < fsz; k++) \
 		{ \
-			_for_type sum = 0; \
-			for (k = 0; k < fsz; k++) \
-				sum += _for_get_b(buf, k + j) * _for_get_b(filter, k); \
-			_for_set_b(buf, j, sum, 8); \
+			unsigned char* t_ptr = dt->data.u8 + ccv_clamp(i + k - hfz, 0, a->rows - 1) * dt->step; \
+			if (vectorized) \
+				_ccv_blur_accumulate_32f((float*)acc, (float*)t_ptr, ((float*)filter)[k], count); \
+			else \
+				for (j = 0; j < count; j++) \
+					acc[j] += _for_get_a(t_ptr, j) * _for_get_b(filter, k); \
 		} \
-		for (j = 0; j < a->rows; j++) \
-			_for_set_a(b_ptr + j * db->step, i, _for_get_b(buf, j)); \
-	}
+		for (j = 0; j < count; j++) \
+		{ \
+			_for_set_b(acc, j, acc[j], 8); \
+			_for_set_a(b_ptr, j, _for_get_b(acc, j)); \
+		} \
+		ccfree(acc); \
+	} parallel_endfor
 	ccv_matrix_typeof_setter_getter(no_8u_type, ccv_matrix_setter_getter, db->type, for_block);
 #undef for_block
+	ccv_matrix_free(dt);
+}
+
+/* recursive Gaussian filter from: Young and van Vliet, Recursive implementation of the Gaussian filter, 1995,
+ * the anti-causal pass starts with the states from: Triggs and Sdika, Boundary conditions for Young-van Vliet recursive filtering, 2006,
+ * thus, it matches replicated border on both ends */
+typedef struct {
+	float B;
+	float b[3];
+	float m[3][3];
+} ccv_blur_recursive_coeffs_t;
+
+static void _ccv_blur_recursive_coeffs(double sigma, ccv_blur_recursive_coeffs_t* coeffs)
+{
+	const double q = sigma >= 2.5 ? 0.98711 * sigma - 0.96330 : 3.97156 - 4.14554 * sqrt(1 - 0.26891 * sigma);
+	const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+	const double a1 = (2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q) / b0;
+	const double a2 = -(1.4281 * q * q + 1.26661 * q * q * q) / b0;
+	const double a3 = 0.422205 * q * q * q / b0;
+	const double B = 1 - (a1 + a2 + a3);
+	coeffs->B = B;
+	coeffs->b[0] = a1;
+	coeffs->b[1] = a2;
+	coeffs->b[2] = a3;
+	// the states are scaled by B because the input of each pass is scaled by B in our formulation
+	const double scale = B / ((1 + a1 - a2 + a3) * (1 - a1 - a2 - a3) * (1 + a2 + (a1 - a3) * a3));
+	coeffs->m[0][0] = scale * (-a3 * a1 + 1 - a3 * a3 - a2);
+	coeffs->m[0][1] = scale * (a3 + a1) * (a2 + a3 * a1);
+	coeffs->m[0][2] = scale * a3 * (a1 + a3 * a2);
+	coeffs->m[1][0] = scale * (a1 + a3 * a2);
+	coeffs->m[1][1] = -scale * (a2 - 1) * (a2 + a3 * a1);
+	coeffs->m[1][2] = -scale * a3 * (a3 * a1 + a3 * a3 + a2 - 1);
+	coeffs->m[2][0] = scale * (a3 * a1 + a2 + a1 * a1 - a2 * a2);
+	coeffs->m[2][1] = scale * (a1 * a2 + a3 * a2 * a2 - a1 * a3 * a3 - a3 * a3 * a3 - a3 * a2 + a3);
+	coeffs->m[2][2] = scale * a3 * (a1 + a3 * a2);
+}
+
+void ccv_blur_recursive(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, double sigma)
+{
+	assert(sigma >= 0.5);
+	ccv_declare_derived_signature(sig, a->sig != 0, ccv_sign_with_format(64, "ccv_blur_recursive(%la)", sigma), a->sig, CCV_EOF_SIGN);
+	type = (type == 0) ? CCV_GET_DATA_TYPE(a->type) | CCV_GET_CHANNEL(a->type) : CCV_GET_DATA_TYPE(type) | CCV_GET_CHANNEL(a->type);
+	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, a->rows, a->cols, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), type, sig);
+	ccv_object_return_if_cached(, db);
+	const int ch = CCV_GET_CHANNEL(a->type);
+	const int count = a->cols * ch;
+	ccv_cache_cost_hint(db->sig, (uint64_t)a->rows * count * 16);
+	ccv_blur_recursive_coeffs_t coeffs;
+	_ccv_blur_recursive_coeffs(sigma, &coeffs);
+	const float B = coeffs.B, b1 = coeffs.b[0], b2 = coeffs.b[1], b3 = coeffs.b[2];
+	ccv_dense_matrix_t* dt = ccv_dense_matrix_new(a->rows, a->cols, CCV_32F | ch, 0, 0);
+	/* horizontal, causal and then anti-causal pass on each row */
+#define for_block(_, _for_get) \
+	parallel_for(i, a->rows) { \
+		int j, k; \
+		unsigned char* a_ptr = a->data.u8 + i * a->step; \
+		float* t_ptr = (float*)(dt->data.u8 + i * dt->step); \
+		for (k = 0; k < ch; k++) \
+		{ \
+			float w1, w2, w3; \
+			w1 = w2 = w3 = _for_get(a_ptr, k); \
+			for (j = k; j < count; j += ch) \
+			{ \
+				const float w = B * _for_get(a_ptr, j) + b1 * w1 + b2 * w2 + b3 * w3; \
+				t_ptr[j] = w; \
+				w3 = w2, w2 = w1, w1 = w; \
+			} \
+			const float u = _for_get(a_ptr, count - ch + k); \
+			w1 -= u, w2 -= u, w3 -= u; \
+			const float y1 = u + coeffs.m[0][0] * w1 + coeffs.m[0][1] * w2 + coeffs.m[0][2] * w3; \
+			const float y2 = u + coeffs.m[1][0] * w1 + coeffs.m[1][1] * w2 + coeffs.m[1][2] * w3; \
+			const float y3 = u + coeffs.m[2][0] * w1 + coeffs.m[2][1] * w2 + coeffs.m[2][2] * w3; \
+			w1 = y1, w2 = y2, w3 = y3; \
+			for (j = count - ch + k; j >= 0; j -= ch) \
+			{ \
+				const float w = B * t_ptr[j] + b1 * w1 + b2 * w2 + b3 * w3; \
+				t_ptr[j] = w; \
+				w3 = w2, w2 = w1, w1 = w; \
+			} \
+		} \
+	} parallel_endfor
+	ccv_matrix_getter(a->type, for_block);
+#undef for_block
+	/* vertical, runs the same recursion down and then up the rows, on a band of columns at a time */
+	const int bands = (count + 255) / 256;
+	parallel_for(t, bands) {
+		int i, j;
+		const int j0 = t * 256, j1 = ccv_min(j0 + 256, count);
+		float* t_ptr = (float*)dt->data.u8 + j0;
+		const int t_step = dt->step / sizeof(float);
+		float y[3][256];
+		float* u = t_ptr + (a->rows - 1) * t_step;
+		for (j = 0; j < j1 - j0; j++)
+			y[0][j] = u[j];
+		float* w1 = t_ptr;
+		float* w2 = w1;
+		float* w3 = w1;
+		for (i = 0; i < a->rows; i++)
+		{
+			float* w = t_ptr + i * t_step;
+			for (j = 0; j < j1 - j0; j++)
+				w[j] = B * w[j] + b1 * w1[j] + b2 * w2[j] + b3 * w3[j];
+			w3 = w2, w2 = w1, w1 = w;
+		}
+		for (j = 0; j < j1 - j0; j++)
+		{
+			const float uj = y[0][j];
+			const float v1 = w1[j] - uj, v2 = w2[j] - uj, v3 = w3[j] - uj;
+			y[0][j] = uj + coeffs.m[0][0] * v1 + coeffs.m[0][1] * v2 + coeffs.m[0][2] * v3;
+			y[1][j] = uj + coeffs.m[1][0] * v1 + coeffs.m[1][1] * v2 + coeffs.m[1][2] * v3;
+			y[2][j] = uj + coeffs.m[2][0] * v1 + coeffs.m[2][1] * v2 + coeffs.m[2][2] * v3;
+		}
+		w1 = y[0], w2 = y[1], w3 = y[2];
+		for (i = a->rows - 1; i >= 0; i--)
+		{
+			float* w = t_ptr + i * t_step;
+			for (j = 0; j < j1 - j0; j++)
+				w[j] = B * w[j] + b1 * w1[j] + b2 * w2[j] + b3 * w3[j];
+			w3 = w2, w2 = w1, w1 = w;
+		}
+	} parallel_endfor
+	unsigned char* t_ptr = dt->data.u8;
+	unsigned char* b_ptr = db->data.u8;
+	int i, j;
+#define for_block(_, _for_set) \
+	for (i = 0; i < a->rows; i++) \
+	{ \
+		for (j = 0; j < count; j++) \
+			_for_set(b_ptr, j, ((float*)t_ptr)[j], 0); \
+		t_ptr += dt->step; \
+		b_ptr += db->step; \
+	}
+	ccv_matrix_setter(db->type, for_block);
+#undef for_block
+	ccv_matrix_free(dt);
 }
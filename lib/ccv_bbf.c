@@ -8,6 +8,11 @@
 #ifdef USE_OPENMP
 #include <omp.h>
 #endif
+#if defined(HAVE_SSE2)
+#include <emmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
 
 const ccv_bbf_param_t ccv_bbf_default_params = {
 	.interval = 5,
@@ -1188,8 +1193,272 @@ static int _ccv_is_equal_same_class(const void* _r1, const void* _r2, void* data
 		   (int)(r2->rect.width * 1.5 + 0.5) >= r1->rect.width;
 }
 
-ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_cascade_t** _cascade, int count, ccv_bbf_param_t params)
+/* r2 has to be within distance of r1 to be equal, and vice versa */
+static ccv_rect_t _ccv_is_equal_bound(const void* _r, void* data)
+{
+	const ccv_comp_t* r = (const ccv_comp_t*)_r;
+	int distance = (int)(r->rect.width * 0.25 + 0.5);
+	return ccv_rect(r->rect.x - distance, r->rect.y - distance, distance * 2 + 1, distance * 2 + 1);
+}
+
+#define CCV_BBF_BAND_ROWS (8)
+
+typedef struct {
+	int scale;
+	int q;
+	int y;
+	int rows;
+} ccv_bbf_band_t;
+
+/* run the cascade from the stage start, the confidence is the sum of the last stage */
+static inline int _ccv_bbf_run_cascade(ccv_bbf_classifier_cascade_t* cascade, int* steps, unsigned char** u8, const int start, float* confidence)
 {
+	int j, k;
+	float sum = *confidence;
+	ccv_bbf_stage_classifier_t* classifier = cascade->stage_classifier + start;
+	for (j = start; j < cascade->count; ++j, ++classifier)
+	{
+		sum = 0;
+		float* alpha = classifier->alpha;
+		ccv_bbf_feature_t* feature = classifier->feature;
+		for (k = 0; k < classifier->count; ++k, alpha += 2, ++feature)
+			sum += alpha[_ccv_run_bbf_feature(feature, steps, u8)];
+		if (sum < classifier->threshold)
+			return 0;
+	}
+	*confidence = sum;
+	return 1;
+}
+
+#if defined(HAVE_SSE2) || defined(HAVE_NEON)
+
+#define CCV_BBF_WINDOWS (16)
+/* when fewer windows than this are alive, the rest of the cascade is run on each of them, the vectorized
+ * evaluation is still cheaper than the scalar one on 2 windows */
+#define CCV_BBF_MIN_ALIVE_WINDOWS (2)
+
+/* the pixel of a point on 16 horizontally adjacent windows, on the 4x, 2x and 1x image, the windows are 4, 2 and 1
+ * pixel apart respectively. Loads end at the pixel of the last window (thus, don't read past the image) except at
+ * the very beginning of the image, where they start at the pixel of the first window instead */
+#if defined(HAVE_SSE2)
+static inline __m128i _ccv_bbf_gather(const unsigned char* p, const unsigned char* start, const int z)
+{
+	if (z == 0)
+	{
+		__m128i v0, v1, v2, v3;
+		if (p - 3 >= start)
+		{
+			p -= 3;
+			v0 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)p), 24);
+			v1 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(p + 16)), 24);
+			v2 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(p + 32)), 24);
+			v3 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(p + 48)), 24);
+		} else {
+			const __m128i mask = _mm_set1_epi32(0xff);
+			v0 = _mm_and_si128(_mm_loadu_si128((const __m128i*)p), mask);
+			v1 = _mm_and_si128(_mm_loadu_si128((const __m128i*)(p + 16)), mask);
+			v2 = _mm_and_si128(_mm_loadu_si128((const __m128i*)(p + 32)), mask);
+			v3 = _mm_and_si128(_mm_loadu_si128((const __m128i*)(p + 48)), mask);
+		}
+		return _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3));
+	} else if (z == 1) {
+		__m128i v0, v1;
+		if (p - 1 >= start)
+		{
+			p -= 1;
+			v0 = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)p), 8);
+			v1 = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(p + 16)), 8);
+		} else {
+			const __m128i mask = _mm_set1_epi16(0xff);
+			v0 = _mm_and_si128(_mm_loadu_si128((const __m128i*)p), mask);
+			v1 = _mm_and_si128(_mm_loadu_si128((const __m128i*)(p + 16)), mask);
+		}
+		return _mm_packus_epi16(v0, v1);
+	}
+	return _mm_loadu_si128((const __m128i*)p);
+}
+#else
+static inline uint8x16_t _ccv_bbf_gather(const unsigned char* p, const unsigned char* start, const int z)
+{
+	if (z == 0)
+		return (p - 3 >= start) ? vld4q_u8(p - 3).val[3] : vld4q_u8(p).val[0];
+	else if (z == 1)
+		return (p - 1 >= start) ? vld2q_u8(p - 1).val[1] : vld2q_u8(p).val[0];
+	return vld1q_u8(p);
+}
+#endif
+
+/* run the cascade on 16 horizontally adjacent windows at once, with a mask of the alive windows. Each window takes
+ * the same additions in the same order as _ccv_bbf_run_cascade, thus, gets the same confidence. Returns the mask of
+ * windows that pass the cascade */
+static int _ccv_bbf_run_cascade_windows(ccv_bbf_classifier_cascade_t* cascade, int* steps, unsigned char** u8, unsigned char** start, float* sums)
+{
+	int i, j, k, l;
+	int alive = (1 << CCV_BBF_WINDOWS) - 1;
+	ccv_bbf_stage_classifier_t* classifier = cascade->stage_classifier;
+#define pf_at(i) _ccv_bbf_gather(u8[feature->pz[i]] + feature->px[i] + feature->py[i] * steps[feature->pz[i]], start[feature->pz[i]], feature->pz[i])
+#define nf_at(i) _ccv_bbf_gather(u8[feature->nz[i]] + feature->nx[i] + feature->ny[i] * steps[feature->nz[i]], start[feature->nz[i]], feature->nz[i])
+	for (j = 0; j < cascade->count; ++j, ++classifier)
+	{
+		float* alpha = classifier->alpha;
+		ccv_bbf_feature_t* feature = classifier->feature;
+#if defined(HAVE_SSE2)
+		__m128 sum[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+		for (k = 0; k < classifier->count; ++k, alpha += 2, ++feature)
+		{
+			__m128i pmin = pf_at(0), nmax = nf_at(0);
+			for (i = 1; i < feature->size; i++)
+			{
+				if (feature->pz[i] >= 0)
+					pmin = _mm_min_epu8(pmin, pf_at(i));
+				if (feature->nz[i] >= 0)
+					nmax = _mm_max_epu8(nmax, nf_at(i));
+			}
+			// every point in P > every point in N, otherwise, the window takes alpha[0]
+			__m128i fail = _mm_cmpeq_epi8(_mm_max_epu8(pmin, nmax), nmax);
+			__m128i f16[] = { _mm_unpacklo_epi8(fail, fail), _mm_unpackhi_epi8(fail, fail) };
+			__m128 a0 = _mm_set1_ps(alpha[0]);
+			__m128 a1 = _mm_set1_ps(alpha[1]);
+			for (l = 0; l < 4; l++)
+			{
+				__m128 m = _mm_castsi128_ps((l & 1) ? _mm_unpackhi_epi16(f16[l >> 1], f16[l >> 1]) : _mm_unpacklo_epi16(f16[l >> 1], f16[l >> 1]));
+				sum[l] = _mm_add_ps(sum[l], _mm_or_ps(_mm_and_ps(m, a0), _mm_andnot_ps(m, a1)));
+			}
+		}
+		__m128 threshold = _mm_set1_ps(classifier->threshold);
+		int pass = 0;
+		for (l = 0; l < 4; l++)
+		{
+			pass |= _mm_movemask_ps(_mm_cmpge_ps(sum[l], threshold)) << (l * 4);
+			_mm_storeu_ps(sums + l * 4, sum[l]);
+		}
+#else
+		float32x4_t sum[4] = { vdupq_n_f32(0), vdupq_n_f32(0), vdupq_n_f32(0), vdupq_n_f32(0) };
+		for (k = 0; k < classifier->count; ++k, alpha += 2, ++feature)
+		{
+			uint8x16_t pmin = pf_at(0), nmax = nf_at(0);
+			for (i = 1; i < feature->size; i++)
+			{
+				if (feature->pz[i] >= 0)
+					pmin = vminq_u8(pmin, pf_at(i));
+				if (feature->nz[i] >= 0)
+					nmax = vmaxq_u8(nmax, nf_at(i));
+			}
+			// every point in P > every point in N, then the window takes alpha[1]
+			int8x16_t succ = vreinterpretq_s8_u8(vcgtq_u8(pmin, nmax));
+			int16x8_t s16[] = { vmovl_s8(vget_low_s8(succ)), vmovl_s8(vget_high_s8(succ)) };
+			float32x4_t a0 = vdupq_n_f32(alpha[0]);
+			float32x4_t a1 = vdupq_n_f32(alpha[1]);
+			for (l = 0; l < 4; l++)
+			{
+				uint32x4_t m = vreinterpretq_u32_s32((l & 1) ? vmovl_s16(vget_high_s16(s16[l >> 1])) : vmovl_s16(vget_low_s16(s16[l >> 1])));
+				sum[l] = vaddq_f32(sum[l], vbslq_f32(m, a1, a0));
+			}
+		}
+		float32x4_t threshold = vdupq_n_f32(classifier->threshold);
+		int pass = 0;
+		for (l = 0; l < 4; l++)
+		{
+			uint32_t m[4];
+			vst1q_u32(m, vcgeq_f32(sum[l], threshold));
+			pass |= ((m[0] & 1) | (m[1] & 2) | (m[2] & 4) | (m[3] & 8)) << (l * 4);
+			vst1q_f32(sums + l * 4, sum[l]);
+		}
+#endif
+		alive &= pass;
+		if (!alive)
+			return 0;
+		if (__builtin_popcount(alive) < CCV_BBF_MIN_ALIVE_WINDOWS)
+		{
+			for (l = 0; l < CCV_BBF_WINDOWS; l++)
+				if (alive & (1 << l))
+				{
+					unsigned char* u8l[] = { u8[0] + l * 4, u8[1] + l * 2, u8[2] + l };
+					if (!_ccv_bbf_run_cascade(cascade, steps, u8l, j + 1, sums + l))
+						alive &= ~(1 << l);
+				}
+			return alive;
+		}
+	}
+#undef pf_at
+#undef nf_at
+	return alive;
+}
+
+#endif
+
+/* scan rows [y, y + rows) of one scale with spatial variation q, pyr holds the image at 4x, 2x and 1x of the scanning grid */
+static void _ccv_bbf_detect_band(ccv_bbf_classifier_cascade_t* cascade, ccv_dense_matrix_t** pyr, const int q, const int y_start, const int rows, const int id, const float scale_x, const float scale_y, ccv_array_t** seq)
+{
+	const int dx[] = {0, 1, 0, 1};
+	const int dy[] = {0, 0, 1, 1};
+	int i_cols = pyr[2]->cols - (cascade->size.width >> 2);
+	int steps[] = { pyr[0]->step, pyr[1]->step, pyr[2]->step };
+	unsigned char* u8[] = {
+		pyr[0]->data.u8 + dx[q] * 2 + dy[q] * pyr[0]->step * 2 + y_start * pyr[0]->step * 4,
+		pyr[1]->data.u8 + dx[q] + dy[q] * pyr[1]->step + y_start * pyr[1]->step * 2,
+		pyr[2]->data.u8 + y_start * pyr[2]->step
+	};
+	int paddings[] = { pyr[0]->step * 4 - i_cols * 4,
+					   pyr[1]->step * 2 - i_cols * 2,
+					   pyr[2]->step - i_cols };
+	int x, y;
+#if defined(HAVE_SSE2) || defined(HAVE_NEON)
+	unsigned char* start[] = { pyr[0]->data.u8, pyr[1]->data.u8, pyr[2]->data.u8 };
+	float sums[CCV_BBF_WINDOWS];
+	int l;
+#endif
+	for (y = y_start; y < y_start + rows; y++)
+	{
+		x = 0;
+#if defined(HAVE_SSE2) || defined(HAVE_NEON)
+		for (; x < i_cols - (CCV_BBF_WINDOWS - 1); x += CCV_BBF_WINDOWS)
+		{
+			int alive = _ccv_bbf_run_cascade_windows(cascade, steps, u8, start, sums);
+			for (l = 0; alive; l++, alive >>= 1)
+				if (alive & 1)
+				{
+					ccv_comp_t comp;
+					comp.rect = ccv_rect((int)(((x + l) * 4 + dx[q] * 2) * scale_x + 0.5), (int)((y * 4 + dy[q] * 2) * scale_y + 0.5), (int)(cascade->size.width * scale_x + 0.5), (int)(cascade->size.height * scale_y + 0.5));
+					comp.neighbors = 1;
+					comp.classification.id = id;
+					comp.classification.confidence = sums[l];
+					if (!*seq)
+						*seq = ccv_array_new(sizeof(ccv_comp_t), 16, 0);
+					ccv_array_push(*seq, &comp);
+				}
+			u8[0] += 4 * CCV_BBF_WINDOWS;
+			u8[1] += 2 * CCV_BBF_WINDOWS;
+			u8[2] += CCV_BBF_WINDOWS;
+		}
+#endif
+		for (; x < i_cols; x++)
+		{
+			float sum = 0;
+			if (_ccv_bbf_run_cascade(cascade, steps, u8, 0, &sum))
+			{
+				ccv_comp_t comp;
+				comp.rect = ccv_rect((int)((x * 4 + dx[q] * 2) * scale_x + 0.5), (int)((y * 4 + dy[q] * 2) * scale_y + 0.5), (int)(cascade->size.width * scale_x + 0.5), (int)(cascade->size.height * scale_y + 0.5));
+				comp.neighbors = 1;
+				comp.classification.id = id;
+				comp.classification.confidence = sum;
+				if (!*seq)
+					*seq = ccv_array_new(sizeof(ccv_comp_t), 16, 0);
+				ccv_array_push(*seq, &comp);
+			}
+			u8[0] += 4;
+			u8[1] += 2;
+			u8[2] += 1;
+		}
+		u8[0] += paddings[0];
+		u8[1] += paddings[1];
+		u8[2] += paddings[2];
+	}
+}
+
+ccv_array_t* ccv_bbf_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, ccv_bbf_classifier_cascade_t** _cascade, int count, ccv_bbf_param_t params)
+{
+	ccv_dense_matrix_t* a = pyramid->a;
 	int hr = a->rows / params.size.height;
 	int wr = a->cols / params.size.width;
 	double scale = pow(2., 1. / (params.interval + 1.));
@@ -1198,25 +1467,33 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca((scale_upto + next * 2) * 4 * sizeof(ccv_dense_matrix_t*));
 	memset(pyr, 0, (scale_upto + next * 2) * 4 * sizeof(ccv_dense_matrix_t*));
 	if (params.size.height != _cascade[0]->size.height || params.size.width != _cascade[0]->size.width)
-		ccv_resample(a, &pyr[0], 0, a->rows * _cascade[0]->size.height / params.size.height, a->cols * _cascade[0]->size.width / params.size.width, CCV_INTER_AREA);
+		pyr[0] = ccv_pyramid_resample(pyramid, a, a->rows * _cascade[0]->size.height / params.size.height, a->cols * _cascade[0]->size.width / params.size.width, CCV_INTER_AREA);
 	else
 		pyr[0] = a;
-	int i, j, k, t, x, y, q;
+	int i, j, t, y, q;
 	for (i = 1; i < ccv_min(params.interval + 1, scale_upto + next * 2); i++)
-		ccv_resample(pyr[0], &pyr[i * 4], 0, (int)(pyr[0]->rows / pow(scale, i)), (int)(pyr[0]->cols / pow(scale, i)), CCV_INTER_AREA);
+		pyr[i * 4] = ccv_pyramid_resample(pyramid, pyr[0], (int)(pyr[0]->rows / pow(scale, i)), (int)(pyr[0]->cols / pow(scale, i)), CCV_INTER_AREA);
 	for (i = next; i < scale_upto + next * 2; i++)
-		ccv_sample_down(pyr[i * 4 - next * 4], &pyr[i * 4], 0, 0, 0);
+		pyr[i * 4] = ccv_pyramid_sample_down(pyramid, pyr[i * 4 - next * 4], 0, 0);
 	if (params.accurate)
 		for (i = next * 2; i < scale_upto + next * 2; i++)
 		{
-			ccv_sample_down(pyr[i * 4 - next * 4], &pyr[i * 4 + 1], 0, 1, 0);
-			ccv_sample_down(pyr[i * 4 - next * 4], &pyr[i * 4 + 2], 0, 0, 1);
-			ccv_sample_down(pyr[i * 4 - next * 4], &pyr[i * 4 + 3], 0, 1, 1);
+			pyr[i * 4 + 1] = ccv_pyramid_sample_down(pyramid, pyr[i * 4 - next * 4], 1, 0);
+			pyr[i * 4 + 2] = ccv_pyramid_sample_down(pyramid, pyr[i * 4 - next * 4], 0, 1);
+			pyr[i * 4 + 3] = ccv_pyramid_sample_down(pyramid, pyr[i * 4 - next * 4], 1, 1);
 		}
 	ccv_array_t* idx_seq;
 	ccv_array_t* seq = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
 	ccv_array_t* seq2 = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
 	ccv_array_t* result_seq = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
+	/* every scale and spatial variation is scanned in bands of rows, bands are independent, and the detections
+	 * from each band are merged in the order of scale, spatial variation, and band, the same as a serial scan */
+	int band_count = 0;
+	for (i = 0; i < scale_upto; i++)
+		band_count += (params.accurate ? 4 : 1) * ((pyr[i * 4 + next * 8]->rows + CCV_BBF_BAND_ROWS - 1) / CCV_BBF_BAND_ROWS);
+	ccv_bbf_band_t* bands = (ccv_bbf_band_t*)ccmalloc(sizeof(ccv_bbf_band_t) * band_count + sizeof(ccv_array_t*) * band_count + sizeof(float) * ccv_max(scale_upto, 0) * 2);
+	ccv_array_t** band_seqs = (ccv_array_t**)(bands + band_count);
+	float* scale_xy = (float*)(band_seqs + band_count);
 	/* detect in multi scale */
 	for (t = 0; t < count; t++)
 	{
@@ -1224,60 +1501,38 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 		float scale_x = (float) params.size.width / (float) cascade->size.width;
 		float scale_y = (float) params.size.height / (float) cascade->size.height;
 		ccv_array_clear(seq);
+		band_count = 0;
 		for (i = 0; i < scale_upto; i++)
 		{
-			int dx[] = {0, 1, 0, 1};
-			int dy[] = {0, 0, 1, 1};
 			int i_rows = pyr[i * 4 + next * 8]->rows - (cascade->size.height >> 2);
-			int steps[] = { pyr[i * 4]->step, pyr[i * 4 + next * 4]->step, pyr[i * 4 + next * 8]->step };
-			int i_cols = pyr[i * 4 + next * 8]->cols - (cascade->size.width >> 2);
-			int paddings[] = { pyr[i * 4]->step * 4 - i_cols * 4,
-							   pyr[i * 4 + next * 4]->step * 2 - i_cols * 2,
-							   pyr[i * 4 + next * 8]->step - i_cols };
 			for (q = 0; q < (params.accurate ? 4 : 1); q++)
-			{
-				unsigned char* u8[] = { pyr[i * 4]->data.u8 + dx[q] * 2 + dy[q] * pyr[i * 4]->step * 2, pyr[i * 4 + next * 4]->data.u8 + dx[q] + dy[q] * pyr[i * 4 + next * 4]->step, pyr[i * 4 + next * 8 + q]->data.u8 };
-				for (y = 0; y < i_rows; y++)
+				for (y = 0; y < i_rows; y += CCV_BBF_BAND_ROWS)
 				{
-					for (x = 0; x < i_cols; x++)
-					{
-						float sum;
-						int flag = 1;
-						ccv_bbf_stage_classifier_t* classifier = cascade->stage_classifier;
-						for (j = 0; j < cascade->count; ++j, ++classifier)
-						{
-							sum = 0;
-							float* alpha = classifier->alpha;
-							ccv_bbf_feature_t* feature = classifier->feature;
-							for (k = 0; k < classifier->count; ++k, alpha += 2, ++feature)
-								sum += alpha[_ccv_run_bbf_feature(feature, steps, u8)];
-							if (sum < classifier->threshold)
-							{
-								flag = 0;
-								break;
-							}
-						}
-						if (flag)
-						{
-							ccv_comp_t comp;
-							comp.rect = ccv_rect((int)((x * 4 + dx[q] * 2) * scale_x + 0.5), (int)((y * 4 + dy[q] * 2) * scale_y + 0.5), (int)(cascade->size.width * scale_x + 0.5), (int)(cascade->size.height * scale_y + 0.5));
-							comp.neighbors = 1;
-							comp.classification.id = t;
-							comp.classification.confidence = sum;
-							ccv_array_push(seq, &comp);
-						}
-						u8[0] += 4;
-						u8[1] += 2;
-						u8[2] += 1;
-					}
-					u8[0] += paddings[0];
-					u8[1] += paddings[1];
-					u8[2] += paddings[2];
+					bands[band_count].scale = i;
+					bands[band_count].q = q;
+					bands[band_count].y = y;
+					bands[band_count].rows = ccv_min(CCV_BBF_BAND_ROWS, i_rows - y);
+					++band_count;
 				}
-			}
+			scale_xy[i * 2] = scale_x;
+			scale_xy[i * 2 + 1] = scale_y;
 			scale_x *= scale;
 			scale_y *= scale;
 		}
+		parallel_for(b, band_count) {
+			const int s = bands[b].scale;
+			const int bq = bands[b].q;
+			band_seqs[b] = 0;
+			ccv_dense_matrix_t* pyr_q[] = { pyr[s * 4], pyr[s * 4 + next * 4], pyr[s * 4 + next * 8 + bq] };
+			_ccv_bbf_detect_band(cascade, pyr_q, bq, bands[b].y, bands[b].rows, t, scale_xy[s * 2], scale_xy[s * 2 + 1], &band_seqs[b]);
+		} parallel_endfor
+		for (i = 0; i < band_count; i++)
+			if (band_seqs[i])
+			{
+				for (j = 0; j < band_seqs[i]->rnum; j++)
+					ccv_array_push(seq, ccv_array_get(band_seqs[i], j));
+				ccv_array_free(band_seqs[i]);
+			}
 
 		/* the following code from OpenCV's haar feature implementation */
 		if(params.min_neighbors == 0)
@@ -1291,7 +1546,7 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 			idx_seq = 0;
 			ccv_array_clear(seq2);
 			// group retrieved rectangles in order to filter out noise
-			int ncomp = ccv_array_group(seq, &idx_seq, _ccv_is_equal_same_class, 0);
+			int ncomp = ccv_array_group_with_bound(seq, &idx_seq, _ccv_is_equal_same_class, _ccv_is_equal_bound, 0);
 			ccv_comp_t* comps = (ccv_comp_t*)ccmalloc((ncomp + 1) * sizeof(ccv_comp_t));
 			memset(comps, 0, (ncomp + 1) * sizeof(ccv_comp_t));
 
@@ -1364,6 +1619,7 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 		}
 	}
 
+	ccfree(bands);
 	ccv_array_free(seq);
 	ccv_array_free(seq2);
 
@@ -1374,7 +1630,7 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 		result_seq2 = ccv_array_new(sizeof(ccv_comp_t), 64, 0);
 		idx_seq = 0;
 		// group retrieved rectangles in order to filter out noise
-		int ncomp = ccv_array_group(result_seq, &idx_seq, _ccv_is_equal, 0);
+		int ncomp = ccv_array_group_with_bound(result_seq, &idx_seq, _ccv_is_equal, _ccv_is_equal_bound, 0);
 		ccv_comp_t* comps = (ccv_comp_t*)ccmalloc((ncomp + 1) * sizeof(ccv_comp_t));
 		memset(comps, 0, (ncomp + 1) * sizeof(ccv_comp_t));
 
@@ -1404,21 +1660,17 @@ ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_ca
 		result_seq2 = result_seq;
 	}
 
-	for (i = 1; i < scale_upto + next * 2; i++)
-		ccv_matrix_free(pyr[i * 4]);
-	if (params.accurate)
-		for (i = next * 2; i < scale_upto + next * 2; i++)
-		{
-			ccv_matrix_free(pyr[i * 4 + 1]);
-			ccv_matrix_free(pyr[i * 4 + 2]);
-			ccv_matrix_free(pyr[i * 4 + 3]);
-		}
-	if (params.size.height != _cascade[0]->size.height || params.size.width != _cascade[0]->size.width)
-		ccv_matrix_free(pyr[0]);
-
 	return result_seq2;
 }
 
+ccv_array_t* ccv_bbf_detect_objects(ccv_dense_matrix_t* a, ccv_bbf_classifier_cascade_t** _cascade, int count, ccv_bbf_param_t params)
+{
+	ccv_pyramid_t* pyramid = ccv_pyramid_new(a);
+	ccv_array_t* result_seq = ccv_bbf_detect_objects_in_pyramid(pyramid, _cascade, count, params);
+	ccv_pyramid_free(pyramid);
+	return result_seq;
+}
+
 ccv_bbf_classifier_cascade_t* ccv_bbf_read_classifier_cascade(const char* directory)
 {
 	char buf[1024];
@@ -5,6 +5,10 @@
 #define CCV_GET_TERMINAL_AGE(x) (((x) >> 32) & 0x0FFFFFFF)
 #define CCV_GET_TERMINAL_SIZE(x) ((x) & 0xFFFFFFFF)
 #define CCV_SET_TERMINAL_TYPE(x, y, z) (((uint64_t)(x) << 60) | ((uint64_t)(y) << 32) | (z))
+/* the age is 28-bit, rebase all ages before it overflows */
+#define CCV_CACHE_AGE_REBASE (0x08000000)
+/* the bonus is capped such that an expensive object cannot stay in the cache forever */
+#define CCV_CACHE_MAX_BONUS (0x00100000)
 
 void ccv_cache_init(ccv_cache_t* cache, size_t up, int cache_types, ccv_cache_index_free_f ffree, ...)
 {
@@ -12,6 +16,7 @@ void ccv_cache_init(ccv_cache_t* cache, size_t up, int cache_types, ccv_cache_in
 	cache->age = 0;
 	cache->up = up;
 	cache->size = 0;
+	cache->policy = CCV_CACHE_LRU;
 	assert(cache_types > 0 && cache_types <= 16);
 	va_list arguments;
 	va_start(arguments, ffree);
@@ -21,6 +26,7 @@ void ccv_cache_init(ccv_cache_t* cache, size_t up, int cache_types, ccv_cache_in
 		cache->ffree[i] = va_arg(arguments, ccv_cache_index_free_f);
 	va_end(arguments);
 	memset(&cache->origin, 0, sizeof(ccv_cache_index_t));
+	memset(cache->stats, 0, sizeof(cache->stats));
 }
 
 static int bits_in_16bits[0x1u << 16];
@@ -142,23 +148,41 @@ static ccv_cache_index_t* _ccv_cache_seek(ccv_cache_index_t* branch, uint64_t si
 	return 0;
 }
 
+static void _ccv_cache_miss(ccv_cache_t* cache, uint8_t* type)
+{
+	// the cache cannot tell the type of an object it doesn't have, count it against the type the caller looks for
+	if (type && *type < 16)
+		++cache->stats[*type].miss;
+}
+
+static void _ccv_cache_hit(ccv_cache_t* cache, uint64_t terminal_type)
+{
+	ccv_cache_stats_t* stats = cache->stats + CCV_GET_CACHE_TYPE(terminal_type);
+	++stats->hit;
+	stats->saved += CCV_GET_TERMINAL_SIZE(terminal_type);
+}
+
 void* ccv_cache_get(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
 {
 	if (cache->rnum == 0)
+	{
+		_ccv_cache_miss(cache, type);
 		return 0;
+	}
 	ccv_cache_index_t* branch = _ccv_cache_seek(&cache->origin, sign, 0);
-	if (!branch)
-		return 0;
-	int leaf = branch->terminal.off & 0x1;
-	if (!leaf)
-		return 0;
-	if (branch->terminal.sign != sign)
+	if (!branch || !(branch->terminal.off & 0x1) || branch->terminal.sign != sign)
+	{
+		_ccv_cache_miss(cache, type);
 		return 0;
+	}
+	_ccv_cache_hit(cache, branch->terminal.type);
 	if (type)
 		*type = CCV_GET_CACHE_TYPE(branch->terminal.type);
 	return (void*)(branch->terminal.off - (branch->terminal.off & 0x3));
 }
 
+static void* _ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type, uint32_t* size);
+
 // only call this function when the cache space is delpeted
 static void _ccv_cache_lru(ccv_cache_t* cache)
 {
@@ -172,12 +196,15 @@ static void _ccv_cache_lru(ccv_cache_t* cache)
 		{
 			assert(type >= 0 && type < 16);
 			cache->ffree[type](result);
+			++cache->stats[type].evict;
 		}
 		cache->rnum = 0;
 		cache->size = 0;
 		return;
 	}
 	uint32_t min_age = branch->branch.age;
+	if (cache->policy == CCV_CACHE_GDSF && min_age > cache->age)
+		cache->age = min_age;
 	int i, j;
 	for (i = 0; i < 10; i++)
 	{
@@ -185,7 +212,11 @@ static void _ccv_cache_lru(ccv_cache_t* cache)
 		int leaf = branch->terminal.off & 0x1;
 		if (leaf)
 		{
-			ccv_cache_delete(cache, branch->terminal.sign);
+			uint8_t type = 0;
+			void* result = _ccv_cache_out(cache, branch->terminal.sign, &type, 0);
+			assert(result && type < 16);
+			cache->ffree[type](result);
+			++cache->stats[type].evict;
 			break;
 		} else {
 			ccv_cache_index_t* set = (ccv_cache_index_t*)(branch->branch.set - (branch->branch.set & 0x3));
@@ -212,11 +243,44 @@ static void _ccv_cache_depleted(ccv_cache_t* cache, size_t size)
 		_ccv_cache_lru(cache);
 }
 
+static void _ccv_cache_rebase(ccv_cache_index_t* branch, uint32_t base)
+{
+	if (branch->terminal.off & 0x1)
+	{
+		uint64_t t = branch->terminal.type;
+		branch->terminal.type = CCV_SET_TERMINAL_TYPE(CCV_GET_CACHE_TYPE(t), CCV_GET_TERMINAL_AGE(t) - base, CCV_GET_TERMINAL_SIZE(t));
+	} else {
+		int i;
+		uint32_t total = compute_bits(branch->branch.bitmap);
+		ccv_cache_index_t* set = (ccv_cache_index_t*)(branch->branch.set - (branch->branch.set & 0x3));
+		for (i = 0; i < total; i++)
+			_ccv_cache_rebase(set + i, base);
+		branch->branch.age -= base;
+	}
+}
+
+/* for LRU, the age of an object is when it is put into the cache. For GDSF, it is that plus a bonus
+ * of its recompute cost per byte, and the age of the cache inflates to the evicted one (see _ccv_cache_lru) */
+static uint32_t _ccv_cache_priority(ccv_cache_t* cache, uint32_t size, uint64_t cost)
+{
+	if (cache->policy != CCV_CACHE_GDSF || cost == 0)
+		return cache->age;
+	uint64_t bonus = (cost << 4) / ccv_max(size, 1);
+	return cache->age + (uint32_t)ccv_min(bonus, CCV_CACHE_MAX_BONUS);
+}
+
 int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uint8_t type)
+{
+	return ccv_cache_put_with_cost(cache, sign, x, size, type, 0);
+}
+
+int ccv_cache_put_with_cost(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uint8_t type, uint64_t cost)
 {
 	assert(((uint64_t)x & 0x3) == 0);
+	assert(type < 16);
 	if (size > cache->up)
 		return -1;
+	++cache->stats[type].put;
 	if (size + cache->size > cache->up)
 		_ccv_cache_depleted(cache, cache->up - size);
 	if (cache->rnum == 0)
@@ -224,12 +288,19 @@ int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uin
 		cache->age = 1;
 		cache->origin.terminal.off = (uint64_t)x | 0x1;
 		cache->origin.terminal.sign = sign;
-		cache->origin.terminal.type = CCV_SET_TERMINAL_TYPE(type, cache->age, size);
+		cache->origin.terminal.type = CCV_SET_TERMINAL_TYPE(type, _ccv_cache_priority(cache, size, cost), size);
 		cache->size = size;
 		cache->rnum = 1;
 		return 0;
 	}
+	if (cache->age >= CCV_CACHE_AGE_REBASE)
+	{
+		uint32_t base = (cache->origin.terminal.off & 0x1) ? CCV_GET_TERMINAL_AGE(cache->origin.terminal.type) : cache->origin.branch.age;
+		_ccv_cache_rebase(&cache->origin, base);
+		cache->age -= base;
+	}
 	++cache->age;
+	const uint32_t priority = _ccv_cache_priority(cache, size, cost);
 	int i, depth = -1;
 	ccv_cache_index_t* branch = _ccv_cache_seek(&cache->origin, sign, &depth);
 	if (!branch)
@@ -245,7 +316,7 @@ int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uin
 			branch->terminal.off = (uint64_t)x | 0x1;
 			uint32_t old_size = CCV_GET_TERMINAL_SIZE(branch->terminal.type);
 			cache->size = cache->size + size - old_size;
-			branch->terminal.type = CCV_SET_TERMINAL_TYPE(type, cache->age, size);
+			branch->terminal.type = CCV_SET_TERMINAL_TYPE(type, priority, size);
 			_ccv_cache_aging(&cache->origin, sign);
 			return 1;
 		} else {
@@ -280,7 +351,7 @@ int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uin
 			int u = dice < udice;
 			set[u].terminal.sign = sign;
 			set[u].terminal.off = (uint64_t)x | 0x1;
-			set[u].terminal.type = CCV_SET_TERMINAL_TYPE(type, cache->age, size);
+			set[u].terminal.type = CCV_SET_TERMINAL_TYPE(type, priority, size);
 			set[1 - u] = t;
 		}
 	} else {
@@ -296,12 +367,15 @@ int ccv_cache_put(ccv_cache_t* cache, uint64_t sign, void* x, uint32_t size, uin
 			set[i] = set[i - 1];
 		set[start].terminal.off = (uint64_t)x | 0x1;
 		set[start].terminal.sign = sign;
-		set[start].terminal.type = CCV_SET_TERMINAL_TYPE(type, cache->age, size);
+		set[start].terminal.type = CCV_SET_TERMINAL_TYPE(type, priority, size);
 		branch->branch.set = (uint64_t)set;
 		branch->branch.bitmap |= k;
 		if (total == 63)
 			branch->branch.set |= 0x2;
 	}
+	// the new object is not always the youngest, GDSF gives it a bonus, and after a switch from GDSF to LRU,
+	// objects from before can be older than it, thus, ages along the path need to be updated either way
+	_ccv_cache_aging(&cache->origin, sign);
 	cache->rnum++;
 	cache->size += size;
 	return 0;
@@ -341,7 +415,7 @@ static void _ccv_cache_cleanup_and_free(ccv_cache_index_t* branch, ccv_cache_ind
 	}
 }
 
-void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
+static void* _ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type, uint32_t* out_size)
 {
 	if (!bits_in_16bits_init)
 		precomputed_16bits();
@@ -423,13 +497,33 @@ void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
 	}
 	cache->rnum--;
 	cache->size -= size;
+	if (out_size)
+		*out_size = size;
+	return result;
+}
+
+void* ccv_cache_out(ccv_cache_t* cache, uint64_t sign, uint8_t* type)
+{
+	uint32_t size = 0;
+	uint8_t result_type = 0;
+	void* result = _ccv_cache_out(cache, sign, &result_type, &size);
+	if (!result)
+	{
+		_ccv_cache_miss(cache, type);
+		return 0;
+	}
+	ccv_cache_stats_t* stats = cache->stats + result_type;
+	++stats->hit;
+	stats->saved += size;
+	if (type)
+		*type = result_type;
 	return result;
 }
 
 int ccv_cache_delete(ccv_cache_t* cache, uint64_t sign)
 {
 	uint8_t type = 0;
-	void* result = ccv_cache_out(cache, sign, &type);
+	void* result = _ccv_cache_out(cache, sign, &type, 0);
 	if (result != 0)
 	{
 		assert(type >= 0 && type < 16);
@@ -439,6 +533,11 @@ int ccv_cache_delete(ccv_cache_t* cache, uint64_t sign)
 	return -1;
 }
 
+void ccv_cache_shrink(ccv_cache_t* cache, size_t size)
+{
+	_ccv_cache_depleted(cache, size);
+}
+
 void ccv_cache_cleanup(ccv_cache_t* cache)
 {
 	if (cache->rnum > 0)
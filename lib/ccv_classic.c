@@ -1,5 +1,115 @@
 #include "ccv.h"
 #include "ccv_internal.h"
+#if defined(HAVE_SSE2)
+#include <emmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
+
+/* orientation binning of a row of pixels for the 32F HOG: picks the strongest channel, quantizes its angle
+ * into sbin * 2 bins with the same double precision steps as the scalar code (thus, the same result),
+ * returns how many are done, the rest falls back to the generic loop */
+static int _ccv_hog_bin_32f(const float* agp, const float* mgp, const int ch, const int count, const int sbin, int* bin, float* agr0, float* agr1, float* mgv)
+{
+	int j = 0;
+#if defined(HAVE_SSE2)
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d upper = _mm_set1_pd(359.99);
+	const __m128d degree = _mm_set1_pd(360.0);
+	const __m128d nbin = _mm_set1_pd(sbin * 2);
+	const __m128d u8max = _mm_set1_pd(255.0);
+	const __m128 one = _mm_set1_ps(1);
+	for (; j < count - 3; j += 4)
+	{
+		__m128 ag4, mg4;
+		if (ch == 1)
+		{
+			ag4 = _mm_loadu_ps(agp + j);
+			mg4 = _mm_loadu_ps(mgp + j);
+		} else {
+			const float* agc = agp + j * ch;
+			const float* mgc = mgp + j * ch;
+			ag4 = _mm_setr_ps(agc[0], agc[ch], agc[ch * 2], agc[ch * 3]);
+			mg4 = _mm_setr_ps(mgc[0], mgc[ch], mgc[ch * 2], mgc[ch * 3]);
+			int k;
+			for (k = 1; k < ch; k++)
+			{
+				__m128 agk = _mm_setr_ps(agc[k], agc[ch + k], agc[ch * 2 + k], agc[ch * 3 + k]);
+				__m128 mgk = _mm_setr_ps(mgc[k], mgc[ch + k], mgc[ch * 2 + k], mgc[ch * 3 + k]);
+				__m128 gt = _mm_cmpgt_ps(mgk, mg4);
+				ag4 = _mm_or_ps(_mm_and_ps(gt, agk), _mm_andnot_ps(gt, ag4));
+				mg4 = _mm_or_ps(_mm_and_ps(gt, mgk), _mm_andnot_ps(gt, mg4));
+			}
+		}
+		__m128d lo = _mm_min_pd(_mm_max_pd(_mm_cvtps_pd(ag4), zero), upper);
+		__m128d hi = _mm_min_pd(_mm_max_pd(_mm_cvtps_pd(_mm_movehl_ps(ag4, ag4)), zero), upper);
+		__m128 r4 = _mm_movelh_ps(_mm_cvtpd_ps(_mm_mul_pd(_mm_div_pd(lo, degree), nbin)), _mm_cvtpd_ps(_mm_mul_pd(_mm_div_pd(hi, degree), nbin)));
+		__m128i b4 = _mm_cvttps_epi32(r4);
+		r4 = _mm_sub_ps(r4, _mm_cvtepi32_ps(b4));
+		_mm_storeu_si128((__m128i*)(bin + j), b4);
+		_mm_storeu_ps(agr0 + j, r4);
+		_mm_storeu_ps(agr1 + j, _mm_sub_ps(one, r4));
+		lo = _mm_div_pd(_mm_cvtps_pd(mg4), u8max);
+		hi = _mm_div_pd(_mm_cvtps_pd(_mm_movehl_ps(mg4, mg4)), u8max);
+		_mm_storeu_ps(mgv + j, _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)));
+	}
+#endif
+	return j;
+}
+
+/* block normalization of one cell for the 32F HOG against its 4 normalization factors, the accumulations
+ * keep the order of the scalar code, therefore the result is identical */
+static void _ccv_hog_normalize_32f(const float* cnp, const float* norm, float* dbp, const int sbin)
+{
+	float v[CCV_MAX_CHANNEL];
+	int i, k;
+	for (i = 0; i < 4; i++)
+	{
+		k = 0;
+#if defined(HAVE_SSE2)
+		const __m128 half = _mm_set1_ps(0.5);
+		const __m128 clip = _mm_set1_ps(0.2);
+		__m128 n4 = _mm_set1_ps(norm[i]);
+		for (; k < sbin * 2 - 3; k += 4)
+		{
+			__m128 v4 = _mm_mul_ps(half, _mm_min_ps(_mm_mul_ps(_mm_loadu_ps(cnp + k), n4), clip));
+			_mm_storeu_ps(v + k, v4);
+			_mm_storeu_ps(dbp + 4 + sbin + k, _mm_add_ps(_mm_loadu_ps(dbp + 4 + sbin + k), v4));
+		}
+#elif defined(HAVE_NEON)
+		const float32x4_t half = vdupq_n_f32(0.5);
+		const float32x4_t clip = vdupq_n_f32(0.2);
+		float32x4_t n4 = vdupq_n_f32(norm[i]);
+		for (; k < sbin * 2 - 3; k += 4)
+		{
+			float32x4_t v4 = vmulq_f32(half, vminq_f32(vmulq_f32(vld1q_f32(cnp + k), n4), clip));
+			vst1q_f32(v + k, v4);
+			vst1q_f32(dbp + 4 + sbin + k, vaddq_f32(vld1q_f32(dbp + 4 + sbin + k), v4));
+		}
+#endif
+		for (; k < sbin * 2; k++)
+		{
+			v[k] = 0.5 * ccv_min(cnp[k] * norm[i], 0.2);
+			dbp[4 + sbin + k] += v[k];
+		}
+		for (k = 0; k < sbin * 2; k++)
+			dbp[i] += v[k];
+		dbp[i] *= 0.2357;
+		k = 0;
+#if defined(HAVE_SSE2)
+		for (; k < sbin - 3; k += 4)
+			_mm_storeu_ps(dbp + 4 + k, _mm_add_ps(_mm_loadu_ps(dbp + 4 + k), _mm_mul_ps(half, _mm_min_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(cnp + k), _mm_loadu_ps(cnp + k + sbin)), n4), clip))));
+#elif defined(HAVE_NEON)
+		for (; k < sbin - 3; k += 4)
+			vst1q_f32(dbp + 4 + k, vaddq_f32(vld1q_f32(dbp + 4 + k), vmulq_f32(half, vminq_f32(vmulq_f32(vaddq_f32(vld1q_f32(cnp + k), vld1q_f32(cnp + k + sbin)), n4), clip))));
+#endif
+		for (; k < sbin; k++)
+		{
+			float u = 0.5 * ccv_min((cnp[k] + cnp[k + sbin]) * norm[i], 0.2);
+			dbp[4 + k] += u;
+		}
+	}
+}
 
 void ccv_hog(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int b_type, int sbin, int size)
 {
@@ -10,39 +120,63 @@ void ccv_hog(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int b_type, int sbin
 	ccv_declare_derived_signature(sig, a->sig != 0, ccv_sign_with_format(64, "ccv_hog(%d,%d)", sbin, size), a->sig, CCV_EOF_SIGN);
 	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, rows, cols, CCV_64F | CCV_32F | (4 + sbin * 3), b_type, sig);
 	ccv_object_return_if_cached(, db);
+	// gradient, binning and normalization, roughly 32 operations per input pixel
+	ccv_cache_cost_hint(db->sig, (uint64_t)a->rows * a->cols * CCV_GET_CHANNEL(a->type) * 32);
 	ccv_dense_matrix_t* ag = 0;
 	ccv_dense_matrix_t* mg = 0;
 	ccv_gradient(a, &ag, 0, &mg, 0, 1, 1);
-	float* agp = ag->data.f32;
-	float* mgp = mg->data.f32;
-	int i, j, k, ch = CCV_GET_CHANNEL(a->type);
+	int j, ch = CCV_GET_CHANNEL(a->type);
+	const int prows = rows * size;
+	const int pcols = cols * size;
+	const int vectorized = (CCV_GET_DATA_TYPE(db->type) == CCV_32F);
 	ccv_dense_matrix_t* cn = ccv_dense_matrix_new(rows, cols, CCV_GET_DATA_TYPE(db->type) | (sbin * 2), 0, 0);
 	ccv_dense_matrix_t* ca = ccv_dense_matrix_new(rows, cols, CCV_GET_DATA_TYPE(db->type) | CCV_C1, 0, 0);
 	ccv_zero(cn);
+	// the orientation bin, the interpolation weights between the two bins and the magnitude of each pixel,
+	// the last row holds the horizontal position of the pixel against cells (shared by every row)
+	int* bin = (int*)ccmalloc(sizeof(int) * (prows + 1) * pcols);
+	unsigned char* wt = (unsigned char*)ccmalloc(CCV_GET_DATA_TYPE_SIZE(db->type) * (prows * 3 + 2) * pcols);
 	// normalize sbin direction-sensitive and sbin * 2 insensitive over 4 normalization factor
 	// accumulating them over sbin * 2 + sbin + 4 channels
 	// TNA - truncation - normalization - accumulation
-#define TNA(_for_type, idx, a, b, c, d) \
+#define TNA(_for_type, idx) \
 	{ \
-		_for_type norm = 1.0 / sqrt(cap[a] + cap[b] + cap[c] + cap[d] + 1e-4); \
 		for (k = 0; k < sbin * 2; k++) \
 		{ \
-			_for_type v = 0.5 * ccv_min(cnp[k] * norm, 0.2); \
+			_for_type v = 0.5 * ccv_min(cnp[k] * norm[idx], 0.2); \
 			dbp[4 + sbin + k] += v; \
 			dbp[idx] += v; \
 		} \
 		dbp[idx] *= 0.2357; \
 		for (k = 0; k < sbin; k++) \
 		{ \
-			_for_type v = 0.5 * ccv_min((cnp[k] + cnp[k + sbin]) * norm, 0.2); \
+			_for_type v = 0.5 * ccv_min((cnp[k] + cnp[k + sbin]) * norm[idx], 0.2); \
 			dbp[4 + k] += v; \
 		} \
 	}
 #define for_block(_, _for_type) \
-	_for_type* cnp = (_for_type*)ccv_get_dense_matrix_cell(cn, 0, 0, 0); \
-	for (i = 0; i < rows * size; i++) \
+	int* ixp = bin + prows * pcols; \
+	_for_type* vx0 = (_for_type*)wt + prows * 3 * pcols; \
+	_for_type* vx1 = vx0 + pcols; \
+	for (j = 0; j < pcols; j++) \
 	{ \
-		for (j = 0; j < cols * size; j++) \
+		_for_type xp = ((_for_type)j + 0.5) / (_for_type)size - 0.5; \
+		ixp[j] = (int)floor(xp); \
+		assert(ixp[j] < cols); \
+		vx0[j] = xp - ixp[j]; \
+		vx1[j] = 1.0 - vx0[j]; \
+	} \
+	/* orientation binning, pixel rows are independent */ \
+	parallel_for(i, prows) { \
+		int j, k; \
+		const float* agp = ag->data.f32 + i * a->cols * ch; \
+		const float* mgp = mg->data.f32 + i * a->cols * ch; \
+		int* binp = bin + i * pcols; \
+		_for_type* agr0p = (_for_type*)wt + i * 3 * pcols; \
+		_for_type* agr1p = agr0p + pcols; \
+		_for_type* mgvp = agr1p + pcols; \
+		j = vectorized ? _ccv_hog_bin_32f(agp, mgp, ch, pcols, sbin, binp, (float*)agr0p, (float*)agr1p, (float*)mgvp) : 0; \
+		for (; j < pcols; j++) \
 		{ \
 			_for_type agv = agp[j * ch]; \
 			_for_type mgv = mgp[j * ch]; \
@@ -54,142 +188,111 @@ void ccv_hog(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int b_type, int sbin
 				} \
 			_for_type agr0 = (ccv_clamp(agv, 0, 359.99) / 360.0) * (sbin * 2); \
 			int ag0 = (int)agr0; \
-			int ag1 = (ag0 + 1 < sbin * 2) ? ag0 + 1 : 0; \
-			agr0 = agr0 - ag0; \
-			_for_type agr1 = 1.0 - agr0; \
-			mgv = mgv / 255.0; \
+			binp[j] = ag0; \
+			agr0p[j] = agr0 - ag0; \
+			agr1p[j] = 1.0 - agr0p[j]; \
+			mgvp[j] = mgv / 255.0; \
+		} \
+	} parallel_endfor \
+	ccv_matrix_free(ag); \
+	ccv_matrix_free(mg); \
+	/* each pixel splats into the (up to) 4 cells around it, a thread owns a row of cells and visits the
+	 * pixel rows touching it in the original order, thus, no locking and the sums are the same */ \
+	parallel_for(r, rows) { \
+		int i, j; \
+		_for_type* cnp = (_for_type*)ccv_get_dense_matrix_cell(cn, r, 0, 0); \
+		const int iend = ccv_min(prows, (r + 2) * size); \
+		for (i = ccv_max(0, (r - 1) * size); i < iend; i++) \
+		{ \
 			_for_type yp = ((_for_type)i + 0.5) / (_for_type)size - 0.5; \
-			_for_type xp = ((_for_type)j + 0.5) / (_for_type)size - 0.5; \
 			int iyp = (int)floor(yp); \
 			assert(iyp < rows); \
-			int ixp = (int)floor(xp); \
-			assert(ixp < cols); \
+			if (iyp != r && iyp + 1 != r) \
+				continue; \
 			_for_type vy0 = yp - iyp; \
-			_for_type vx0 = xp - ixp; \
 			_for_type vy1 = 1.0 - vy0; \
-			_for_type vx1 = 1.0 - vx0; \
-			if (ixp >= 0 && iyp >= 0) \
-			{ \
-				cnp[iyp * cn->cols * sbin * 2 + ixp * sbin * 2 + ag0] += agr1 * vx1 * vy1 * mgv; \
-				cnp[iyp * cn->cols * sbin * 2 + ixp * sbin * 2 + ag1] += agr0 * vx1 * vy1 * mgv; \
-			} \
-			if (ixp + 1 < cn->cols && iyp >= 0) \
-			{ \
-				cnp[iyp * cn->cols * sbin * 2 + (ixp + 1) * sbin * 2 + ag0] += agr1 * vx0 * vy1 * mgv; \
-				cnp[iyp * cn->cols * sbin * 2 + (ixp + 1) * sbin * 2 + ag1] += agr0 * vx0 * vy1 * mgv; \
-			} \
-			if (ixp >= 0 && iyp + 1 < cn->rows) \
-			{ \
-				cnp[(iyp + 1) * cn->cols * sbin * 2 + ixp * sbin * 2 + ag0] += agr1 * vx1 * vy0 * mgv; \
-				cnp[(iyp + 1) * cn->cols * sbin * 2 + ixp * sbin * 2 + ag1] += agr0 * vx1 * vy0 * mgv; \
-			} \
-			if (ixp + 1 < cn->cols && iyp + 1 < cn->rows) \
+			const _for_type vy = (iyp == r) ? vy1 : vy0; \
+			const int* binp = bin + i * pcols; \
+			const _for_type* agr0p = (_for_type*)wt + i * 3 * pcols; \
+			const _for_type* agr1p = agr0p + pcols; \
+			const _for_type* mgvp = agr1p + pcols; \
+			for (j = 0; j < pcols; j++) \
 			{ \
-				cnp[(iyp + 1) * cn->cols * sbin * 2 + (ixp + 1) * sbin * 2 + ag0] += agr1 * vx0 * vy0 * mgv; \
-				cnp[(iyp + 1) * cn->cols * sbin * 2 + (ixp + 1) * sbin * 2 + ag1] += agr0 * vx0 * vy0 * mgv; \
+				int ag0 = binp[j]; \
+				int ag1 = (ag0 + 1 < sbin * 2) ? ag0 + 1 : 0; \
+				if (ixp[j] >= 0) \
+				{ \
+					cnp[ixp[j] * sbin * 2 + ag0] += agr1p[j] * vx1[j] * vy * mgvp[j]; \
+					cnp[ixp[j] * sbin * 2 + ag1] += agr0p[j] * vx1[j] * vy * mgvp[j]; \
+				} \
+				if (ixp[j] + 1 < cols) \
+				{ \
+					cnp[(ixp[j] + 1) * sbin * 2 + ag0] += agr1p[j] * vx0[j] * vy * mgvp[j]; \
+					cnp[(ixp[j] + 1) * sbin * 2 + ag1] += agr0p[j] * vx0[j] * vy * mgvp[j]; \
+				} \
 			} \
 		} \
-		agp += a->cols * ch; \
-		mgp += a->cols * ch; \
-	} \
-	ccv_matrix_free(ag); \
-	ccv_matrix_free(mg); \
-	cnp = (_for_type*)ccv_get_dense_matrix_cell(cn, 0, 0, 0); \
-	_for_type* cap = (_for_type*)ccv_get_dense_matrix_cell(ca, 0, 0, 0); \
-	for (i = 0; i < rows; i++) \
-	{ \
+	} parallel_endfor \
+	parallel_for(i, rows) { \
+		int j, k; \
+		_for_type* cnp = (_for_type*)ccv_get_dense_matrix_cell(cn, i, 0, 0); \
+		_for_type* cap = (_for_type*)ccv_get_dense_matrix_cell(ca, i, 0, 0); \
 		for (j = 0; j < cols; j++) \
 		{ \
-			*cap = 0; \
+			cap[j] = 0; \
 			for (k = 0; k < sbin; k++) \
-				*cap += (cnp[k] + cnp[k + sbin]) * (cnp[k] + cnp[k + sbin]); \
+				cap[j] += (cnp[k] + cnp[k + sbin]) * (cnp[k] + cnp[k + sbin]); \
 			cnp += 2 * sbin; \
-			cap++; \
 		} \
-	} \
-	cnp = (_for_type*)ccv_get_dense_matrix_cell(cn, 0, 0, 0); \
-	cap = (_for_type*)ccv_get_dense_matrix_cell(ca, 0, 0, 0); \
+	} parallel_endfor \
 	ccv_zero(db); \
-	_for_type* dbp = (_for_type*)ccv_get_dense_matrix_cell(db, 0, 0, 0); \
-	TNA(_for_type, 0, 1, cols + 1, cols, 0); \
-	TNA(_for_type, 1, 1, 1, 0, 0); \
-	TNA(_for_type, 2, 0, cols, cols, 0); \
-	TNA(_for_type, 3, 0, 0, 0, 0); \
-	cnp += 2 * sbin; \
-	dbp += 3 * sbin + 4; \
-	cap++; \
-	for (j = 1; j < cols - 1; j++) \
-	{ \
-		TNA(_for_type, 0, 1, cols + 1, cols, 0); \
-		TNA(_for_type, 1, 1, 1, 0, 0); \
-		TNA(_for_type, 2, -1, cols - 1, cols, 0); \
-		TNA(_for_type, 3, -1, -1, 0, 0); \
-		cnp += 2 * sbin; \
-		dbp += 3 * sbin + 4; \
-		cap++; \
-	} \
-	TNA(_for_type, 0, 0, cols, cols, 0); \
-	TNA(_for_type, 1, 0, 0, 0, 0); \
-	TNA(_for_type, 2, -1, cols - 1, cols, 0); \
-	TNA(_for_type, 3, -1, -1, 0, 0); \
-	cnp += 2 * sbin; \
-	dbp += 3 * sbin + 4; \
-	cap++; \
-	for (i = 1; i < rows - 1; i++) \
-	{ \
-		TNA(_for_type, 0, 1, cols + 1, cols, 0); \
-		TNA(_for_type, 1, 1, -cols + 1, -cols, 0); \
-		TNA(_for_type, 2, 0, cols, cols, 0); \
-		TNA(_for_type, 3, 0, -cols, -cols, 0); \
-		cnp += 2 * sbin; \
-		dbp += 3 * sbin + 4; \
-		cap++; \
-		for (j = 1; j < cols - 1; j++) \
+	/* the 4 normalization factors of a cell come from the 2x2 blocks around it, clamped at the border */ \
+	parallel_for(i, rows) { \
+		int j, k; \
+		_for_type* cnp = (_for_type*)ccv_get_dense_matrix_cell(cn, i, 0, 0); \
+		_for_type* cap = (_for_type*)ccv_get_dense_matrix_cell(ca, i, 0, 0); \
+		_for_type* dbp = (_for_type*)ccv_get_dense_matrix_cell(db, i, 0, 0); \
+		const int dyp = (i + 1 < rows) ? cols : 0; \
+		const int dym = (i > 0) ? -cols : 0; \
+		for (j = 0; j < cols; j++) \
 		{ \
-			TNA(_for_type, 0, 1, cols + 1, cols, 0); \
-			TNA(_for_type, 1, 1, -cols + 1, -cols, 0); \
-			TNA(_for_type, 2, -1, cols - 1, cols, 0); \
-			TNA(_for_type, 3, -1, -cols - 1, -cols, 0); \
+			const int dxp = (j + 1 < cols) ? 1 : 0; \
+			const int dxm = (j > 0) ? -1 : 0; \
+			_for_type norm[4]; \
+			norm[0] = 1.0 / sqrt(cap[dxp] + cap[dyp + dxp] + cap[dyp] + cap[0] + 1e-4); \
+			norm[1] = 1.0 / sqrt(cap[dxp] + cap[dym + dxp] + cap[dym] + cap[0] + 1e-4); \
+			norm[2] = 1.0 / sqrt(cap[dxm] + cap[dyp + dxm] + cap[dyp] + cap[0] + 1e-4); \
+			norm[3] = 1.0 / sqrt(cap[dxm] + cap[dym + dxm] + cap[dym] + cap[0] + 1e-4); \
+			if (vectorized) \
+				_ccv_hog_normalize_32f((float*)cnp, (float*)norm, (float*)dbp, sbin); \
+			else { \
+				TNA(_for_type, 0); \
+				TNA(_for_type, 1); \
+				TNA(_for_type, 2); \
+				TNA(_for_type, 3); \
+			} \
 			cnp += 2 * sbin; \
 			dbp += 3 * sbin + 4; \
 			cap++; \
 		} \
-		TNA(_for_type, 0, 0, cols, cols, 0); \
-		TNA(_for_type, 1, 0, -cols, -cols, 0); \
-		TNA(_for_type, 2, -1, cols - 1, cols, 0); \
-		TNA(_for_type, 3, -1, -cols - 1, -cols, 0); \
-		cnp += 2 * sbin; \
-		dbp += 3 * sbin + 4; \
-		cap++; \
-	} \
-	TNA(_for_type, 0, 1, 1, 0, 0); \
-	TNA(_for_type, 1, 1, -cols + 1, -cols, 0); \
-	TNA(_for_type, 2, 0, 0, 0, 0); \
-	TNA(_for_type, 3, 0, -cols, -cols, 0); \
-	cnp += 2 * sbin; \
-	dbp += 3 * sbin + 4; \
-	cap++; \
-	for (j = 1; j < cols - 1; j++) \
-	{ \
-		TNA(_for_type, 0, 1, 1, 0, 0); \
-		TNA(_for_type, 1, 1, -cols + 1, -cols, 0); \
-		TNA(_for_type, 2, -1, -1, 0, 0); \
-		TNA(_for_type, 3, -1, -cols - 1, -cols, 0); \
-		cnp += 2 * sbin; \
-		dbp += 3 * sbin + 4; \
-		cap++; \
-	} \
-	TNA(_for_type, 0, 0, 0, 0, 0); \
-	TNA(_for_type, 1, 0, -cols, -cols, 0); \
-	TNA(_for_type, 2, -1, -1, 0, 0); \
-	TNA(_for_type, 3, -1, -cols - 1, -cols, 0);
+	} parallel_endfor
 	ccv_matrix_typeof(db->type, for_block);
 #undef for_block
 #undef TNA
+	ccfree(bin);
+	ccfree(wt);
 	ccv_matrix_free(cn);
 	ccv_matrix_free(ca);
 }
 
+void ccv_hog_pyramid(ccv_dense_matrix_t** a, ccv_dense_matrix_t** b, int count, int b_type, int sbin, int size)
+{
+	// levels are independent, when running in parallel, each level is computed by one thread
+	parallel_for(i, count) {
+		ccv_hog(a[i], b + i, b_type, sbin, size);
+	} parallel_endfor
+}
+
 /* it is a supposely cleaner and faster implementation than original OpenCV (ccv_canny_deprecated,
  * removed, since the newer implementation achieve bit accuracy with OpenCV's), after a lot
  * profiling, the current implementation still uses integer to speed up */
@@ -433,43 +536,308 @@ int ccv_otsu(ccv_dense_matrix_t* a, double* outvar, int range)
 #define LK_MAX_ITER (30)
 #define LK_EPSILON (0.01)
 
-/* this code is a rewrite from OpenCV's legendary Lucas-Kanade optical flow implementation */
-void ccv_optical_flow_lucas_kanade(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_array_t* point_a, ccv_array_t** point_b, ccv_size_t win_size, int level, double min_eigen)
+static int _ccv_optical_flow_pyramid_level(ccv_dense_matrix_t* a, ccv_size_t win_size, int level)
+{
+	return ccv_clamp(level + 1, 1, (int)(log((double)ccv_min(a->rows, a->cols) / ccv_max(win_size.width * 2, win_size.height * 2)) / log(2.0) + 0.5));
+}
+
+/* the frame itself is not touched, only the downsampled levels and the gradients are generated here */
+static void _ccv_optical_flow_pyramid_build(ccv_optical_flow_pyramid_t* pyramid)
+{
+	int i;
+	for (i = 1; i < pyramid->level; i++)
+	{
+		pyramid->pyr[i] = 0;
+		ccv_sample_down(pyramid->pyr[i - 1], &pyramid->pyr[i], 0, 0, 0);
+	}
+	for (i = 0; i < pyramid->level; i++)
+		pyramid->dx[i] = pyramid->dy[i] = 0;
+}
+
+static void _ccv_optical_flow_pyramid_gradient(ccv_optical_flow_pyramid_t* pyramid)
+{
+	// because we use 3x3 sobel, which scaled derivative up by 4
+	int i;
+	for (i = 0; i < pyramid->level; i++)
+		if (!pyramid->dx[i])
+		{
+			ccv_sobel(pyramid->pyr[i], &pyramid->dx[i], 0, 3, 0);
+			ccv_sobel(pyramid->pyr[i], &pyramid->dy[i], 0, 0, 3);
+		}
+}
+
+static void _ccv_optical_flow_pyramid_clear(ccv_optical_flow_pyramid_t* pyramid)
+{
+	int i;
+	for (i = 1; i < pyramid->level; i++)
+		ccv_matrix_free(pyramid->pyr[i]);
+	for (i = 0; i < pyramid->level; i++)
+		if (pyramid->dx[i])
+		{
+			ccv_matrix_free(pyramid->dx[i]);
+			ccv_matrix_free(pyramid->dy[i]);
+		}
+}
+
+ccv_optical_flow_pyramid_t* ccv_optical_flow_pyramid_new(ccv_dense_matrix_t* a, ccv_size_t win_size, int level)
 {
-	assert(a && b && a->rows == b->rows && a->cols == b->cols);
-	assert(CCV_GET_CHANNEL(a->type) == CCV_GET_CHANNEL(b->type) && CCV_GET_DATA_TYPE(a->type) == CCV_GET_DATA_TYPE(b->type));
 	assert(CCV_GET_CHANNEL(a->type) == 1);
 	assert(CCV_GET_DATA_TYPE(a->type) == CCV_8U);
-	assert(point_a->rnum > 0);
-	level = ccv_clamp(level + 1, 1, (int)(log((double)ccv_min(a->rows, a->cols) / ccv_max(win_size.width * 2, win_size.height * 2)) / log(2.0) + 0.5));
-	ccv_declare_derived_signature(sig, a->sig != 0 && b->sig != 0 && point_a->sig != 0, ccv_sign_with_format(128, "ccv_optical_flow_lucas_kanade(%d,%d,%d,%la)", win_size.width, win_size.height, level, min_eigen), a->sig, b->sig, point_a->sig, CCV_EOF_SIGN);
-	ccv_array_t* seq = *point_b = ccv_array_new(sizeof(ccv_decimal_point_with_status_t), point_a->rnum, sig);
-	ccv_object_return_if_cached(, seq);
-	seq->rnum = point_a->rnum;
-	ccv_dense_matrix_t** pyr_a = (ccv_dense_matrix_t**)alloca(sizeof(ccv_dense_matrix_t*) * level);
-	ccv_dense_matrix_t** pyr_a_dx = (ccv_dense_matrix_t**)alloca(sizeof(ccv_dense_matrix_t*) * level);
-	ccv_dense_matrix_t** pyr_a_dy = (ccv_dense_matrix_t**)alloca(sizeof(ccv_dense_matrix_t*) * level);
-	ccv_dense_matrix_t** pyr_b = (ccv_dense_matrix_t**)alloca(sizeof(ccv_dense_matrix_t*) * level);
-	int i, j, t, x, y;
-	/* generating image pyramid */
-	pyr_a[0] = a;
-	pyr_a_dx[0] = pyr_a_dy[0] = 0;
-	ccv_sobel(pyr_a[0], &pyr_a_dx[0], 0, 3, 0);
-	ccv_sobel(pyr_a[0], &pyr_a_dy[0], 0, 0, 3);
-	pyr_b[0] = b;
-	for (i = 1; i < level; i++)
+	level = _ccv_optical_flow_pyramid_level(a, win_size, level);
+	ccv_optical_flow_pyramid_t* pyramid = (ccv_optical_flow_pyramid_t*)ccmalloc(sizeof(ccv_optical_flow_pyramid_t) + sizeof(ccv_dense_matrix_t*) * level * 3);
+	pyramid->level = level;
+	pyramid->sig = a->sig;
+	pyramid->pyr = (ccv_dense_matrix_t**)(pyramid + 1);
+	pyramid->dx = pyramid->pyr + level;
+	pyramid->dy = pyramid->dx + level;
+	// keep a copy of the frame, thus, the pyramid doesn't depend on the frame being around
+	pyramid->pyr[0] = ccv_dense_matrix_new(a->rows, a->cols, CCV_GET_DATA_TYPE(a->type) | CCV_GET_CHANNEL(a->type), 0, 0);
+	memcpy(pyramid->pyr[0]->data.u8, a->data.u8, a->rows * a->step);
+	_ccv_optical_flow_pyramid_build(pyramid);
+	return pyramid;
+}
+
+void ccv_optical_flow_pyramid_free(ccv_optical_flow_pyramid_t* pyramid)
+{
+	_ccv_optical_flow_pyramid_clear(pyramid);
+	ccv_matrix_free(pyramid->pyr[0]);
+	ccfree(pyramid);
+}
+
+/* the window is interpolated with 14-bit weights, the intensity (scaled up by 2^7) and the gradients (the 3x3 sobel
+ * is 4x, and scaled up by 2^5) all fit into 16-bit integers. Thus, the product of a pair of them, and the sum of two
+ * such products, fits into 32-bit integer, and accumulates exactly in double. Therefore, the vectorized code and the
+ * scalar code give the same result regardless of the order of accumulation. The window is stored in rows of
+ * wstep (the width rounded up to 8), gradients beyond the width are zeroed, these don't contribute to the iteration */
+static void _ccv_optical_flow_window(const unsigned char* a_ptr, const int a_step, const int* adx_ptr, const int* ady_ptr, const int d_step, const ccv_size_t win_size, const int wstep, const int* iw, short* wi, short* widx, short* widy, double* g)
+{
+	const int W_BITS7 = 7, W_BITS9 = 9;
+	int x, y;
+	double a11 = 0, a12 = 0, a22 = 0;
+#if defined(HAVE_SSE2)
+	const __m128i z = _mm_setzero_si128();
+	const __m128i w0 = _mm_set1_epi32((iw[0] & 0xffff) | (iw[1] << 16));
+	const __m128i w1 = _mm_set1_epi32((iw[2] & 0xffff) | (iw[3] << 16));
+	const __m128i d7 = _mm_set1_epi32(1 << (W_BITS7 - 1));
+	const __m128i d9 = _mm_set1_epi32(1 << (W_BITS9 - 1));
+	const __m128i lane = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m128i width = _mm_set1_epi16(win_size.width);
+	__m128d a11v = _mm_setzero_pd(), a12v = _mm_setzero_pd(), a22v = _mm_setzero_pd();
+	for (y = 0; y < win_size.height; y++)
 	{
-		pyr_a[i] = pyr_a_dx[i] = pyr_a_dy[i] = pyr_b[i] = 0;
-		ccv_sample_down(pyr_a[i - 1], &pyr_a[i], 0, 0, 0);
-		ccv_sobel(pyr_a[i], &pyr_a_dx[i], 0, 3, 0);
-		ccv_sobel(pyr_a[i], &pyr_a_dy[i], 0, 0, 3);
-		ccv_sample_down(pyr_b[i - 1], &pyr_b[i], 0, 0, 0);
+		for (x = 0; x < win_size.width; x += 8)
+		{
+			__m128i mask = _mm_cmplt_epi16(_mm_add_epi16(_mm_set1_epi16(x), lane), width);
+			__m128i t0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(a_ptr + x)), z);
+			__m128i t1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(a_ptr + x + 1)), z);
+			__m128i t2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(a_ptr + a_step + x)), z);
+			__m128i t3 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(a_ptr + a_step + x + 1)), z);
+			__m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(t0, t1), w0), _mm_madd_epi16(_mm_unpacklo_epi16(t2, t3), w1));
+			__m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(t0, t1), w0), _mm_madd_epi16(_mm_unpackhi_epi16(t2, t3), w1));
+			_mm_storeu_si128((__m128i*)(wi + x), _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(lo, d7), W_BITS7), _mm_srai_epi32(_mm_add_epi32(hi, d7), W_BITS7)));
+			t0 = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(adx_ptr + x)), _mm_loadu_si128((const __m128i*)(adx_ptr + x + 4)));
+			t1 = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(adx_ptr + x + 1)), _mm_loadu_si128((const __m128i*)(adx_ptr + x + 5)));
+			t2 = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(adx_ptr + d_step + x)), _mm_loadu_si128((const __m128i*)(adx_ptr + d_step + x + 4)));
+			t3 = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(adx_ptr + d_step + x + 1)), _mm_loadu_si128((const __m128i*)(adx_ptr + d_step + x + 5)));
+			lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(t0, t1), w0), _mm_madd_epi16(_mm_unpacklo_epi16(t2, t3), w1));
+			hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(t0, t1), w0), _mm_madd_epi16(_mm_unpackhi_epi16(t2, t3), w1));
+			__m128i ix = _mm_and_si128(_mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(lo, d9), W_BITS9), _mm_srai_epi32(_mm_add_epi32(hi, d9), W_BITS9)), mask);
+			t0 = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(ady_ptr + x)), _mm_loadu_si128((const __m128i*)(ady_ptr + x + 4)));
+			t1 = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(ady_ptr + x + 1)), _mm_loadu_si128((const __m128i*)(ady_ptr + x + 5)));
+			t2 = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(ady_ptr + d_step + x)), _mm_loadu_si128((const __m128i*)(ady_ptr + d_step + x + 4)));
+			t3 = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(ady_ptr + d_step + x + 1)), _mm_loadu_si128((const __m128i*)(ady_ptr + d_step + x + 5)));
+			lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(t0, t1), w0), _mm_madd_epi16(_mm_unpacklo_epi16(t2, t3), w1));
+			hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(t0, t1), w0), _mm_madd_epi16(_mm_unpackhi_epi16(t2, t3), w1));
+			__m128i iy = _mm_and_si128(_mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(lo, d9), W_BITS9), _mm_srai_epi32(_mm_add_epi32(hi, d9), W_BITS9)), mask);
+			_mm_storeu_si128((__m128i*)(widx + x), ix);
+			_mm_storeu_si128((__m128i*)(widy + x), iy);
+			__m128i xx = _mm_madd_epi16(ix, ix);
+			__m128i xy = _mm_madd_epi16(ix, iy);
+			__m128i yy = _mm_madd_epi16(iy, iy);
+			a11v = _mm_add_pd(a11v, _mm_add_pd(_mm_cvtepi32_pd(xx), _mm_cvtepi32_pd(_mm_srli_si128(xx, 8))));
+			a12v = _mm_add_pd(a12v, _mm_add_pd(_mm_cvtepi32_pd(xy), _mm_cvtepi32_pd(_mm_srli_si128(xy, 8))));
+			a22v = _mm_add_pd(a22v, _mm_add_pd(_mm_cvtepi32_pd(yy), _mm_cvtepi32_pd(_mm_srli_si128(yy, 8))));
+		}
+		a_ptr += a_step;
+		adx_ptr += d_step;
+		ady_ptr += d_step;
+		wi += wstep;
+		widx += wstep;
+		widy += wstep;
 	}
-	int* wi = (int*)alloca(sizeof(int) * win_size.width * win_size.height);
-	int* widx = (int*)alloca(sizeof(int) * win_size.width * win_size.height);
-	int* widy = (int*)alloca(sizeof(int) * win_size.width * win_size.height);
+	double a4[2];
+	_mm_storeu_pd(a4, a11v);
+	a11 = a4[0] + a4[1];
+	_mm_storeu_pd(a4, a12v);
+	a12 = a4[0] + a4[1];
+	_mm_storeu_pd(a4, a22v);
+	a22 = a4[0] + a4[1];
+#elif defined(HAVE_NEON)
+	const uint16x8_t lane = { 0, 1, 2, 3, 4, 5, 6, 7 };
+	const uint16x8_t width = vdupq_n_u16(win_size.width);
+	int64x2_t a11v = vdupq_n_s64(0), a12v = vdupq_n_s64(0), a22v = vdupq_n_s64(0);
+	for (y = 0; y < win_size.height; y++)
+	{
+		for (x = 0; x < win_size.width; x += 8)
+		{
+			int16x8_t mask = vreinterpretq_s16_u16(vcltq_u16(vaddq_u16(vdupq_n_u16(x), lane), width));
+			int16x8_t t0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(a_ptr + x)));
+			int16x8_t t1 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(a_ptr + x + 1)));
+			int16x8_t t2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(a_ptr + a_step + x)));
+			int16x8_t t3 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(a_ptr + a_step + x + 1)));
+			int32x4_t lo = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(vmull_n_s16(vget_low_s16(t0), iw[0]), vget_low_s16(t1), iw[1]), vget_low_s16(t2), iw[2]), vget_low_s16(t3), iw[3]);
+			int32x4_t hi = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(vmull_n_s16(vget_high_s16(t0), iw[0]), vget_high_s16(t1), iw[1]), vget_high_s16(t2), iw[2]), vget_high_s16(t3), iw[3]);
+			vst1q_s16(wi + x, vcombine_s16(vqmovn_s32(vrshrq_n_s32(lo, W_BITS7)), vqmovn_s32(vrshrq_n_s32(hi, W_BITS7))));
+			t0 = vcombine_s16(vmovn_s32(vld1q_s32(adx_ptr + x)), vmovn_s32(vld1q_s32(adx_ptr + x + 4)));
+			t1 = vcombine_s16(vmovn_s32(vld1q_s32(adx_ptr + x + 1)), vmovn_s32(vld1q_s32(adx_ptr + x + 5)));
+			t2 = vcombine_s16(vmovn_s32(vld1q_s32(adx_ptr + d_step + x)), vmovn_s32(vld1q_s32(adx_ptr + d_step + x + 4)));
+			t3 = vcombine_s16(vmovn_s32(vld1q_s32(adx_ptr + d_step + x + 1)), vmovn_s32(vld1q_s32(adx_ptr + d_step + x + 5)));
+			lo = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(vmull_n_s16(vget_low_s16(t0), iw[0]), vget_low_s16(t1), iw[1]), vget_low_s16(t2), iw[2]), vget_low_s16(t3), iw[3]);
+			hi = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(vmull_n_s16(vget_high_s16(t0), iw[0]), vget_high_s16(t1), iw[1]), vget_high_s16(t2), iw[2]), vget_high_s16(t3), iw[3]);
+			int16x8_t ix = vandq_s16(vcombine_s16(vqmovn_s32(vrshrq_n_s32(lo, W_BITS9)), vqmovn_s32(vrshrq_n_s32(hi, W_BITS9))), mask);
+			t0 = vcombine_s16(vmovn_s32(vld1q_s32(ady_ptr + x)), vmovn_s32(vld1q_s32(ady_ptr + x + 4)));
+			t1 = vcombine_s16(vmovn_s32(vld1q_s32(ady_ptr + x + 1)), vmovn_s32(vld1q_s32(ady_ptr + x + 5)));
+			t2 = vcombine_s16(vmovn_s32(vld1q_s32(ady_ptr + d_step + x)), vmovn_s32(vld1q_s32(ady_ptr + d_step + x + 4)));
+			t3 = vcombine_s16(vmovn_s32(vld1q_s32(ady_ptr + d_step + x + 1)), vmovn_s32(vld1q_s32(ady_ptr + d_step + x + 5)));
+			lo = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(vmull_n_s16(vget_low_s16(t0), iw[0]), vget_low_s16(t1), iw[1]), vget_low_s16(t2), iw[2]), vget_low_s16(t3), iw[3]);
+			hi = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(vmull_n_s16(vget_high_s16(t0), iw[0]), vget_high_s16(t1), iw[1]), vget_high_s16(t2), iw[2]), vget_high_s16(t3), iw[3]);
+			int16x8_t iy = vandq_s16(vcombine_s16(vqmovn_s32(vrshrq_n_s32(lo, W_BITS9)), vqmovn_s32(vrshrq_n_s32(hi, W_BITS9))), mask);
+			vst1q_s16(widx + x, ix);
+			vst1q_s16(widy + x, iy);
+			a11v = vpadalq_s32(vpadalq_s32(a11v, vmull_s16(vget_low_s16(ix), vget_low_s16(ix))), vmull_s16(vget_high_s16(ix), vget_high_s16(ix)));
+			a12v = vpadalq_s32(vpadalq_s32(a12v, vmull_s16(vget_low_s16(ix), vget_low_s16(iy))), vmull_s16(vget_high_s16(ix), vget_high_s16(iy)));
+			a22v = vpadalq_s32(vpadalq_s32(a22v, vmull_s16(vget_low_s16(iy), vget_low_s16(iy))), vmull_s16(vget_high_s16(iy), vget_high_s16(iy)));
+		}
+		a_ptr += a_step;
+		adx_ptr += d_step;
+		ady_ptr += d_step;
+		wi += wstep;
+		widx += wstep;
+		widy += wstep;
+	}
+	a11 = (double)(vgetq_lane_s64(a11v, 0) + vgetq_lane_s64(a11v, 1));
+	a12 = (double)(vgetq_lane_s64(a12v, 0) + vgetq_lane_s64(a12v, 1));
+	a22 = (double)(vgetq_lane_s64(a22v, 0) + vgetq_lane_s64(a22v, 1));
+#else
+	for (y = 0; y < win_size.height; y++)
+	{
+		for (x = 0; x < win_size.width; x++)
+		{
+			wi[x] = ccv_descale(a_ptr[x] * iw[0] + a_ptr[x + 1] * iw[1] + a_ptr[x + a_step] * iw[2] + a_ptr[x + a_step + 1] * iw[3], W_BITS7);
+			widx[x] = ccv_descale(adx_ptr[x] * iw[0] + adx_ptr[x + 1] * iw[1] + adx_ptr[x + d_step] * iw[2] + adx_ptr[x + d_step + 1] * iw[3], W_BITS9);
+			widy[x] = ccv_descale(ady_ptr[x] * iw[0] + ady_ptr[x + 1] * iw[1] + ady_ptr[x + d_step] * iw[2] + ady_ptr[x + d_step + 1] * iw[3], W_BITS9);
+			a11 += widx[x] * widx[x];
+			a12 += widx[x] * widy[x];
+			a22 += widy[x] * widy[x];
+		}
+		for (; x < wstep; x++)
+			widx[x] = widy[x] = 0;
+		a_ptr += a_step;
+		adx_ptr += d_step;
+		ady_ptr += d_step;
+		wi += wstep;
+		widx += wstep;
+		widy += wstep;
+	}
+#endif
+	g[0] = a11;
+	g[1] = a12;
+	g[2] = a22;
+}
+
+/* the mismatch between the window of the next frame and the one of the first frame, weighted by the gradients */
+static void _ccv_optical_flow_mismatch(const unsigned char* b_ptr, const int b_step, const ccv_size_t win_size, const int wstep, const int* iw, const short* wi, const short* widx, const short* widy, double* m)
+{
+	const int W_BITS7 = 7;
+	int x, y;
+	double b1 = 0, b2 = 0;
+#if defined(HAVE_SSE2)
+	const __m128i z = _mm_setzero_si128();
+	const __m128i w0 = _mm_set1_epi32((iw[0] & 0xffff) | (iw[1] << 16));
+	const __m128i w1 = _mm_set1_epi32((iw[2] & 0xffff) | (iw[3] << 16));
+	const __m128i d7 = _mm_set1_epi32(1 << (W_BITS7 - 1));
+	__m128d b1v = _mm_setzero_pd(), b2v = _mm_setzero_pd();
+	for (y = 0; y < win_size.height; y++)
+	{
+		for (x = 0; x < win_size.width; x += 8)
+		{
+			__m128i t0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(b_ptr + x)), z);
+			__m128i t1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(b_ptr + x + 1)), z);
+			__m128i t2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(b_ptr + b_step + x)), z);
+			__m128i t3 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(b_ptr + b_step + x + 1)), z);
+			__m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(t0, t1), w0), _mm_madd_epi16(_mm_unpacklo_epi16(t2, t3), w1));
+			__m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(t0, t1), w0), _mm_madd_epi16(_mm_unpackhi_epi16(t2, t3), w1));
+			__m128i diff = _mm_sub_epi16(_mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(lo, d7), W_BITS7), _mm_srai_epi32(_mm_add_epi32(hi, d7), W_BITS7)), _mm_loadu_si128((const __m128i*)(wi + x)));
+			__m128i dx = _mm_madd_epi16(diff, _mm_loadu_si128((const __m128i*)(widx + x)));
+			__m128i dy = _mm_madd_epi16(diff, _mm_loadu_si128((const __m128i*)(widy + x)));
+			b1v = _mm_add_pd(b1v, _mm_add_pd(_mm_cvtepi32_pd(dx), _mm_cvtepi32_pd(_mm_srli_si128(dx, 8))));
+			b2v = _mm_add_pd(b2v, _mm_add_pd(_mm_cvtepi32_pd(dy), _mm_cvtepi32_pd(_mm_srli_si128(dy, 8))));
+		}
+		b_ptr += b_step;
+		wi += wstep;
+		widx += wstep;
+		widy += wstep;
+	}
+	double b4[2];
+	_mm_storeu_pd(b4, b1v);
+	b1 = b4[0] + b4[1];
+	_mm_storeu_pd(b4, b2v);
+	b2 = b4[0] + b4[1];
+#elif defined(HAVE_NEON)
+	int64x2_t b1v = vdupq_n_s64(0), b2v = vdupq_n_s64(0);
+	for (y = 0; y < win_size.height; y++)
+	{
+		for (x = 0; x < win_size.width; x += 8)
+		{
+			int16x8_t t0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b_ptr + x)));
+			int16x8_t t1 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b_ptr + x + 1)));
+			int16x8_t t2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b_ptr + b_step + x)));
+			int16x8_t t3 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(b_ptr + b_step + x + 1)));
+			int32x4_t lo = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(vmull_n_s16(vget_low_s16(t0), iw[0]), vget_low_s16(t1), iw[1]), vget_low_s16(t2), iw[2]), vget_low_s16(t3), iw[3]);
+			int32x4_t hi = vmlal_n_s16(vmlal_n_s16(vmlal_n_s16(vmull_n_s16(vget_high_s16(t0), iw[0]), vget_high_s16(t1), iw[1]), vget_high_s16(t2), iw[2]), vget_high_s16(t3), iw[3]);
+			int16x8_t diff = vsubq_s16(vcombine_s16(vqmovn_s32(vrshrq_n_s32(lo, W_BITS7)), vqmovn_s32(vrshrq_n_s32(hi, W_BITS7))), vld1q_s16(wi + x));
+			int16x8_t ix = vld1q_s16(widx + x);
+			int16x8_t iy = vld1q_s16(widy + x);
+			b1v = vpadalq_s32(vpadalq_s32(b1v, vmull_s16(vget_low_s16(diff), vget_low_s16(ix))), vmull_s16(vget_high_s16(diff), vget_high_s16(ix)));
+			b2v = vpadalq_s32(vpadalq_s32(b2v, vmull_s16(vget_low_s16(diff), vget_low_s16(iy))), vmull_s16(vget_high_s16(diff), vget_high_s16(iy)));
+		}
+		b_ptr += b_step;
+		wi += wstep;
+		widx += wstep;
+		widy += wstep;
+	}
+	b1 = (double)(vgetq_lane_s64(b1v, 0) + vgetq_lane_s64(b1v, 1));
+	b2 = (double)(vgetq_lane_s64(b2v, 0) + vgetq_lane_s64(b2v, 1));
+#else
+	for (y = 0; y < win_size.height; y++)
+	{
+		for (x = 0; x < win_size.width; x++)
+		{
+			int diff = ccv_descale(b_ptr[x] * iw[0] + b_ptr[x + 1] * iw[1] + b_ptr[x + b_step] * iw[2] + b_ptr[x + b_step + 1] * iw[3], W_BITS7) - wi[x];
+			b1 += diff * widx[x];
+			b2 += diff * widy[x];
+		}
+		b_ptr += b_step;
+		wi += wstep;
+		widx += wstep;
+		widy += wstep;
+	}
+#endif
+	m[0] = b1;
+	m[1] = b2;
+}
+
+static void _ccv_optical_flow_lucas_kanade(ccv_optical_flow_pyramid_t* pyr_a, ccv_optical_flow_pyramid_t* pyr_b, ccv_array_t* point_a, ccv_array_t* seq, ccv_size_t win_size, double min_eigen)
+{
+	const int level = pyr_a->level;
+	int i, j, t;
+	// the window is in rows of multiple of 8, and the vectorized code reads 8 more after the first one
+	const int wstep = (win_size.width + 7) & -8;
+	short* wi = (short*)ccmalloc(sizeof(short) * wstep * win_size.height * 3);
+	short* widx = wi + wstep * win_size.height;
+	short* widy = widx + wstep * win_size.height;
 	ccv_decimal_point_t half_win = ccv_decimal_point((win_size.width - 1) * 0.5f, (win_size.height - 1) * 0.5f);
-	const int W_BITS14 = 14, W_BITS7 = 7, W_BITS9 = 9;
+	const int W_BITS14 = 14;
 	const float FLT_SCALE = 1.0f / (1 << 25);
 	// clean up status to 1
 	for (i = 0; i < point_a->rnum; i++)
@@ -480,12 +848,12 @@ void ccv_optical_flow_lucas_kanade(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b,
 	int prev_rows, prev_cols;
 	for (t = level - 1; t >= 0; t--)
 	{
-		ccv_dense_matrix_t* a = pyr_a[t];
-		ccv_dense_matrix_t* adx = pyr_a_dx[t];
-		ccv_dense_matrix_t* ady = pyr_a_dy[t];
+		ccv_dense_matrix_t* a = pyr_a->pyr[t];
+		ccv_dense_matrix_t* adx = pyr_a->dx[t];
+		ccv_dense_matrix_t* ady = pyr_a->dy[t];
 		assert(CCV_GET_DATA_TYPE(adx->type) == CCV_32S);
 		assert(CCV_GET_DATA_TYPE(ady->type) == CCV_32S);
-		ccv_dense_matrix_t* b = pyr_b[t];
+		ccv_dense_matrix_t* b = pyr_b->pyr[t];
 		for (i = 0; i < point_a->rnum; i++)
 		{
 			ccv_decimal_point_t prev_point = *(ccv_decimal_point_t*)ccv_array_get(point_a, i);
@@ -512,39 +880,19 @@ void ccv_optical_flow_lucas_kanade(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b,
 			}
 			float xd = prev_point.x - iprev_point.x;
 			float yd = prev_point.y - iprev_point.y;
-			int iw00 = (int)((1 - xd) * (1 - yd) * (1 << W_BITS14) + 0.5);
-			int iw01 = (int)(xd * (1 - yd) * (1 << W_BITS14) + 0.5);
-			int iw10 = (int)((1 - xd) * yd * (1 << W_BITS14) + 0.5);
-			int iw11 = (1 << W_BITS14) - iw00 - iw01 - iw10;
-			float a11 = 0, a12 = 0, a22 = 0;
-			unsigned char* a_ptr = (unsigned char*)ccv_get_dense_matrix_cell_by(CCV_C1 | CCV_8U, a, iprev_point.y, iprev_point.x, 0);
-			int* adx_ptr = (int*)ccv_get_dense_matrix_cell_by(CCV_C1 | CCV_32S, adx, iprev_point.y, iprev_point.x, 0);
-			int* ady_ptr = (int*)ccv_get_dense_matrix_cell_by(CCV_C1 | CCV_32S, ady, iprev_point.y, iprev_point.x, 0);
-			int* wi_ptr = wi;
-			int* widx_ptr = widx;
-			int* widy_ptr = widy;
-			for (y = 0; y < win_size.height; y++)
-			{
-				for (x = 0; x < win_size.width; x++)
-				{
-					wi_ptr[x] = ccv_descale(a_ptr[x] * iw00 + a_ptr[x + 1] * iw01 + a_ptr[x + a->step] * iw10 + a_ptr[x + a->step + 1] * iw11, W_BITS7);
-					// because we use 3x3 sobel, which scaled derivative up by 4
-					widx_ptr[x] = ccv_descale(adx_ptr[x] * iw00 + adx_ptr[x + 1] * iw01 + adx_ptr[x + adx->cols] * iw10 + adx_ptr[x + adx->cols + 1] * iw11, W_BITS9);
-					widy_ptr[x] = ccv_descale(ady_ptr[x] * iw00 + ady_ptr[x + 1] * iw01 + ady_ptr[x + ady->cols] + iw10 + ady_ptr[x + ady->cols + 1] * iw11, W_BITS9);
-					a11 += (float)(widx_ptr[x] * widx_ptr[x]);
-					a12 += (float)(widx_ptr[x] * widy_ptr[x]);
-					a22 += (float)(widy_ptr[x] * widy_ptr[x]);
-				}
-				a_ptr += a->step;
-				adx_ptr += adx->cols;
-				ady_ptr += ady->cols;
-				wi_ptr += win_size.width;
-				widx_ptr += win_size.width;
-				widy_ptr += win_size.width;
-			}
-			a11 *= FLT_SCALE;
-			a12 *= FLT_SCALE;
-			a22 *= FLT_SCALE;
+			int iw[4];
+			iw[0] = (int)((1 - xd) * (1 - yd) * (1 << W_BITS14) + 0.5);
+			iw[1] = (int)(xd * (1 - yd) * (1 << W_BITS14) + 0.5);
+			iw[2] = (int)((1 - xd) * yd * (1 << W_BITS14) + 0.5);
+			iw[3] = (1 << W_BITS14) - iw[0] - iw[1] - iw[2];
+			double g[3];
+			_ccv_optical_flow_window((unsigned char*)ccv_get_dense_matrix_cell_by(CCV_C1 | CCV_8U, a, iprev_point.y, iprev_point.x, 0), a->step,
+				(int*)ccv_get_dense_matrix_cell_by(CCV_C1 | CCV_32S, adx, iprev_point.y, iprev_point.x, 0),
+				(int*)ccv_get_dense_matrix_cell_by(CCV_C1 | CCV_32S, ady, iprev_point.y, iprev_point.x, 0), adx->cols,
+				win_size, wstep, iw, wi, widx, widy, g);
+			float a11 = (float)g[0] * FLT_SCALE;
+			float a12 = (float)g[1] * FLT_SCALE;
+			float a22 = (float)g[2] * FLT_SCALE;
 			float D = a11 * a22 - a12 * a12;
 			float eigen = (a22 + a11 - sqrtf((a11 - a22) * (a11 - a22) + 4.0f * a12 * a12)) / (2 * win_size.width * win_size.height);
 			if (eigen < min_eigen || D < FLT_EPSILON)
@@ -565,30 +913,14 @@ void ccv_optical_flow_lucas_kanade(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b,
 					break;
 				float xd = next_point.x - inext_point.x;
 				float yd = next_point.y - inext_point.y;
-				int iw00 = (int)((1 - xd) * (1 - yd) * (1 << W_BITS14) + 0.5);
-				int iw01 = (int)(xd * (1 - yd) * (1 << W_BITS14) + 0.5);
-				int iw10 = (int)((1 - xd) * yd * (1 << W_BITS14) + 0.5);
-				int iw11 = (1 << W_BITS14) - iw00 - iw01 - iw10;
-				float b1 = 0, b2 = 0;
-				unsigned char* b_ptr = (unsigned char*)ccv_get_dense_matrix_cell_by(CCV_C1 | CCV_8U, b, inext_point.y, inext_point.x, 0);
-				int* wi_ptr = wi;
-				int* widx_ptr = widx;
-				int* widy_ptr = widy;
-				for (y = 0; y < win_size.height; y++)
-				{
-					for (x = 0; x < win_size.width; x++)
-					{
-						int diff = ccv_descale(b_ptr[x] * iw00 + b_ptr[x + 1] * iw01 + b_ptr[x + b->step] * iw10 + b_ptr[x + b->step + 1] * iw11, W_BITS7) - wi_ptr[x];
-						b1 += (float)(diff * widx_ptr[x]);
-						b2 += (float)(diff * widy_ptr[x]);
-					}
-					b_ptr += b->step;
-					wi_ptr += win_size.width;
-					widx_ptr += win_size.width;
-					widy_ptr += win_size.width;
-				}
-				b1 *= FLT_SCALE;
-				b2 *= FLT_SCALE;
+				iw[0] = (int)((1 - xd) * (1 - yd) * (1 << W_BITS14) + 0.5);
+				iw[1] = (int)(xd * (1 - yd) * (1 << W_BITS14) + 0.5);
+				iw[2] = (int)((1 - xd) * yd * (1 << W_BITS14) + 0.5);
+				iw[3] = (1 << W_BITS14) - iw[0] - iw[1] - iw[2];
+				double m[2];
+				_ccv_optical_flow_mismatch((unsigned char*)ccv_get_dense_matrix_cell_by(CCV_C1 | CCV_8U, b, inext_point.y, inext_point.x, 0), b->step, win_size, wstep, iw, wi, widx, widy, m);
+				float b1 = (float)m[0] * FLT_SCALE;
+				float b2 = (float)m[1] * FLT_SCALE;
 				ccv_decimal_point_t delta = ccv_decimal_point((a12 * b2 - a22 * b1) * D, (a12 * b1 - a11 * b2) * D);
 				next_point.x += delta.x;
 				next_point.y += delta.y;
@@ -613,12 +945,58 @@ void ccv_optical_flow_lucas_kanade(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b,
 		}
 		prev_rows = a->rows;
 		prev_cols = a->cols;
-		ccv_matrix_free(adx);
-		ccv_matrix_free(ady);
-		if (t > 0)
-		{
-			ccv_matrix_free(a);
-			ccv_matrix_free(b);
-		}
 	}
+	ccfree(wi);
+}
+
+void ccv_optical_flow_lucas_kanade_pyramid(ccv_optical_flow_pyramid_t* a, ccv_optical_flow_pyramid_t* b, ccv_array_t* point_a, ccv_array_t** point_b, ccv_size_t win_size, double min_eigen)
+{
+	assert(a && b && a->level == b->level);
+	assert(a->pyr[0]->rows == b->pyr[0]->rows && a->pyr[0]->cols == b->pyr[0]->cols);
+	assert(point_a->rnum > 0);
+	ccv_declare_derived_signature(sig, a->sig != 0 && b->sig != 0 && point_a->sig != 0, ccv_sign_with_format(128, "ccv_optical_flow_lucas_kanade(%d,%d,%d,%la)", win_size.width, win_size.height, a->level, min_eigen), a->sig, b->sig, point_a->sig, CCV_EOF_SIGN);
+	ccv_array_t* seq = *point_b = ccv_array_new(sizeof(ccv_decimal_point_with_status_t), point_a->rnum, sig);
+	ccv_object_return_if_cached(, seq);
+	seq->rnum = point_a->rnum;
+	_ccv_optical_flow_pyramid_gradient(a);
+	_ccv_optical_flow_lucas_kanade(a, b, point_a, seq, win_size, min_eigen);
+}
+
+/* this code is a rewrite from OpenCV's legendary Lucas-Kanade optical flow implementation */
+void ccv_optical_flow_lucas_kanade(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_array_t* point_a, ccv_array_t** point_b, ccv_size_t win_size, int level, double min_eigen)
+{
+	assert(a && b && a->rows == b->rows && a->cols == b->cols);
+	assert(CCV_GET_CHANNEL(a->type) == CCV_GET_CHANNEL(b->type) && CCV_GET_DATA_TYPE(a->type) == CCV_GET_DATA_TYPE(b->type));
+	assert(CCV_GET_CHANNEL(a->type) == 1);
+	assert(CCV_GET_DATA_TYPE(a->type) == CCV_8U);
+	assert(point_a->rnum > 0);
+	level = _ccv_optical_flow_pyramid_level(a, win_size, level);
+	ccv_declare_derived_signature(sig, a->sig != 0 && b->sig != 0 && point_a->sig != 0, ccv_sign_with_format(128, "ccv_optical_flow_lucas_kanade(%d,%d,%d,%la)", win_size.width, win_size.height, level, min_eigen), a->sig, b->sig, point_a->sig, CCV_EOF_SIGN);
+	ccv_array_t* seq = *point_b = ccv_array_new(sizeof(ccv_decimal_point_with_status_t), point_a->rnum, sig);
+	ccv_object_return_if_cached(, seq);
+	seq->rnum = point_a->rnum;
+	/* the pyramids only live through this call, thus, refer to the frames directly rather than a copy */
+	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca(sizeof(ccv_dense_matrix_t*) * level * 5);
+	ccv_optical_flow_pyramid_t pyr_a = {
+		.level = level,
+		.sig = a->sig,
+		.pyr = pyr,
+		.dx = pyr + level,
+		.dy = pyr + level * 2,
+	};
+	ccv_optical_flow_pyramid_t pyr_b = {
+		.level = level,
+		.sig = b->sig,
+		.pyr = pyr + level * 3,
+		.dx = pyr + level * 4,
+		.dy = pyr + level * 4, // the gradients of the next frame are not needed
+	};
+	pyr_a.pyr[0] = a;
+	pyr_b.pyr[0] = b;
+	_ccv_optical_flow_pyramid_build(&pyr_a);
+	_ccv_optical_flow_pyramid_gradient(&pyr_a);
+	_ccv_optical_flow_pyramid_build(&pyr_b);
+	_ccv_optical_flow_lucas_kanade(&pyr_a, &pyr_b, point_a, seq, win_size, min_eigen);
+	_ccv_optical_flow_pyramid_clear(&pyr_a);
+	_ccv_optical_flow_pyramid_clear(&pyr_b);
 }
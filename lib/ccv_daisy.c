@@ -1,5 +1,10 @@
 #include "ccv.h"
 #include "ccv_internal.h"
+#if defined(HAVE_SSE2)
+#include <emmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
 
 /* the method is adopted from original author's published C++ code under BSD Licence.
  * Here is the copyright:
@@ -44,35 +49,58 @@
  * //////////////////////////////////////////////////////////////////////////
  */
 
-void ccv_daisy(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, ccv_daisy_param_t params)
+#define CCV_DAISY_BAND_ROWS (16)
+
+/* project the gradients onto each orientation, rectified, every orientation goes into its own layer */
+static void _ccv_daisy_layered_gradient(const float* dx, const float* dy, const int count, const float* kcos, const float* ksin, const int layer_size, const int hist_th_q_no, float* w)
+{
+	int i, k;
+	for (k = 0; k < hist_th_q_no; k++)
+	{
+		float* w_ptr = w + k * layer_size;
+		i = 0;
+#if defined(HAVE_SSE2)
+		const __m128 z = _mm_setzero_ps();
+		const __m128 c4 = _mm_set1_ps(kcos[k]);
+		const __m128 s4 = _mm_set1_ps(ksin[k]);
+		for (; i < count - 3; i += 4)
+			_mm_storeu_ps(w_ptr + i, _mm_max_ps(_mm_add_ps(_mm_mul_ps(c4, _mm_loadu_ps(dx + i)), _mm_mul_ps(s4, _mm_loadu_ps(dy + i))), z));
+#elif defined(HAVE_NEON)
+		const float32x4_t z = vdupq_n_f32(0);
+		for (; i < count - 3; i += 4)
+			vst1q_f32(w_ptr + i, vmaxq_f32(vaddq_f32(vmulq_n_f32(vld1q_f32(dx + i), kcos[k]), vmulq_n_f32(vld1q_f32(dy + i), ksin[k])), z));
+#endif
+		for (; i < count; i++)
+			w_ptr[i] = ccv_max(0, kcos[k] * dx[i] + ksin[k] * dy[i]);
+	}
+}
+
+/* the histograms of a cube are interleaved, thus, the bins of one pixel are next to each other */
+static void _ccv_daisy_interleave(const float* src_ptr, float* his_ptr, const int rows, const int cols, const int hist_th_q_no)
+{
+	const int layer_size = rows * cols;
+	parallel_for(i, rows) {
+		int j, k;
+		const float* s_ptr = src_ptr + i * cols;
+		float* h_ptr = his_ptr + i * cols * hist_th_q_no;
+		for (j = 0; j < cols; j++)
+			for (k = 0; k < hist_th_q_no; k++)
+				h_ptr[j * hist_th_q_no + k] = s_ptr[j + k * layer_size];
+	} parallel_endfor
+}
+
+/* the workspace has rad_q_no + 2 cubes, when done, the first rad_q_no + 1 cubes are the interleaved histograms
+ * with the smoothing for the center and each ring, the last cube is the scratch */
+static void _ccv_daisy_layers(ccv_dense_matrix_t* a, ccv_daisy_param_t params, float* workspace_memory)
 {
-	int grid_point_number = params.rad_q_no * params.th_q_no + 1;
-	int desc_size = grid_point_number * params.hist_th_q_no;
-	char* identifier = (char*)alloca(ccv_max(sizeof(ccv_daisy_param_t) + 9, sizeof(double) * params.rad_q_no));
-	memset(identifier, 0, ccv_max(sizeof(ccv_daisy_param_t) + 9, sizeof(double) * params.rad_q_no));
-	memcpy(identifier, "ccv_daisy", 9);
-	memcpy(identifier + 9, &params, sizeof(ccv_daisy_param_t));
-	uint64_t sig = (a->sig == 0) ? 0 : ccv_cache_generate_signature(identifier, sizeof(ccv_daisy_param_t) + 9, a->sig, CCV_EOF_SIGN);
-	type = (type == 0) ? CCV_32F | CCV_C1 : CCV_GET_DATA_TYPE(type) | CCV_C1;
-	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, a->rows, a->cols * desc_size, CCV_C1 | CCV_ALL_DATA_TYPE, type, sig);
 	int layer_size = a->rows * a->cols;
 	int cube_size = layer_size * params.hist_th_q_no;
-	float* workspace_memory = (float*)ccmalloc(cube_size * (params.rad_q_no + 2) * sizeof(float));
+	int i, k;
 	/* compute_cube_sigmas */
-	int i, j, k, r, t;
-	double* cube_sigmas = (double*)identifier;
+	double* cube_sigmas = (double*)alloca(sizeof(double) * params.rad_q_no);
 	double r_step = params.radius / (double)params.rad_q_no;
 	for (i = 0; i < params.rad_q_no; i++)
 		cube_sigmas[i] = (i + 1) * r_step * 0.5;
-	/* compute_grid_points */
-	double t_step = 2 * 3.141592654 / params.th_q_no;
-	double* grid_points = (double*)alloca(grid_point_number * 2 * sizeof(double));
-	for (i = 0; i < params.rad_q_no; i++)
-		for (j = 0; j < params.th_q_no; j++)
-		{
-			grid_points[(i * params.th_q_no + 1 + j) * 2] = sin(j * t_step) * (i + 1) * r_step;
-			grid_points[(i * params.th_q_no + 1 + j) * 2 + 1] = cos(j * t_step) * (i + 1) * r_step;
-		}
 	/* TODO: require 0.5 gaussian smooth before gradient computing */
 	/* NOTE: the default sobel already applied a sigma = 0.85 gaussian blur by using a
 	 * | -1  0  1 |   |  0  0  0 |   | 1  2  1 |
@@ -86,21 +114,31 @@ void ccv_daisy(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, ccv_dais
 	double sigma_init = 1.6;
 	double sigma = sqrt(sigma_init * sigma_init - sobel_sigma * sobel_sigma);
 	/* layered_gradient & smooth_layers */
-	for (k = params.hist_th_q_no - 1; k >= 0; k--)
+	float* kcos = (float*)alloca(sizeof(float) * params.hist_th_q_no * 2);
+	float* ksin = kcos + params.hist_th_q_no;
+	for (k = 0; k < params.hist_th_q_no; k++)
 	{
 		float radius = k * 2 * 3.141592654 / params.th_q_no;
-		float kcos = cos(radius);
-		float ksin = sin(radius);
-		float* w_ptr = workspace_memory + cube_size + (k - 1) * layer_size;
-		for (i = 0; i < layer_size; i++)
-			w_ptr[i] = ccv_max(0, kcos * dx->data.f32[i] + ksin * dy->data.f32[i]);
-		ccv_dense_matrix_t src = ccv_dense_matrix(a->rows, a->cols, CCV_32F | CCV_C1, w_ptr, 0);
-		ccv_dense_matrix_t des = ccv_dense_matrix(a->rows, a->cols, CCV_32F | CCV_C1, w_ptr + layer_size, 0);
-		ccv_dense_matrix_t* desp = &des;
-		ccv_blur(&src, &desp, 0, sigma);
+		kcos[k] = cos(radius);
+		ksin[k] = sin(radius);
 	}
+	float* scratch = workspace_memory + (params.rad_q_no + 1) * cube_size;
+	const int band_count = (a->rows + CCV_DAISY_BAND_ROWS - 1) / CCV_DAISY_BAND_ROWS;
+	parallel_for(i, band_count) {
+		const int offset = i * CCV_DAISY_BAND_ROWS * a->cols;
+		const int count = ccv_min(CCV_DAISY_BAND_ROWS, a->rows - i * CCV_DAISY_BAND_ROWS) * a->cols;
+		_ccv_daisy_layered_gradient(dx->data.f32 + offset, dy->data.f32 + offset, count, kcos, ksin, layer_size, params.hist_th_q_no, scratch + offset);
+	} parallel_endfor
 	ccv_matrix_free(dx);
 	ccv_matrix_free(dy);
+	for (k = 0; k < params.hist_th_q_no; k++)
+	{
+		ccv_dense_matrix_t src = ccv_dense_matrix(a->rows, a->cols, CCV_32F | CCV_C1, scratch + k * layer_size, 0);
+		ccv_dense_matrix_t des = ccv_dense_matrix(a->rows, a->cols, CCV_32F | CCV_C1, workspace_memory + cube_size + k * layer_size, 0);
+		ccv_dense_matrix_t* desp = &des;
+		ccv_blur(&src, &desp, 0, sigma);
+	}
+	_ccv_daisy_interleave(workspace_memory + cube_size, workspace_memory, a->rows, a->cols, params.hist_th_q_no);
 	/* compute_smoothed_gradient_layers & compute_histograms (rearrange memory) */
 	for (k = 0; k < params.rad_q_no; k++)
 	{
@@ -114,120 +152,190 @@ void ccv_daisy(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, ccv_dais
 			ccv_dense_matrix_t* desp = &des;
 			ccv_blur(&src, &desp, 0, sigma);
 		}
-		float* his_ptr = src_ptr - cube_size;
-		for (i = 0; i < layer_size; i++)
-			for (j = 0; j < params.hist_th_q_no; j++)
-				his_ptr[i * params.hist_th_q_no + j] = src_ptr[i + j * layer_size];
+		// the smoothed one of this cube is done, the ring k is sampled from it
+		_ccv_daisy_interleave(des_ptr, src_ptr, a->rows, a->cols, params.hist_th_q_no);
 	}
-	/* petals of the flower */
-	memset(db->data.u8, 0, db->rows * db->step);
-	for (i = 0; i < a->rows; i++)
-		for (j = 0; j < a->cols; j++)
+}
+
+static inline void _ccv_daisy_accumulate(float* bh, const float* ah, const float wy, const float wx, const int hist_th_q_no)
+{
+	int k = 0;
+#if defined(HAVE_SSE2)
+	const __m128 wy4 = _mm_set1_ps(wy);
+	const __m128 wx4 = _mm_set1_ps(wx);
+	for (; k < hist_th_q_no - 3; k += 4)
+		_mm_storeu_ps(bh + k, _mm_add_ps(_mm_loadu_ps(bh + k), _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(ah + k), wy4), wx4)));
+#elif defined(HAVE_NEON)
+	for (; k < hist_th_q_no - 3; k += 4)
+		vst1q_f32(bh + k, vaddq_f32(vld1q_f32(bh + k), vmulq_n_f32(vmulq_n_f32(vld1q_f32(ah + k), wy), wx)));
+#endif
+	for (; k < hist_th_q_no; k++)
+		bh[k] += ah[k] * wy * wx;
+}
+
+/* petals of the flower, and the normalization of the descriptor at (i, j) */
+static void _ccv_daisy_descriptor(const float* workspace_memory, const int rows, const int cols, const int i, const int j, const double* grid_points, const ccv_daisy_param_t params, float* b_ptr)
+{
+	int grid_point_number = params.rad_q_no * params.th_q_no + 1;
+	int desc_size = grid_point_number * params.hist_th_q_no;
+	int cube_size = rows * cols * params.hist_th_q_no;
+	int k, r, t;
+	const float* a_ptr = workspace_memory + i * params.hist_th_q_no * cols + j * params.hist_th_q_no;
+	memcpy(b_ptr, a_ptr, params.hist_th_q_no * sizeof(float));
+	memset(b_ptr + params.hist_th_q_no, 0, (desc_size - params.hist_th_q_no) * sizeof(float));
+	for (r = 0; r < params.rad_q_no; r++)
+	{
+		int rdt = r * params.th_q_no + 1;
+		const float* cube = workspace_memory + (r + 1) * cube_size;
+		for (t = rdt; t < rdt + params.th_q_no; t++)
 		{
-			float* a_ptr = workspace_memory + i * params.hist_th_q_no * a->cols + j * params.hist_th_q_no;
-			float* b_ptr = db->data.f32 + i * db->cols + j * desc_size;
-			memcpy(b_ptr, a_ptr, params.hist_th_q_no * sizeof(float));
-			for (r = 0; r < params.rad_q_no; r++)
+			double y = i + grid_points[t * 2];
+			double x = j + grid_points[t * 2 + 1];
+			int iy = (int)(y + 0.5);
+			int ix = (int)(x + 0.5);
+			float* bh = b_ptr + t * params.hist_th_q_no;
+			if (iy < 0 || iy >= rows || ix < 0 || ix >= cols)
+				continue;
+			// bilinear interpolation
+			int jy = (int)y;
+			int jx = (int)x;
+			float yr = y - jy, _yr = 1 - yr;
+			float xr = x - jx, _xr = 1 - xr;
+			if (jy >= 0 && jy < rows && jx >= 0 && jx < cols)
+				_ccv_daisy_accumulate(bh, cube + jy * params.hist_th_q_no * cols + jx * params.hist_th_q_no, _yr, _xr, params.hist_th_q_no);
+			if (jy + 1 >= 0 && jy + 1 < rows && jx >= 0 && jx < cols)
+				_ccv_daisy_accumulate(bh, cube + (jy + 1) * params.hist_th_q_no * cols + jx * params.hist_th_q_no, yr, _xr, params.hist_th_q_no);
+			if (jy >= 0 && jy < rows && jx + 1 >= 0 && jx + 1 < cols)
+				_ccv_daisy_accumulate(bh, cube + jy * params.hist_th_q_no * cols + (jx + 1) * params.hist_th_q_no, _yr, xr, params.hist_th_q_no);
+			if (jy + 1 >= 0 && jy + 1 < rows && jx + 1 >= 0 && jx + 1 < cols)
+				_ccv_daisy_accumulate(bh, cube + (jy + 1) * params.hist_th_q_no * cols + (jx + 1) * params.hist_th_q_no, yr, xr, params.hist_th_q_no);
+		}
+	}
+	float norm;
+	int iter, changed;
+	switch (params.normalize_method)
+	{
+		case CCV_DAISY_NORMAL_PARTIAL:
+			for (t = 0; t < grid_point_number; t++)
 			{
-				int rdt = r * params.th_q_no + 1;
-				for (t = rdt; t < rdt + params.th_q_no; t++)
+				norm = 0;
+				float* bh = b_ptr + t * params.hist_th_q_no;
+				for (k = 0; k < params.hist_th_q_no; k++)
+					norm += bh[k] * bh[k];
+				if (norm > 1e-6)
 				{
-					double y = i + grid_points[t * 2];
-					double x = j + grid_points[t * 2 + 1];
-					int iy = (int)(y + 0.5);
-					int ix = (int)(x + 0.5);
-					float* bh = b_ptr + t * params.hist_th_q_no;
-					if (iy < 0 || iy >= a->rows || ix < 0 || ix >= a->cols)
-						continue;
-					// bilinear interpolation
-					int jy = (int)y;
-					int jx = (int)x;
-					float yr = y - jy, _yr = 1 - yr;
-					float xr = x - jx, _xr = 1 - xr;
-					if (jy >= 0 && jy < a->rows && jx >= 0 && jx < a->cols)
-					{
-						float* ah = workspace_memory + (r + 1) * cube_size + jy * params.hist_th_q_no * a->cols + jx * params.hist_th_q_no;
-						for (k = 0; k < params.hist_th_q_no; k++)
-							bh[k] += ah[k] * _yr * _xr;
-					}
-					if (jy + 1 >= 0 && jy + 1 < a->rows && jx >= 0 && jx < a->cols)
-					{
-						float* ah = workspace_memory + (r + 1) * cube_size + (jy + 1) * params.hist_th_q_no * a->cols + jx * params.hist_th_q_no;
-						for (k = 0; k < params.hist_th_q_no; k++)
-							bh[k] += ah[k] * yr * _xr;
-					}
-					if (jy >= 0 && jy < a->rows && jx + 1 >= 0 && jx + 1 < a->cols)
-					{
-						float* ah = workspace_memory + (r + 1) * cube_size + jy * params.hist_th_q_no * a->cols + (jx + 1) * params.hist_th_q_no;
-						for (k = 0; k < params.hist_th_q_no; k++)
-							bh[k] += ah[k] * _yr * xr;
-					}
-					if (jy + 1 >= 0 && jy + 1 < a->rows && jx + 1 >= 0 && jx + 1 < a->cols)
-					{
-						float* ah = workspace_memory + (r + 1) * cube_size + (jy + 1) * params.hist_th_q_no * a->cols + (jx + 1) * params.hist_th_q_no;
-						for (k = 0; k < params.hist_th_q_no; k++)
-							bh[k] += ah[k] * yr * xr;
-					}
+					norm = 1.0 / sqrt(norm);
+					for (k = 0; k < params.hist_th_q_no; k++)
+						bh[k] *= norm;
 				}
 			}
-		}
-	ccfree(workspace_memory);
-	for (i = 0; i < a->rows; i++)
-		for (j = 0; j < a->cols; j++)
-		{
-			float* b_ptr = db->data.f32 + i * db->cols + j * desc_size;
-			float norm;
-			int iter, changed;
-			switch (params.normalize_method)
+			break;
+		case CCV_DAISY_NORMAL_FULL:
+			norm = 0;
+			for (t = 0; t < desc_size; t++)
+				norm += b_ptr[t] * b_ptr[t];
+			if (norm > 1e-6)
 			{
-				case CCV_DAISY_NORMAL_PARTIAL:
-					for (t = 0; t < grid_point_number; t++)
-					{
-						norm = 0;
-						float* bh = b_ptr + t * params.hist_th_q_no;
-						for (k = 0; k < params.hist_th_q_no; k++)
-							norm += bh[k] * bh[k];
-						if (norm > 1e-6)
-						{
-							norm = 1.0 / sqrt(norm);
-							for (k = 0; k < params.hist_th_q_no; k++)
-								bh[k] *= norm;
-						}
-					}
-					break;
-				case CCV_DAISY_NORMAL_FULL:
-					norm = 0;
+				norm = 1.0 / sqrt(norm);
+				for (t = 0; t < desc_size; t++)
+					b_ptr[t] *= norm;
+			}
+			break;
+		case CCV_DAISY_NORMAL_SIFT:
+			for (iter = 0, changed = 1; changed && iter < 5; iter++)
+			{
+				norm = 0;
+				for (t = 0; t < desc_size; t++)
+					norm += b_ptr[t] * b_ptr[t];
+				changed = 0;
+				if (norm > 1e-6)
+				{
+					norm = 1.0 / sqrt(norm);
 					for (t = 0; t < desc_size; t++)
-						norm += b_ptr[t] * b_ptr[t];
-					if (norm > 1e-6)
 					{
-						norm = 1.0 / sqrt(norm);
-						for (t = 0; t < desc_size; t++)
-							b_ptr[t] *= norm;
-					}
-					break;
-				case CCV_DAISY_NORMAL_SIFT:
-					for (iter = 0, changed = 1; changed && iter < 5; iter++)
-					{
-						norm = 0;
-						for (t = 0; t < desc_size; t++)
-							norm += b_ptr[t] * b_ptr[t];
-						changed = 0;
-						if (norm > 1e-6)
+						b_ptr[t] *= norm;
+						if (b_ptr[t] < params.normalize_threshold)
 						{
-							norm = 1.0 / sqrt(norm);
-							for (t = 0; t < desc_size; t++)
-							{
-								b_ptr[t] *= norm;
-								if (b_ptr[t] < params.normalize_threshold)
-								{
-									b_ptr[t] = params.normalize_threshold;
-									changed = 1;
-								}
-							}
+							b_ptr[t] = params.normalize_threshold;
+							changed = 1;
 						}
 					}
-					break;
+				}
 			}
+			break;
+	}
+}
+
+static void _ccv_daisy_grid_points(ccv_daisy_param_t params, double* grid_points)
+{
+	int i, j;
+	/* compute_grid_points */
+	double r_step = params.radius / (double)params.rad_q_no;
+	double t_step = 2 * 3.141592654 / params.th_q_no;
+	grid_points[0] = grid_points[1] = 0;
+	for (i = 0; i < params.rad_q_no; i++)
+		for (j = 0; j < params.th_q_no; j++)
+		{
+			grid_points[(i * params.th_q_no + 1 + j) * 2] = sin(j * t_step) * (i + 1) * r_step;
+			grid_points[(i * params.th_q_no + 1 + j) * 2 + 1] = cos(j * t_step) * (i + 1) * r_step;
 		}
 }
+
+void ccv_daisy(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, ccv_daisy_param_t params)
+{
+	int grid_point_number = params.rad_q_no * params.th_q_no + 1;
+	int desc_size = grid_point_number * params.hist_th_q_no;
+	char identifier[sizeof(ccv_daisy_param_t) + 9];
+	memset(identifier, 0, sizeof(identifier));
+	memcpy(identifier, "ccv_daisy", 9);
+	memcpy(identifier + 9, &params, sizeof(ccv_daisy_param_t));
+	uint64_t sig = (a->sig == 0) ? 0 : ccv_cache_generate_signature(identifier, sizeof(ccv_daisy_param_t) + 9, a->sig, CCV_EOF_SIGN);
+	type = (type == 0) ? CCV_32F | CCV_C1 : CCV_GET_DATA_TYPE(type) | CCV_C1;
+	const int step = ccv_max(1, params.step);
+	const int rows = (a->rows + step - 1) / step;
+	const int cols = (a->cols + step - 1) / step;
+	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, rows, cols * desc_size, CCV_C1 | CCV_ALL_DATA_TYPE, type, sig);
+	ccv_object_return_if_cached(, db);
+	float* workspace_memory = (float*)ccmalloc(a->rows * a->cols * params.hist_th_q_no * (params.rad_q_no + 2) * sizeof(float));
+	_ccv_daisy_layers(a, params, workspace_memory);
+	double* grid_points = (double*)alloca(grid_point_number * 2 * sizeof(double));
+	_ccv_daisy_grid_points(params, grid_points);
+	parallel_for(i, rows) {
+		int j;
+		for (j = 0; j < cols; j++)
+			_ccv_daisy_descriptor(workspace_memory, a->rows, a->cols, i * step, j * step, grid_points, params, db->data.f32 + i * db->cols + j * desc_size);
+	} parallel_endfor
+	ccfree(workspace_memory);
+}
+
+void ccv_daisy_points(ccv_dense_matrix_t* a, ccv_array_t* points, ccv_dense_matrix_t** b, int type, ccv_daisy_param_t params)
+{
+	int grid_point_number = params.rad_q_no * params.th_q_no + 1;
+	int desc_size = grid_point_number * params.hist_th_q_no;
+	char identifier[sizeof(ccv_daisy_param_t) + 16];
+	memset(identifier, 0, sizeof(identifier));
+	memcpy(identifier, "ccv_daisy_points", 16);
+	memcpy(identifier + 16, &params, sizeof(ccv_daisy_param_t));
+	uint64_t sig = (a->sig == 0 || points->sig == 0) ? 0 : ccv_cache_generate_signature(identifier, sizeof(ccv_daisy_param_t) + 16, a->sig, points->sig, CCV_EOF_SIGN);
+	type = (type == 0) ? CCV_32F | CCV_C1 : CCV_GET_DATA_TYPE(type) | CCV_C1;
+	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, ccv_max(1, points->rnum), desc_size, CCV_C1 | CCV_ALL_DATA_TYPE, type, sig);
+	ccv_object_return_if_cached(, db);
+	if (points->rnum == 0)
+	{
+		memset(db->data.u8, 0, db->rows * db->step);
+		return;
+	}
+	float* workspace_memory = (float*)ccmalloc(a->rows * a->cols * params.hist_th_q_no * (params.rad_q_no + 2) * sizeof(float));
+	_ccv_daisy_layers(a, params, workspace_memory);
+	double* grid_points = (double*)alloca(grid_point_number * 2 * sizeof(double));
+	_ccv_daisy_grid_points(params, grid_points);
+	parallel_for(i, points->rnum) {
+		ccv_point_t* point = (ccv_point_t*)ccv_array_get(points, i);
+		float* b_ptr = db->data.f32 + i * db->cols;
+		if (point->x < 0 || point->x >= a->cols || point->y < 0 || point->y >= a->rows)
+			memset(b_ptr, 0, desc_size * sizeof(float));
+		else
+			_ccv_daisy_descriptor(workspace_memory, a->rows, a->cols, point->y, point->x, grid_points, params, b_ptr);
+	} parallel_endfor
+	ccfree(workspace_memory);
+}
@@ -42,35 +42,24 @@ static int _ccv_dpm_scale_upto(ccv_dense_matrix_t* a, ccv_dpm_mixture_model_t**
 	return (int)(log((double)ccv_min(hr, wr)) / log(scale)) - next;
 }
 
-static void _ccv_dpm_feature_pyramid(ccv_dense_matrix_t* a, ccv_dense_matrix_t** pyr, int scale_upto, int interval)
+/* the image levels are owned by the pyramid, only the hog levels are returned in pyr */
+static void _ccv_dpm_feature_pyramid(ccv_pyramid_t* pyramid, ccv_dense_matrix_t** pyr, int scale_upto, int interval)
 {
 	int next = interval + 1;
 	double scale = pow(2.0, 1.0 / (interval + 1.0));
 	memset(pyr, 0, (scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
-	pyr[next] = a;
+	pyr[next] = pyramid->a;
 	int i;
 	for (i = 1; i <= interval; i++)
-		ccv_resample(pyr[next], &pyr[next + i], 0, (int)(pyr[next]->rows / pow(scale, i)), (int)(pyr[next]->cols / pow(scale, i)), CCV_INTER_AREA);
+		pyr[next + i] = ccv_pyramid_resample(pyramid, pyr[next], (int)(pyr[next]->rows / pow(scale, i)), (int)(pyr[next]->cols / pow(scale, i)), CCV_INTER_AREA);
 	for (i = next; i < scale_upto + next; i++)
-		ccv_sample_down(pyr[i], &pyr[i + next], 0, 0, 0);
-	ccv_dense_matrix_t* hog;
+		pyr[i + next] = ccv_pyramid_sample_down(pyramid, pyr[i], 0, 0);
+	ccv_dense_matrix_t** hog = (ccv_dense_matrix_t**)cccalloc(scale_upto + next * 2, sizeof(ccv_dense_matrix_t*));
 	/* a more efficient way to generate up-scaled hog (using smaller size) */
-	for (i = 0; i < next; i++)
-	{
-		hog = 0;
-		ccv_hog(pyr[i + next], &hog, 0, 9, CCV_DPM_WINDOW_SIZE / 2 /* this is */);
-		pyr[i] = hog;
-	}
-	hog = 0;
-	ccv_hog(pyr[next], &hog, 0, 9, CCV_DPM_WINDOW_SIZE);
-	pyr[next] = hog;
-	for (i = next + 1; i < scale_upto + next * 2; i++)
-	{
-		hog = 0;
-		ccv_hog(pyr[i], &hog, 0, 9, CCV_DPM_WINDOW_SIZE);
-		ccv_matrix_free(pyr[i]);
-		pyr[i] = hog;
-	}
+	ccv_hog_pyramid(pyr + next, hog, next, 0, 9, CCV_DPM_WINDOW_SIZE / 2);
+	ccv_hog_pyramid(pyr + next, hog + next, scale_upto + next, 0, 9, CCV_DPM_WINDOW_SIZE);
+	memcpy(pyr, hog, (scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
+	ccfree(hog);
 }
 
 static void _ccv_dpm_compute_score(ccv_dpm_root_classifier_t* root_classifier, ccv_dense_matrix_t* hog, ccv_dense_matrix_t* hog2x, ccv_dense_matrix_t** _response, ccv_dense_matrix_t** part_feature, ccv_dense_matrix_t** dx, ccv_dense_matrix_t** dy)
@@ -849,7 +838,9 @@ static ccv_dpm_feature_vector_t* _ccv_dpm_collect_best(ccv_dense_matrix_t* image
 	if (scale_upto < 0)
 		return 0;
 	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca((scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
-	_ccv_dpm_feature_pyramid(image, pyr, scale_upto, params.interval);
+	ccv_pyramid_t* pyramid = ccv_pyramid_new(image);
+	_ccv_dpm_feature_pyramid(pyramid, pyr, scale_upto, params.interval);
+	ccv_pyramid_free(pyramid);
 	float best = -FLT_MAX;
 	ccv_dpm_feature_vector_t* v = 0;
 	for (i = 0; i < model->count; i++)
@@ -929,7 +920,9 @@ static ccv_array_t* _ccv_dpm_collect_all(gsl_rng* rng, ccv_dense_matrix_t* image
 	if (scale_upto < 0)
 		return 0;
 	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca((scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
-	_ccv_dpm_feature_pyramid(image, pyr, scale_upto, params.interval);
+	ccv_pyramid_t* pyramid = ccv_pyramid_new(image);
+	_ccv_dpm_feature_pyramid(pyramid, pyr, scale_upto, params.interval);
+	ccv_pyramid_free(pyramid);
 	ccv_array_t* av = ccv_array_new(sizeof(ccv_dpm_feature_vector_t*), 64, 0);
 	int enough = 64 / model->count;
 	int* order = (int*)alloca(sizeof(int) * model->count);
@@ -2042,16 +2035,24 @@ static int _ccv_is_equal_same_class(const void* _r1, const void* _r2, void* data
 		(int)(r2->rect.height * 1.5 + 0.5) >= r1->rect.height;
 }
 
-ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model_t** _model, int count, ccv_dpm_param_t params)
+/* r2 has to be within distance of r1 to be equal, and vice versa */
+static ccv_rect_t _ccv_is_equal_bound(const void* _r, void* data)
+{
+	const ccv_root_comp_t* r = (const ccv_root_comp_t*)_r;
+	int distance = (int)(ccv_min(r->rect.width, r->rect.height) * 0.25 + 0.5);
+	return ccv_rect(r->rect.x - distance, r->rect.y - distance, distance * 2 + 1, distance * 2 + 1);
+}
+
+ccv_array_t* ccv_dpm_detect_objects_in_pyramid(ccv_pyramid_t* pyramid, ccv_dpm_mixture_model_t** _model, int count, ccv_dpm_param_t params)
 {
 	int c, i, j, k, x, y;
 	double scale = pow(2.0, 1.0 / (params.interval + 1.0));
 	int next = params.interval + 1;
-	int scale_upto = _ccv_dpm_scale_upto(a, _model, count, params.interval);
+	int scale_upto = _ccv_dpm_scale_upto(pyramid->a, _model, count, params.interval);
 	if (scale_upto < 0) // image is too small to be interesting
 		return 0;
 	ccv_dense_matrix_t** pyr = (ccv_dense_matrix_t**)alloca((scale_upto + next * 2) * sizeof(ccv_dense_matrix_t*));
-	_ccv_dpm_feature_pyramid(a, pyr, scale_upto, params.interval);
+	_ccv_dpm_feature_pyramid(pyramid, pyr, scale_upto, params.interval);
 	ccv_array_t* idx_seq;
 	ccv_array_t* seq = ccv_array_new(sizeof(ccv_root_comp_t), 64, 0);
 	ccv_array_t* seq2 = ccv_array_new(sizeof(ccv_root_comp_t), 64, 0);
@@ -2140,7 +2141,7 @@ ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model
 			idx_seq = 0;
 			ccv_array_clear(seq2);
 			// group retrieved rectangles in order to filter out noise
-			int ncomp = ccv_array_group(seq, &idx_seq, _ccv_is_equal_same_class, 0);
+			int ncomp = ccv_array_group_with_bound(seq, &idx_seq, _ccv_is_equal_same_class, _ccv_is_equal_bound, 0);
 			ccv_root_comp_t* comps = (ccv_root_comp_t*)ccmalloc((ncomp + 1) * sizeof(ccv_root_comp_t));
 			memset(comps, 0, (ncomp + 1) * sizeof(ccv_root_comp_t));
 
@@ -2241,7 +2242,7 @@ ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model
 		result_seq2 = ccv_array_new(sizeof(ccv_root_comp_t), 64, 0);
 		idx_seq = 0;
 		// group retrieved rectangles in order to filter out noise
-		int ncomp = ccv_array_group(result_seq, &idx_seq, _ccv_is_equal, 0);
+		int ncomp = ccv_array_group_with_bound(result_seq, &idx_seq, _ccv_is_equal, _ccv_is_equal_bound, 0);
 		ccv_root_comp_t* comps = (ccv_root_comp_t*)ccmalloc((ncomp + 1) * sizeof(ccv_root_comp_t));
 		memset(comps, 0, (ncomp + 1) * sizeof(ccv_root_comp_t));
 
@@ -2276,6 +2277,14 @@ ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model
 	return result_seq2;
 }
 
+ccv_array_t* ccv_dpm_detect_objects(ccv_dense_matrix_t* a, ccv_dpm_mixture_model_t** _model, int count, ccv_dpm_param_t params)
+{
+	ccv_pyramid_t* pyramid = ccv_pyramid_new(a);
+	ccv_array_t* result_seq = ccv_dpm_detect_objects_in_pyramid(pyramid, _model, count, params);
+	ccv_pyramid_free(pyramid);
+	return result_seq;
+}
+
 ccv_dpm_mixture_model_t* ccv_dpm_read_mixture_model(const char* directory)
 {
 	FILE* r = fopen(directory, "r");
@@ -2341,7 +2350,8 @@ ccv_dpm_mixture_model_t* ccv_dpm_read_mixture_model(const char* directory)
 		model->root[i].root.w = (ccv_dense_matrix_t*)m;
 		m += ccv_compute_dense_matrix_size(w->rows, w->cols, w->type);
 		memcpy(model->root[i].root.w, w, ccv_compute_dense_matrix_size(w->rows, w->cols, w->type));
-		model->root[i].root.w->data.u8 = (unsigned char*)(model->root[i].root.w + 1);
+		// the data is not right after the header, it is aligned, keep it at the same offset
+		model->root[i].root.w->data.u8 = (unsigned char*)model->root[i].root.w + (w->data.u8 - (unsigned char*)w);
 		ccfree(w);
 		for (j = 0; j < model->root[i].count; j++)
 		{
@@ -2349,7 +2359,7 @@ ccv_dpm_mixture_model_t* ccv_dpm_read_mixture_model(const char* directory)
 			model->root[i].part[j].w = (ccv_dense_matrix_t*)m;
 			m += ccv_compute_dense_matrix_size(w->rows, w->cols, w->type);
 			memcpy(model->root[i].part[j].w, w, ccv_compute_dense_matrix_size(w->rows, w->cols, w->type));
-			model->root[i].part[j].w->data.u8 = (unsigned char*)(model->root[i].part[j].w + 1);
+			model->root[i].part[j].w->data.u8 = (unsigned char*)model->root[i].part[j].w + (w->data.u8 - (unsigned char*)w);
 			ccfree(w);
 		}
 	}
@@ -27,7 +27,7 @@ static int _CCV_PRINT_LOOP __attribute__ ((unused)) = 0;
 #define unroll_endfor }
 #ifdef USE_OPENMP
 #define OMP_PRAGMA0(x) MACRO_STRINGIFY(omp parallel for private(x) schedule(dynamic))
-#define parallel_for(x, n) { int x = 0; _Pragma(OMP_PRAGMA0(x)) for ((x) = 0; (x) < (n); (x)++) {
+#define parallel_for(x, n) { int x = 0; _Pragma(OMP_PRAGMA0(x)) for (x = 0; x < (n); x++) {
 #define parallel_endfor } }
 #define FOR_IS_PARALLEL (1)
 #else
@@ -673,4 +673,8 @@ T func_name(T* buf, int low, int high) \
 	}                                                \
 }
 
+/* shared by ccv_color_transform and image decoders, converts a row of 8-bit RGB pixels (stride is 3 or 4 bytes per pixel,
+ * ri, gi, bi are offsets of red, green and blue within a pixel) into 8-bit gray */
+void ccv_rgb_to_gray_8u(const unsigned char* rgb, const int stride, const int ri, const int gi, const int bi, unsigned char* gray, const int count);
+
 #endif
@@ -26,13 +26,20 @@
 #if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
 #include <sys/param.h>
 #endif
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 #include "io/_ccv_io_bmp.inc"
 #include "io/_ccv_io_binary.inc"
 #include "io/_ccv_io_raw.inc"
 
-static int _ccv_read_and_close_fd(FILE* fd, ccv_dense_matrix_t** x, int type)
+static int _ccv_read_and_close_fd(FILE* fd, ccv_dense_matrix_t** x, int type, int max_dimension)
 {
 	int ctype = (type & 0xF00) ? CCV_8U | ((type & 0xF00) >> 8) : 0;
+	const int no_copy = type & CCV_IO_NO_COPY;
 	if ((type & 0XFF) == CCV_IO_ANY_FILE)
 	{
 		unsigned char sig[8];
@@ -51,7 +58,7 @@ static int _ccv_read_and_close_fd(FILE* fd, ccv_dense_matrix_t** x, int type)
 	{
 #ifdef HAVE_LIBJPEG
 		case CCV_IO_JPEG_FILE:
-			_ccv_read_jpeg_fd(fd, x, ctype);
+			_ccv_read_jpeg_fd(fd, x, ctype, max_dimension);
 			break;
 #endif
 #ifdef HAVE_LIBPNG
@@ -63,6 +70,13 @@ static int _ccv_read_and_close_fd(FILE* fd, ccv_dense_matrix_t** x, int type)
 			_ccv_read_bmp_fd(fd, x, ctype);
 			break;
 		case CCV_IO_BINARY_FILE:
+			if (no_copy && _ccv_map_binary_fd(fd, x))
+			{
+				// hashing the content for the signature would touch every page, thus, leave it without one
+				if (type & CCV_IO_ANY_FILE)
+					fclose(fd);
+				return CCV_IO_FINAL;
+			}
 			_ccv_read_binary_fd(fd, x, ctype);
 	}
 	if (*x != 0)
@@ -172,7 +186,7 @@ static fpos_t seekfn(void* context, fpos_t off, int whence)
 }
 #endif
 
-int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, int cols, int scanline)
+static int _ccv_read(const void* in, ccv_dense_matrix_t** x, int type, int rows, int cols, int scanline, int max_dimension)
 {
 	FILE* fd = 0;
 	if (type & CCV_IO_ANY_FILE)
@@ -181,7 +195,7 @@ int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, in
 		fd = fopen((const char*)in, "rb");
 		if (!fd)
 			return CCV_IO_ERROR;
-		return _ccv_read_and_close_fd(fd, x, type);
+		return _ccv_read_and_close_fd(fd, x, type, max_dimension);
 	} else if (type & CCV_IO_ANY_STREAM) {
 		assert(rows > 8 && cols == 0 && scanline == 0);
 		assert((type & 0xFF) != CCV_IO_DEFLATE_STREAM); // deflate stream (compressed stream) is not supported yet
@@ -201,7 +215,7 @@ int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, in
 			return CCV_IO_ERROR;
 		// mimicking itself as a "file"
 		type = (type & ~0x10) | 0x20;
-		return _ccv_read_and_close_fd(fd, x, type);
+		return _ccv_read_and_close_fd(fd, x, type, max_dimension);
 #endif
 	} else if (type & CCV_IO_ANY_RAW) {
 		return _ccv_read_raw(x, (void*)in /* it can be modifiable if it is NO_COPY mode */, type, rows, cols, scanline);
@@ -209,6 +223,82 @@ int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, in
 	return CCV_IO_UNKNOWN;
 }
 
+int ccv_read_impl(const void* in, ccv_dense_matrix_t** x, int type, int rows, int cols, int scanline)
+{
+	return _ccv_read(in, x, type, rows, cols, scanline, 0);
+}
+
+int ccv_read_scaled(const void* in, ccv_dense_matrix_t** x, int type, int size, int max_dimension)
+{
+	assert((type & CCV_IO_ANY_FILE) || (type & CCV_IO_ANY_STREAM));
+	return _ccv_read(in, x, type, size, 0, 0, max_dimension);
+}
+
+typedef struct {
+	const void* const* ins;
+	const int* sizes;
+	int count;
+	ccv_dense_matrix_t** xs;
+	int* status;
+	int type;
+	int max_dimension;
+	int next;
+} ccv_read_batch_t;
+
+static void* _ccv_read_batch_worker(void* context)
+{
+	ccv_read_batch_t* batch = (ccv_read_batch_t*)context;
+	for (;;)
+	{
+		// images vary in size, thus, hand them out one at a time rather than in fixed chunks
+		const int i = __sync_fetch_and_add(&batch->next, 1);
+		if (i >= batch->count)
+			break;
+		batch->xs[i] = 0;
+		int status = _ccv_read(batch->ins[i], batch->xs + i, batch->type, batch->sizes ? batch->sizes[i] : 0, 0, 0, batch->max_dimension);
+		// CCV_IO_UNKNOWN (such as streams without fmemopen / funopen) and the like are errors to the caller
+		if (status != CCV_IO_FINAL || batch->xs[i] == 0)
+			status = CCV_IO_ERROR;
+		if (batch->status)
+			batch->status[i] = status;
+	}
+	return 0;
+}
+
+void ccv_read_batch(const void* const* ins, const int* sizes, int count, ccv_dense_matrix_t** xs, int* status, int type, int max_dimension, int threads)
+{
+	assert((type & CCV_IO_ANY_FILE) || (type & CCV_IO_ANY_STREAM));
+	ccv_read_batch_t batch = {
+		.ins = ins,
+		.sizes = sizes,
+		.count = count,
+		.xs = xs,
+		.status = status,
+		.type = type,
+		.max_dimension = max_dimension,
+		.next = 0,
+	};
+#ifdef HAVE_PTHREAD
+	if (threads <= 0)
+		threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	threads = ccv_min(threads, count);
+	int i;
+	pthread_t* workers = threads > 1 ? (pthread_t*)ccmalloc(sizeof(pthread_t) * (threads - 1)) : 0;
+	// the calling thread is one of the workers
+	for (i = 0; i < threads - 1; i++)
+		if (pthread_create(workers + i, 0, _ccv_read_batch_worker, &batch) != 0)
+			break;
+	threads = i + 1;
+	_ccv_read_batch_worker(&batch);
+	for (i = 0; i < threads - 1; i++)
+		pthread_join(workers[i], 0);
+	if (workers)
+		ccfree(workers);
+#else
+	_ccv_read_batch_worker(&batch);
+#endif
+}
+
 int ccv_write(ccv_dense_matrix_t* mat, char* out, int* len, int type, void* conf)
 {
 	FILE* fd = 0;
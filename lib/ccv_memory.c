@@ -1,6 +1,15 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 #include "3rdparty/siphash/siphash24.h"
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 static __thread ccv_cache_t ccv_cache;
 
@@ -13,13 +22,464 @@ static __thread ccv_cache_t ccv_cache;
 /* option to enable/disable cache */
 static __thread int ccv_cache_opt = 0;
 
+/* the shared cache is split into shards by the top bits of the signature (the radix tree consumes
+ * the signature from the lowest bits, thus, the two are independent), each shard has its own lock.
+ * The memory budget is global: a shard can take up to all of it, the total of all shards is kept in
+ * ccv_shared_cache_size, and when a put goes over the budget, the shards shrink to fit (see
+ * _ccv_shared_cache_shrink) */
+#define CCV_SHARED_CACHE_SHARDS (16)
+#define CCV_SHARED_CACHE_SHARD(sig) ((sig) >> 60)
+
+typedef struct {
+	ccv_cache_t cache;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t mutex;
+#endif
+} ccv_cache_shard_t;
+
+static ccv_cache_shard_t ccv_shared_cache[CCV_SHARED_CACHE_SHARDS];
+static int ccv_shared_cache_opt = 0;
+static size_t ccv_shared_cache_up = 0;
+static size_t ccv_shared_cache_size = 0;
+
+static void* _ccv_cache_out(uint64_t sig, uint8_t* type)
+{
+	if (ccv_cache_opt)
+		return ccv_cache_out(&ccv_cache, sig, type);
+	ccv_cache_shard_t* shard = ccv_shared_cache + CCV_SHARED_CACHE_SHARD(sig);
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&shard->mutex);
+#endif
+	const size_t before = shard->cache.size;
+	void* x = ccv_cache_out(&shard->cache, sig, type);
+	const size_t after = shard->cache.size;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&shard->mutex);
+#endif
+	__sync_sub_and_fetch(&ccv_shared_cache_size, before - after);
+	return x;
+}
+
+static size_t _ccv_shared_cache_shard_size(int i)
+{
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&ccv_shared_cache[i].mutex);
+#endif
+	const size_t size = ccv_shared_cache[i].cache.size;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&ccv_shared_cache[i].mutex);
+#endif
+	return size;
+}
+
+/* evict from the other shards in proportion to their size until the total fits the budget, the shard
+ * just put into (last) is the last resort, thus, the object just put stays unless it has to go. Only
+ * one lock is held at a time */
+static void _ccv_shared_cache_shrink(int last)
+{
+	size_t total = __sync_add_and_fetch(&ccv_shared_cache_size, 0);
+	if (total <= ccv_shared_cache_up)
+		return;
+	const size_t last_size = _ccv_shared_cache_shard_size(last);
+	const size_t others = total > last_size ? total - last_size : 0;
+	int i;
+	for (i = 1; i <= CCV_SHARED_CACHE_SHARDS; i++)
+	{
+		total = __sync_add_and_fetch(&ccv_shared_cache_size, 0);
+		if (total <= ccv_shared_cache_up)
+			return;
+		const size_t excess = total - ccv_shared_cache_up;
+		ccv_cache_shard_t* shard = ccv_shared_cache + (last + i) % CCV_SHARED_CACHE_SHARDS;
+#ifdef HAVE_PTHREAD
+		pthread_mutex_lock(&shard->mutex);
+#endif
+		const size_t before = shard->cache.size;
+		// the share of this shard, rounds up, thus, the shares of the other shards add up to the excess
+		size_t share = (i == CCV_SHARED_CACHE_SHARDS || others == 0) ? excess : (size_t)ceil((double)excess * before / others);
+		ccv_cache_shrink(&shard->cache, before - ccv_min(share, before));
+		const size_t after = shard->cache.size;
+#ifdef HAVE_PTHREAD
+		pthread_mutex_unlock(&shard->mutex);
+#endif
+		__sync_sub_and_fetch(&ccv_shared_cache_size, before - after);
+	}
+}
+
+static int _ccv_cache_put(uint64_t sig, void* x, uint32_t size, uint8_t type, uint64_t cost)
+{
+	if (ccv_cache_opt)
+		return ccv_cache_put_with_cost(&ccv_cache, sig, x, size, type, cost);
+	ccv_cache_shard_t* shard = ccv_shared_cache + CCV_SHARED_CACHE_SHARD(sig);
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&shard->mutex);
+#endif
+	const size_t before = shard->cache.size;
+	int status = ccv_cache_put_with_cost(&shard->cache, sig, x, size, type, cost);
+	const size_t after = shard->cache.size;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&shard->mutex);
+#endif
+	// the size of this shard can go either way, it may replace or evict objects to make room
+	if (__sync_add_and_fetch(&ccv_shared_cache_size, after - before) > ccv_shared_cache_up)
+		_ccv_shared_cache_shrink(CCV_SHARED_CACHE_SHARD(sig));
+	return status;
+}
+
+/* recompute cost hints of recently computed matrices, in a direct-mapped table */
+#define CCV_CACHE_COST_HINTS (1024)
+
+static __thread struct {
+	uint64_t sig;
+	uint64_t cost;
+} ccv_cache_cost_hints[CCV_CACHE_COST_HINTS];
+
+void ccv_cache_cost_hint(uint64_t sig, uint64_t cost)
+{
+	if (sig == 0)
+		return;
+	const int i = sig % CCV_CACHE_COST_HINTS;
+	ccv_cache_cost_hints[i].sig = sig;
+	ccv_cache_cost_hints[i].cost = cost;
+}
+
+static uint64_t _ccv_cache_cost_of(uint64_t sig)
+{
+	const int i = sig % CCV_CACHE_COST_HINTS;
+	return ccv_cache_cost_hints[i].sig == sig ? ccv_cache_cost_hints[i].cost : 0;
+}
+
+/* optionally, attribute cache lookups to the operation that derived the signature. The operation name
+ * is taken from the message of ccv_cache_generate_signature (such as "ccv_sobel(1,0)"), signatures
+ * derived from non-text messages (ccv_dense_matrix_renew for example) inherit it from the input signature.
+ * Only recently generated signatures are remembered, in a direct-mapped table. */
+#define CCV_CACHE_ORIGIN_MAX (64)
+#define CCV_CACHE_ORIGIN_RECENT (4096)
+
+typedef struct {
+	int rnum;
+	ccv_cache_origin_stats_t origins[CCV_CACHE_ORIGIN_MAX]; // 0 is for unknown origin
+	struct {
+		uint64_t sig;
+		int origin;
+	} recent[CCV_CACHE_ORIGIN_RECENT];
+} ccv_cache_origin_t;
+
+static __thread ccv_cache_origin_t* ccv_cache_origin = 0;
+
+static int _ccv_cache_origin_of(uint64_t sig)
+{
+	const int i = sig % CCV_CACHE_ORIGIN_RECENT;
+	return ccv_cache_origin->recent[i].sig == sig ? ccv_cache_origin->recent[i].origin : 0;
+}
+
+static void _ccv_cache_origin_record(uint64_t sig, const char* msg, int len, uint64_t sig_start)
+{
+	int i, n = 0;
+	while (n < len && n < sizeof(ccv_cache_origin->origins[0].name) - 1 && (isalnum((unsigned char)msg[n]) || msg[n] == '_'))
+		++n;
+	int origin = 0;
+	if (n > 0 && n < len && msg[n] == '(')
+	{
+		for (i = 1; i < ccv_cache_origin->rnum; i++)
+			if (strncmp(ccv_cache_origin->origins[i].name, msg, n) == 0 && ccv_cache_origin->origins[i].name[n] == 0)
+			{
+				origin = i;
+				break;
+			}
+		if (!origin && ccv_cache_origin->rnum < CCV_CACHE_ORIGIN_MAX)
+		{
+			origin = ccv_cache_origin->rnum++;
+			memcpy(ccv_cache_origin->origins[origin].name, msg, n);
+			ccv_cache_origin->origins[origin].name[n] = 0;
+		}
+	} else if (sig_start != 0)
+		origin = _ccv_cache_origin_of(sig_start);
+	i = sig % CCV_CACHE_ORIGIN_RECENT;
+	ccv_cache_origin->recent[i].sig = sig;
+	ccv_cache_origin->recent[i].origin = origin;
+}
+
+static void _ccv_cache_origin_lookup(uint64_t sig, void* x, size_t size)
+{
+	ccv_cache_origin_stats_t* stats = ccv_cache_origin->origins + _ccv_cache_origin_of(sig);
+	if (x)
+	{
+		++stats->hit;
+		stats->saved += size;
+	} else
+		++stats->miss;
+}
+
+/* matrices are recycled through per-thread free lists of size classes when the matrix pool is enabled.
+ * there are 4 size classes between two powers of two, from 128 bytes up to 64MiB, larger ones go to
+ * ccmalloc directly. Pooled blocks are still plain ccmalloc blocks, the size class they belong to is
+ * tagged in the padding between the header and the data section. */
+#define CCV_MATRIX_POOL_MIN_SHIFT (7)
+#define CCV_MATRIX_POOL_MAX_SHIFT (26)
+#define CCV_MATRIX_POOL_CLASSES ((CCV_MATRIX_POOL_MAX_SHIFT - CCV_MATRIX_POOL_MIN_SHIFT) * 4 + 1)
+#define CCV_MATRIX_POOL_MAGIC (0x636376706f6f6c00) // "ccvpool\0"
+#define CCV_MATRIX_POOL_HAS_TAG ((((sizeof(ccv_dense_matrix_t) + 15) & -16) - sizeof(ccv_dense_matrix_t)) >= sizeof(uint64_t))
+#define CCV_MATRIX_POOL_TAG(mat) (*(uint64_t*)((unsigned char*)(mat) + sizeof(ccv_dense_matrix_t)))
+
+typedef struct {
+	void* head[CCV_MATRIX_POOL_CLASSES];
+	size_t size;
+	size_t up;
+	ccv_matrix_pool_stats_t stats;
+} ccv_matrix_pool_t;
+
+static __thread ccv_matrix_pool_t ccv_matrix_pool;
+static __thread int ccv_matrix_pool_opt = 0;
+
+static size_t _ccv_matrix_pool_class_size(int c)
+{
+	if (c == 0)
+		return (size_t)1 << CCV_MATRIX_POOL_MIN_SHIFT;
+	const int k = (c - 1) / 4 + CCV_MATRIX_POOL_MIN_SHIFT;
+	return ((size_t)1 << k) + ((size_t)((c - 1) % 4 + 1) << (k - 2));
+}
+
+static int _ccv_matrix_pool_class(size_t size)
+{
+	if (size <= ((size_t)1 << CCV_MATRIX_POOL_MIN_SHIFT))
+		return 0;
+	const int k = 63 - __builtin_clzll((unsigned long long)(size - 1)); // size - 1 is in [2^k, 2^(k + 1))
+	if (k >= CCV_MATRIX_POOL_MAX_SHIFT)
+		return -1;
+	const int j = (int)((size - 1 - ((size_t)1 << k)) >> (k - 2));
+	return (k - CCV_MATRIX_POOL_MIN_SHIFT) * 4 + j + 1;
+}
+
+static void* _ccv_matrix_pool_alloc(size_t size)
+{
+	if (!ccv_matrix_pool_opt || !CCV_MATRIX_POOL_HAS_TAG)
+	{
+		void* x = ccmalloc(size);
+		if (CCV_MATRIX_POOL_HAS_TAG)
+			CCV_MATRIX_POOL_TAG(x) = 0;
+		return x;
+	}
+	++ccv_matrix_pool.stats.alloc;
+	const int c = _ccv_matrix_pool_class(size);
+	if (c < 0)
+	{
+		++ccv_matrix_pool.stats.malloc;
+		void* x = ccmalloc(size);
+		CCV_MATRIX_POOL_TAG(x) = 0;
+		return x;
+	}
+	const size_t class_size = _ccv_matrix_pool_class_size(c);
+	void* x = ccv_matrix_pool.head[c];
+	if (x)
+	{
+		ccv_matrix_pool.head[c] = *(void**)x;
+		ccv_matrix_pool.size -= class_size;
+		++ccv_matrix_pool.stats.reuse;
+	} else {
+		x = ccmalloc(class_size);
+		++ccv_matrix_pool.stats.malloc;
+	}
+	CCV_MATRIX_POOL_TAG(x) = CCV_MATRIX_POOL_MAGIC | c;
+	return x;
+}
+
+static void _ccv_matrix_pool_free(ccv_dense_matrix_t* mat)
+{
+	if (!ccv_matrix_pool_opt || !CCV_MATRIX_POOL_HAS_TAG || (mat->type & CCV_NO_DATA_ALLOC) ||
+		(CCV_MATRIX_POOL_TAG(mat) & ~(uint64_t)0xff) != CCV_MATRIX_POOL_MAGIC)
+	{
+		ccfree(mat);
+		return;
+	}
+	const int c = (int)(CCV_MATRIX_POOL_TAG(mat) & 0xff);
+	assert(c < CCV_MATRIX_POOL_CLASSES);
+	const size_t class_size = _ccv_matrix_pool_class_size(c);
+	if (ccv_matrix_pool.size + class_size > ccv_matrix_pool.up)
+	{
+		++ccv_matrix_pool.stats.free;
+		ccfree(mat);
+		return;
+	}
+	++ccv_matrix_pool.stats.recycle;
+	*(void**)mat = ccv_matrix_pool.head[c];
+	ccv_matrix_pool.head[c] = mat;
+	ccv_matrix_pool.size += class_size;
+}
+
+/* a header-only matrix can have its data section in a memory-mapped region that is released along with it
+ * (see ccv_dense_matrix_new_mapped), it is tagged at the same place as the matrix pool does */
+#define CCV_MATRIX_MAPPED_MAGIC (0x6363766d6d617000) // "ccvmmap\0"
+
+typedef struct {
+	ccv_dense_matrix_t mat;
+	uint64_t tag;
+	void* map;
+	size_t size;
+} ccv_dense_matrix_mapped_t;
+
+static void _ccv_dense_matrix_free(ccv_dense_matrix_t* mat)
+{
+	if ((mat->type & CCV_NO_DATA_ALLOC) && CCV_MATRIX_POOL_TAG(mat) == CCV_MATRIX_MAPPED_MAGIC)
+	{
+		ccv_dense_matrix_mapped_t* mapped = (ccv_dense_matrix_mapped_t*)mat;
+		munmap(mapped->map, mapped->size);
+		ccfree(mapped);
+		return;
+	}
+	_ccv_matrix_pool_free(mat);
+}
+
+/* the disk cache is a file mapped into memory, it is an open-addressing index of signatures followed
+ * by an append-only data section. When either is full, the file starts over. It is shared by all threads
+ * and processes opened it: processes take turns with flock, and since flock is held per open file, threads
+ * within a process take turns with a mutex as well. Signatures are derived from the content (see
+ * ccv_make_matrix_immutable) and the operations, thus, they are still valid after restart. */
+#define CCV_DISK_CACHE_MAGIC (0x434b534944564343) // "CCVDISKC"
+#define CCV_DISK_CACHE_MIN_SIZE (1024 * 1024)
+
+typedef struct {
+	uint64_t magic;
+	uint64_t size;
+	uint64_t tail;
+	uint32_t slots;
+	uint32_t rnum;
+} ccv_disk_cache_header_t;
+
+typedef struct {
+	uint64_t sig;
+	uint64_t off;
+	int type;
+	int rows;
+	int cols;
+	uint32_t size;
+} ccv_disk_cache_index_t;
+
+typedef struct {
+	int fd;
+	size_t size;
+	unsigned char* data;
+	ccv_disk_cache_header_t* header;
+	ccv_disk_cache_index_t* index;
+	ccv_disk_cache_stats_t stats;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t mutex;
+#endif
+} ccv_disk_cache_t;
+
+static ccv_disk_cache_t ccv_disk_cache;
+static int ccv_disk_cache_opt = 0;
+
+static void _ccv_disk_cache_lock(void)
+{
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&ccv_disk_cache.mutex);
+#endif
+	flock(ccv_disk_cache.fd, LOCK_EX);
+}
+
+static void _ccv_disk_cache_unlock(void)
+{
+	flock(ccv_disk_cache.fd, LOCK_UN);
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&ccv_disk_cache.mutex);
+#endif
+}
+
+static uint64_t _ccv_disk_cache_data_start(uint32_t slots)
+{
+	return (sizeof(ccv_disk_cache_header_t) + sizeof(ccv_disk_cache_index_t) * slots + 63) & -64;
+}
+
+static void _ccv_disk_cache_reset(ccv_disk_cache_header_t* header, size_t size)
+{
+	// one slot for every 16KiB of data on average
+	uint32_t slots = 64;
+	while ((uint64_t)slots * 2 <= size / (16 * 1024) && slots < 0x40000000)
+		slots *= 2;
+	memset(header + 1, 0, sizeof(ccv_disk_cache_index_t) * slots);
+	header->size = size;
+	header->slots = slots;
+	header->rnum = 0;
+	header->tail = _ccv_disk_cache_data_start(slots);
+	header->magic = CCV_DISK_CACHE_MAGIC;
+}
+
+static ccv_disk_cache_index_t* _ccv_disk_cache_seek(uint64_t sig)
+{
+	const uint32_t mask = ccv_disk_cache.header->slots - 1;
+	// the radix tree of the in-memory cache uses the lower bits, it doesn't matter here, but mix them up anyway
+	uint32_t i = (uint32_t)(sig ^ (sig >> 32)) & mask;
+	for (;;)
+	{
+		ccv_disk_cache_index_t* idx = ccv_disk_cache.index + i;
+		if (idx->sig == sig || idx->sig == 0)
+			return idx;
+		i = (i + 1) & mask;
+	}
+}
+
+static int _ccv_disk_cache_read(ccv_dense_matrix_t* mat)
+{
+	const size_t size = (size_t)mat->rows * mat->step;
+	int found = 0;
+	_ccv_disk_cache_lock();
+	ccv_disk_cache_index_t* idx = _ccv_disk_cache_seek(mat->sig);
+	if (idx->sig == mat->sig && idx->type == (CCV_GET_DATA_TYPE(mat->type) | CCV_GET_CHANNEL(mat->type)) &&
+		idx->rows == mat->rows && idx->cols == mat->cols && idx->size == size)
+	{
+		memcpy(mat->data.u8, ccv_disk_cache.data + idx->off, size);
+		found = 1;
+		++ccv_disk_cache.stats.hit;
+	} else
+		++ccv_disk_cache.stats.miss;
+	_ccv_disk_cache_unlock();
+	return found;
+}
+
+static void _ccv_disk_cache_write(ccv_dense_matrix_t* mat)
+{
+	const size_t size = (size_t)mat->rows * mat->step;
+	_ccv_disk_cache_lock();
+	ccv_disk_cache_header_t* header = ccv_disk_cache.header;
+	if (size > 0xFFFFFFFF || size > header->size - _ccv_disk_cache_data_start(header->slots))
+	{
+		_ccv_disk_cache_unlock();
+		return;
+	}
+	ccv_disk_cache_index_t* idx = _ccv_disk_cache_seek(mat->sig);
+	if (idx->sig == mat->sig) // another thread or process has done the same
+	{
+		_ccv_disk_cache_unlock();
+		return;
+	}
+	if (header->tail + size > header->size || (header->rnum + 1) * 4 > header->slots * 3)
+	{
+		_ccv_disk_cache_reset(header, header->size);
+		++ccv_disk_cache.stats.reset;
+		idx = _ccv_disk_cache_seek(mat->sig);
+	}
+	memcpy(ccv_disk_cache.data + header->tail, mat->data.u8, size);
+	idx->off = header->tail;
+	idx->type = CCV_GET_DATA_TYPE(mat->type) | CCV_GET_CHANNEL(mat->type);
+	idx->rows = mat->rows;
+	idx->cols = mat->cols;
+	idx->size = (uint32_t)size;
+	idx->sig = mat->sig;
+	header->tail = (header->tail + size + 15) & -16;
+	++header->rnum;
+	++ccv_disk_cache.stats.put;
+	_ccv_disk_cache_unlock();
+}
+
 ccv_dense_matrix_t* ccv_dense_matrix_new(int rows, int cols, int type, void* data, uint64_t sig)
 {
 	ccv_dense_matrix_t* mat;
-	if (ccv_cache_opt && sig != 0 && !data && !(type & CCV_NO_DATA_ALLOC))
+	if ((ccv_cache_opt || ccv_shared_cache_opt) && sig != 0 && !data && !(type & CCV_NO_DATA_ALLOC))
 	{
-		uint8_t type;
-		mat = (ccv_dense_matrix_t*)ccv_cache_out(&ccv_cache, sig, &type);
+		uint8_t type = 0;
+		mat = (ccv_dense_matrix_t*)_ccv_cache_out(sig, &type);
+		if (ccv_cache_origin)
+			_ccv_cache_origin_lookup(sig, mat, mat ? ccv_compute_dense_matrix_size(mat->rows, mat->cols, mat->type) : 0);
 		if (mat)
 		{
 			assert(type == 0);
@@ -30,12 +490,14 @@ ccv_dense_matrix_t* ccv_dense_matrix_new(int rows, int cols, int type, void* dat
 	}
 	if (type & CCV_NO_DATA_ALLOC)
 	{
-		mat = (ccv_dense_matrix_t*)ccmalloc(sizeof(ccv_dense_matrix_t));
+		// leave room for the tag, thus, it is safe to check whether this is a mapped one when freeing
+		mat = (ccv_dense_matrix_t*)ccmalloc(sizeof(ccv_dense_matrix_t) + sizeof(uint64_t));
+		CCV_MATRIX_POOL_TAG(mat) = 0;
 		mat->type = (CCV_GET_CHANNEL(type) | CCV_GET_DATA_TYPE(type) | CCV_MATRIX_DENSE | CCV_NO_DATA_ALLOC) & ~CCV_GARBAGE;
 		mat->data.u8 = data;
 	} else {
 		const size_t hdr_size = (sizeof(ccv_dense_matrix_t) + 15) & -16;
-		mat = (ccv_dense_matrix_t*)(data ? data : ccmalloc(ccv_compute_dense_matrix_size(rows, cols, type)));
+		mat = (ccv_dense_matrix_t*)(data ? data : _ccv_matrix_pool_alloc(ccv_compute_dense_matrix_size(rows, cols, type)));
 		mat->type = (CCV_GET_CHANNEL(type) | CCV_GET_DATA_TYPE(type) | CCV_MATRIX_DENSE) & ~CCV_GARBAGE;
 		mat->type |= data ? CCV_UNMANAGED : CCV_REUSABLE; // it still could be reusable because the signature could be derived one.
 		mat->data.u8 = (unsigned char*)mat + hdr_size;
@@ -54,6 +516,36 @@ ccv_dense_matrix_t* ccv_dense_matrix_new(int rows, int cols, int type, void* dat
 	mat->cols = cols;
 	mat->step = CCV_GET_STEP(cols, type);
 	mat->refcount = 1;
+	if (ccv_disk_cache_opt && sig != 0 && !data && !(type & CCV_NO_DATA_ALLOC) && _ccv_disk_cache_read(mat))
+		mat->type |= CCV_GARBAGE; // same as the one from recycle-bin
+	return mat;
+}
+
+ccv_dense_matrix_t* ccv_dense_matrix_new_mapped(int rows, int cols, int type, void* map, size_t size, size_t offset)
+{
+	assert(offset + (size_t)rows * CCV_GET_STEP(cols, type) <= size);
+	ccv_dense_matrix_mapped_t* mapped = (ccv_dense_matrix_mapped_t*)ccmalloc(sizeof(ccv_dense_matrix_mapped_t));
+	ccv_dense_matrix_t* mat = &mapped->mat;
+	mat->type = (CCV_GET_CHANNEL(type) | CCV_GET_DATA_TYPE(type) | CCV_MATRIX_DENSE | CCV_NO_DATA_ALLOC) & ~CCV_GARBAGE;
+	mat->data.u8 = (unsigned char*)map + offset;
+	mat->sig = 0;
+#if CCV_NNC_TENSOR_TFB
+	mat->reserved0 = 0;
+	mat->resides = CCV_TENSOR_CPU_MEMORY;
+	mat->format = CCV_TENSOR_FORMAT_NHWC;
+	mat->datatype = CCV_GET_DATA_TYPE(type);
+	mat->channels = CCV_GET_CHANNEL(type);
+	mat->reserved1 = 0;
+	mat->reserved2 = 0;
+#endif
+	mat->rows = rows;
+	mat->cols = cols;
+	mat->step = CCV_GET_STEP(cols, type);
+	mat->refcount = 1;
+	assert(&mapped->tag == &CCV_MATRIX_POOL_TAG(mat));
+	mapped->tag = CCV_MATRIX_MAPPED_MAGIC;
+	mapped->map = map;
+	mapped->size = size;
 	return mat;
 }
 
@@ -148,7 +640,7 @@ void ccv_matrix_free_immediately(ccv_matrix_t* mat)
 	{
 		ccv_dense_matrix_t* dmt = (ccv_dense_matrix_t*)mat;
 		dmt->refcount = 0;
-		ccfree(dmt);
+		_ccv_dense_matrix_free(dmt);
 	} else if (type & CCV_MATRIX_SPARSE) {
 		ccv_sparse_matrix_t* smt = (ccv_sparse_matrix_t*)mat;
 		int i;
@@ -172,11 +664,13 @@ void ccv_matrix_free(ccv_matrix_t* mat)
 	{
 		ccv_dense_matrix_t* dmt = (ccv_dense_matrix_t*)mat;
 		dmt->refcount = 0;
-		if (!ccv_cache_opt || // e don't enable cache
+		if (ccv_disk_cache_opt && (dmt->type & CCV_REUSABLE) && dmt->sig != 0 && !(dmt->type & CCV_NO_DATA_ALLOC))
+			_ccv_disk_cache_write(dmt);
+		if (!(ccv_cache_opt || ccv_shared_cache_opt) || // e don't enable cache
 			!(dmt->type & CCV_REUSABLE) || // or this is not a reusable piece
 			dmt->sig == 0 || // or this doesn't have valid signature
 			(dmt->type & CCV_NO_DATA_ALLOC)) // or this matrix is allocated as header-only, therefore we cannot cache it
-			ccfree(dmt);
+			_ccv_dense_matrix_free(dmt);
 		else {
 			assert(CCV_GET_DATA_TYPE(dmt->type) == CCV_8U ||
 				   CCV_GET_DATA_TYPE(dmt->type) == CCV_32S ||
@@ -184,7 +678,10 @@ void ccv_matrix_free(ccv_matrix_t* mat)
 				   CCV_GET_DATA_TYPE(dmt->type) == CCV_64S ||
 				   CCV_GET_DATA_TYPE(dmt->type) == CCV_64F);
 			size_t size = ccv_compute_dense_matrix_size(dmt->rows, dmt->cols, dmt->type);
-			ccv_cache_put(&ccv_cache, dmt->sig, dmt, size, 0 /* type 0 */);
+			if (ccv_cache_origin)
+				++ccv_cache_origin->origins[_ccv_cache_origin_of(dmt->sig)].put;
+			if (_ccv_cache_put(dmt->sig, dmt, size, 0 /* type 0 */, _ccv_cache_cost_of(dmt->sig)) < 0) // too large to fit in the cache
+				_ccv_dense_matrix_free(dmt);
 		}
 	} else if (type & CCV_MATRIX_SPARSE) {
 		ccv_sparse_matrix_t* smt = (ccv_sparse_matrix_t*)mat;
@@ -207,10 +704,12 @@ void ccv_matrix_free(ccv_matrix_t* mat)
 ccv_array_t* ccv_array_new(int rsize, int rnum, uint64_t sig)
 {
 	ccv_array_t* array;
-	if (ccv_cache_opt && sig != 0)
+	if ((ccv_cache_opt || ccv_shared_cache_opt) && sig != 0)
 	{
-		uint8_t type;
-		array = (ccv_array_t*)ccv_cache_out(&ccv_cache, sig, &type);
+		uint8_t type = 1;
+		array = (ccv_array_t*)_ccv_cache_out(sig, &type);
+		if (ccv_cache_origin)
+			_ccv_cache_origin_lookup(sig, array, array ? sizeof(ccv_array_t) + array->size * array->rsize : 0);
 		if (array)
 		{
 			assert(type == 1);
@@ -252,14 +751,17 @@ void ccv_array_free_immediately(ccv_array_t* array)
 
 void ccv_array_free(ccv_array_t* array)
 {
-	if (!ccv_cache_opt || !(array->type & CCV_REUSABLE) || array->sig == 0)
+	if (!(ccv_cache_opt || ccv_shared_cache_opt) || !(array->type & CCV_REUSABLE) || array->sig == 0)
 	{
 		array->refcount = 0;
 		ccfree(array->data);
 		ccfree(array);
 	} else {
 		size_t size = sizeof(ccv_array_t) + array->size * array->rsize;
-		ccv_cache_put(&ccv_cache, array->sig, array, size, 1 /* type 1 */);
+		if (ccv_cache_origin)
+			++ccv_cache_origin->origins[_ccv_cache_origin_of(array->sig)].put;
+		if (_ccv_cache_put(array->sig, array, size, 1 /* type 1 */, 0) < 0) // too large to fit in the cache
+			ccv_array_free_immediately(array);
 	}
 }
 
@@ -267,12 +769,115 @@ void ccv_drain_cache(void)
 {
 	if (ccv_cache.rnum > 0)
 		ccv_cache_cleanup(&ccv_cache);
+	if (ccv_shared_cache_opt)
+	{
+		int i;
+		for (i = 0; i < CCV_SHARED_CACHE_SHARDS; i++)
+		{
+#ifdef HAVE_PTHREAD
+			pthread_mutex_lock(&ccv_shared_cache[i].mutex);
+#endif
+			const size_t before = ccv_shared_cache[i].cache.size;
+			if (ccv_shared_cache[i].cache.rnum > 0)
+				ccv_cache_cleanup(&ccv_shared_cache[i].cache);
+#ifdef HAVE_PTHREAD
+			pthread_mutex_unlock(&ccv_shared_cache[i].mutex);
+#endif
+			__sync_sub_and_fetch(&ccv_shared_cache_size, before);
+		}
+	}
 }
 
 void ccv_disable_cache(void)
 {
 	ccv_cache_opt = 0;
 	ccv_cache_close(&ccv_cache);
+	if (ccv_shared_cache_opt)
+	{
+		ccv_shared_cache_opt = 0;
+		int i;
+		for (i = 0; i < CCV_SHARED_CACHE_SHARDS; i++)
+		{
+#ifdef HAVE_PTHREAD
+			pthread_mutex_lock(&ccv_shared_cache[i].mutex);
+#endif
+			ccv_cache_close(&ccv_shared_cache[i].cache);
+#ifdef HAVE_PTHREAD
+			pthread_mutex_unlock(&ccv_shared_cache[i].mutex);
+			pthread_mutex_destroy(&ccv_shared_cache[i].mutex);
+#endif
+		}
+		ccv_shared_cache_size = 0;
+	}
+}
+
+int ccv_enable_disk_cache(const char* path, size_t size)
+{
+	assert(!ccv_disk_cache_opt);
+	size = ccv_max(size, CCV_DISK_CACHE_MIN_SIZE);
+	int fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+		return -1;
+	flock(fd, LOCK_EX);
+	struct stat st;
+	ccv_disk_cache_header_t header;
+	// use the file as is if it is a valid one, regardless of the size asked for
+	if (fstat(fd, &st) == 0 && pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+		header.magic == CCV_DISK_CACHE_MAGIC && header.size == st.st_size)
+		size = st.st_size;
+	else if (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0) {
+		flock(fd, LOCK_UN);
+		close(fd);
+		return -1;
+	} else
+		header.magic = 0;
+	unsigned char* data = (unsigned char*)mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED)
+	{
+		flock(fd, LOCK_UN);
+		close(fd);
+		return -1;
+	}
+	if (header.magic != CCV_DISK_CACHE_MAGIC)
+		_ccv_disk_cache_reset((ccv_disk_cache_header_t*)data, size);
+	flock(fd, LOCK_UN);
+	ccv_disk_cache.fd = fd;
+	ccv_disk_cache.size = size;
+	ccv_disk_cache.data = data;
+	ccv_disk_cache.header = (ccv_disk_cache_header_t*)data;
+	ccv_disk_cache.index = (ccv_disk_cache_index_t*)(ccv_disk_cache.header + 1);
+	memset(&ccv_disk_cache.stats, 0, sizeof(ccv_disk_cache.stats));
+#ifdef HAVE_PTHREAD
+	pthread_mutex_init(&ccv_disk_cache.mutex, 0);
+#endif
+	ccv_disk_cache_opt = 1;
+	return 0;
+}
+
+void ccv_disable_disk_cache(void)
+{
+	if (!ccv_disk_cache_opt)
+		return;
+	ccv_disk_cache_opt = 0;
+	munmap(ccv_disk_cache.data, ccv_disk_cache.size);
+	close(ccv_disk_cache.fd);
+#ifdef HAVE_PTHREAD
+	pthread_mutex_destroy(&ccv_disk_cache.mutex);
+#endif
+}
+
+ccv_disk_cache_stats_t ccv_disk_cache_stats(void)
+{
+	ccv_disk_cache_stats_t stats;
+	memset(&stats, 0, sizeof(stats));
+	if (!ccv_disk_cache_opt)
+		return stats;
+	_ccv_disk_cache_lock();
+	stats = ccv_disk_cache.stats;
+	stats.rnum = ccv_disk_cache.header->rnum;
+	stats.size = ccv_disk_cache.header->tail - _ccv_disk_cache_data_start(ccv_disk_cache.header->slots);
+	_ccv_disk_cache_unlock();
+	return stats;
 }
 
 void ccv_enable_cache(size_t size)
@@ -281,11 +886,149 @@ void ccv_enable_cache(size_t size)
 	ccv_cache_init(&ccv_cache, size, 2, ccv_matrix_free_immediately, ccv_array_free_immediately);
 }
 
+void ccv_enable_shared_cache(size_t size)
+{
+	assert(!ccv_shared_cache_opt);
+	int i;
+	ccv_shared_cache_up = size;
+	ccv_shared_cache_size = 0;
+	for (i = 0; i < CCV_SHARED_CACHE_SHARDS; i++)
+	{
+		ccv_cache_init(&ccv_shared_cache[i].cache, size, 2, ccv_matrix_free_immediately, ccv_array_free_immediately);
+#ifdef HAVE_PTHREAD
+		pthread_mutex_init(&ccv_shared_cache[i].mutex, 0);
+#endif
+	}
+	ccv_shared_cache_opt = 1;
+}
+
 void ccv_enable_default_cache(void)
 {
 	ccv_enable_cache(CCV_DEFAULT_CACHE_SIZE);
 }
 
+void ccv_set_cache_policy(int policy)
+{
+	ccv_cache.policy = policy;
+	if (ccv_shared_cache_opt)
+	{
+		int i;
+		for (i = 0; i < CCV_SHARED_CACHE_SHARDS; i++)
+		{
+#ifdef HAVE_PTHREAD
+			pthread_mutex_lock(&ccv_shared_cache[i].mutex);
+#endif
+			ccv_shared_cache[i].cache.policy = policy;
+#ifdef HAVE_PTHREAD
+			pthread_mutex_unlock(&ccv_shared_cache[i].mutex);
+#endif
+		}
+	}
+}
+
+static void _ccv_cache_add_stats(ccv_cache_usage_t* usage, const ccv_cache_t* cache)
+{
+	int i;
+	usage->rnum += cache->rnum;
+	usage->size += cache->size;
+	usage->up += cache->up;
+	for (i = 0; i < 2; i++)
+	{
+		ccv_cache_stats_t* stats = i == 0 ? &usage->matrix : &usage->array;
+		stats->hit += cache->stats[i].hit;
+		stats->miss += cache->stats[i].miss;
+		stats->put += cache->stats[i].put;
+		stats->evict += cache->stats[i].evict;
+		stats->saved += cache->stats[i].saved;
+	}
+}
+
+ccv_cache_usage_t ccv_cache_usage(void)
+{
+	ccv_cache_usage_t usage;
+	memset(&usage, 0, sizeof(usage));
+	if (ccv_cache_opt)
+		_ccv_cache_add_stats(&usage, &ccv_cache);
+	else if (ccv_shared_cache_opt) {
+		int i;
+		for (i = 0; i < CCV_SHARED_CACHE_SHARDS; i++)
+		{
+#ifdef HAVE_PTHREAD
+			pthread_mutex_lock(&ccv_shared_cache[i].mutex);
+#endif
+			_ccv_cache_add_stats(&usage, &ccv_shared_cache[i].cache);
+#ifdef HAVE_PTHREAD
+			pthread_mutex_unlock(&ccv_shared_cache[i].mutex);
+#endif
+		}
+		// every shard can take up to the whole budget, it is the total that is bounded
+		usage.up = ccv_shared_cache_up;
+	}
+	return usage;
+}
+
+void ccv_enable_cache_origin_stats(void)
+{
+	if (!ccv_cache_origin)
+	{
+		ccv_cache_origin = (ccv_cache_origin_t*)cccalloc(1, sizeof(ccv_cache_origin_t));
+		strncpy(ccv_cache_origin->origins[0].name, "unknown", sizeof(ccv_cache_origin->origins[0].name));
+		ccv_cache_origin->rnum = 1;
+	}
+}
+
+void ccv_disable_cache_origin_stats(void)
+{
+	if (ccv_cache_origin)
+	{
+		ccfree(ccv_cache_origin);
+		ccv_cache_origin = 0;
+	}
+}
+
+int ccv_cache_origin_stats(ccv_cache_origin_stats_t* origins, int size)
+{
+	if (!ccv_cache_origin)
+		return 0;
+	if (origins)
+		memcpy(origins, ccv_cache_origin->origins, sizeof(ccv_cache_origin_stats_t) * ccv_min(size, ccv_cache_origin->rnum));
+	return ccv_cache_origin->rnum;
+}
+
+void ccv_drain_matrix_pool(void)
+{
+	int i;
+	for (i = 0; i < CCV_MATRIX_POOL_CLASSES; i++)
+		while (ccv_matrix_pool.head[i])
+		{
+			void* x = ccv_matrix_pool.head[i];
+			ccv_matrix_pool.head[i] = *(void**)x;
+			ccfree(x);
+		}
+	ccv_matrix_pool.size = 0;
+}
+
+void ccv_disable_matrix_pool(void)
+{
+	ccv_matrix_pool_opt = 0;
+	ccv_drain_matrix_pool();
+}
+
+void ccv_enable_matrix_pool(size_t size)
+{
+	ccv_drain_matrix_pool();
+	memset(&ccv_matrix_pool.stats, 0, sizeof(ccv_matrix_pool.stats));
+	ccv_matrix_pool.up = size;
+	ccv_matrix_pool_opt = 1;
+}
+
+ccv_matrix_pool_stats_t ccv_matrix_pool_stats(void)
+{
+	ccv_matrix_pool_stats_t stats = ccv_matrix_pool.stats;
+	stats.size = ccv_matrix_pool.size;
+	return stats;
+}
+
 static uint8_t key_siphash[16] = "libccvky4siphash";
 
 uint64_t ccv_cache_generate_signature(const char* msg, int len, uint64_t sig_start, ...)
@@ -303,5 +1046,7 @@ uint64_t ccv_cache_generate_signature(const char* msg, int len, uint64_t sig_sta
 		sig_in[1] = va_arg(arguments, uint64_t);
 	}
 	va_end(arguments);
+	if (ccv_cache_origin)
+		_ccv_cache_origin_record(sig_out, msg, len, sig_start);
 	return sig_out;
 }
@@ -4,6 +4,9 @@
 #ifdef HAVE_FFTW3
 #include <pthread.h>
 #include <fftw3.h>
+#ifdef HAVE_FFTW3_THREADS
+#include <unistd.h>
+#endif
 #else
 #include "3rdparty/kissfft/kiss_fftndr.h"
 #include "3rdparty/kissfft/kissf_fftndr.h"
@@ -582,190 +585,284 @@ static int _ccv_get_optimal_fft_size(int size)
 
 static pthread_mutex_t fftw_plan_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static void _ccv_filter_fftw(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t* d, int padding_pattern)
+#define CCV_FFTW_PLAN_CACHE_SIZE (64)
+
+typedef struct {
+	int rows;
+	int cols;
+	int ch;
+	int type;
+	void* p; // fftw_plan or fftwf_plan, depends on type
+	void* pinv;
+} ccv_fftw_plan_t;
+
+/* plans are created once per FFT geometry and kept for the lifetime of the process, thus, looking up a plan
+ * doesn't need to lock, only creating one does (the FFTW planner is not thread-safe, but executing a plan on
+ * new arrays is) */
+static ccv_fftw_plan_t fftw_plan_cache[CCV_FFTW_PLAN_CACHE_SIZE];
+static int fftw_plan_cache_count = 0;
+
+static void _ccv_fftw_plan_new(ccv_fftw_plan_t* plan)
 {
-	int ch = CCV_GET_CHANNEL(a->type);
-	int fft_type = (CCV_GET_DATA_TYPE(d->type) == CCV_8U || CCV_GET_DATA_TYPE(d->type) == CCV_32F) ? CCV_32F : CCV_64F;
-	int rows = ccv_min(a->rows + b->rows - 1, _ccv_get_optimal_fft_size(b->rows * 3));
-	int cols = ccv_min(a->cols + b->cols - 1, _ccv_get_optimal_fft_size(b->cols * 3));
-	int cols_2c = 2 * (cols / 2 + 1);
-	void* fftw_a;
-	void* fftw_b;
-	void* fftw_d;
-	fftw_plan p, pinv;
-	fftwf_plan pf, pinvf;
-	if (fft_type == CCV_32F)
+#ifdef HAVE_FFTW3_THREADS
+	static int fftw_threads_init = 0;
+	if (!fftw_threads_init)
 	{
-		fftw_a = fftwf_malloc(rows * cols_2c * ch * sizeof(float));
-		fftw_b = fftwf_malloc(rows * cols_2c * ch * sizeof(float));
-		fftw_d = fftwf_malloc(rows * cols_2c * ch * sizeof(float));
-		pthread_mutex_lock(&fftw_plan_mutex);
-		if (ch == 1)
+		int nthreads = ccv_max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+		fftw_init_threads();
+		fftwf_init_threads();
+		fftw_plan_with_nthreads(nthreads);
+		fftwf_plan_with_nthreads(nthreads);
+		fftw_threads_init = 1;
+	}
+#endif
+	int ndim[] = {plan->rows, plan->cols};
+	if (plan->type == CCV_32F)
+	{
+		if (plan->ch == 1)
 		{
-			pf = fftwf_plan_dft_r2c_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
-			pinvf = fftwf_plan_dft_c2r_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
+			plan->p = fftwf_plan_dft_r2c_2d(plan->rows, plan->cols, 0, 0, FFTW_ESTIMATE);
+			plan->pinv = fftwf_plan_dft_c2r_2d(plan->rows, plan->cols, 0, 0, FFTW_ESTIMATE);
 		} else {
-			int ndim[] = {rows, cols};
-			pf = fftwf_plan_many_dft_r2c(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
-			pinvf = fftwf_plan_many_dft_c2r(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
+			plan->p = fftwf_plan_many_dft_r2c(2, ndim, plan->ch, 0, 0, plan->ch, 1, 0, 0, plan->ch, 1, FFTW_ESTIMATE);
+			plan->pinv = fftwf_plan_many_dft_c2r(2, ndim, plan->ch, 0, 0, plan->ch, 1, 0, 0, plan->ch, 1, FFTW_ESTIMATE);
 		}
-		pthread_mutex_unlock(&fftw_plan_mutex);
 	} else {
-		fftw_a = fftw_malloc(rows * cols_2c * ch * sizeof(double));
-		fftw_b = fftw_malloc(rows * cols_2c * ch * sizeof(double));
-		fftw_d = fftw_malloc(rows * cols_2c * ch * sizeof(double));
-		pthread_mutex_lock(&fftw_plan_mutex);
-		if (ch == 1)
+		if (plan->ch == 1)
 		{
-			p = fftw_plan_dft_r2c_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
-			pinv = fftw_plan_dft_c2r_2d(rows, cols, 0, 0, FFTW_ESTIMATE);
+			plan->p = fftw_plan_dft_r2c_2d(plan->rows, plan->cols, 0, 0, FFTW_ESTIMATE);
+			plan->pinv = fftw_plan_dft_c2r_2d(plan->rows, plan->cols, 0, 0, FFTW_ESTIMATE);
 		} else {
-			int ndim[] = {rows, cols};
-			p = fftw_plan_many_dft_r2c(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
-			pinv = fftw_plan_many_dft_c2r(2, ndim, ch, 0, 0, ch, 1, 0, 0, ch, 1, FFTW_ESTIMATE);
+			plan->p = fftw_plan_many_dft_r2c(2, ndim, plan->ch, 0, 0, plan->ch, 1, 0, 0, plan->ch, 1, FFTW_ESTIMATE);
+			plan->pinv = fftw_plan_many_dft_c2r(2, ndim, plan->ch, 0, 0, plan->ch, 1, 0, 0, plan->ch, 1, FFTW_ESTIMATE);
 		}
-		pthread_mutex_unlock(&fftw_plan_mutex);
 	}
-	memset(fftw_b, 0, rows * cols_2c * ch * CCV_GET_DATA_TYPE_SIZE(fft_type));
+}
 
-	int i, j, k;
-	unsigned char* m_ptr = b->data.u8;
-	// to flip matrix b is crucial, this problem only shows when I changed to a more sophisticated test case
-#define for_block(_for_type, _for_get) \
-	_for_type* fftw_ptr = (_for_type*)fftw_b + (b->rows - 1) * cols_2c * ch; \
-	for (i = 0; i < b->rows; i++) \
-	{ \
-		for (j = 0; j < b->cols; j++) \
-			for (k = 0; k < ch; k++) \
-				fftw_ptr[(b->cols - 1 - j) * ch + k] = _for_get(m_ptr, j * ch + k); \
-		fftw_ptr -= cols_2c * ch; \
-		m_ptr += b->step; \
+static const ccv_fftw_plan_t* _ccv_fftw_plan_get(int rows, int cols, int ch, int type, ccv_fftw_plan_t* transient)
+{
+	int i, count = __atomic_load_n(&fftw_plan_cache_count, __ATOMIC_ACQUIRE);
+	for (i = 0; i < count; i++)
+		if (fftw_plan_cache[i].rows == rows && fftw_plan_cache[i].cols == cols && fftw_plan_cache[i].ch == ch && fftw_plan_cache[i].type == type)
+			return fftw_plan_cache + i;
+	pthread_mutex_lock(&fftw_plan_mutex);
+	// someone else may have created it while we were waiting for the lock
+	for (; i < fftw_plan_cache_count; i++)
+		if (fftw_plan_cache[i].rows == rows && fftw_plan_cache[i].cols == cols && fftw_plan_cache[i].ch == ch && fftw_plan_cache[i].type == type)
+		{
+			pthread_mutex_unlock(&fftw_plan_mutex);
+			return fftw_plan_cache + i;
+		}
+	// if the cache is full, the plan is only used for this call
+	ccv_fftw_plan_t* plan = (fftw_plan_cache_count < CCV_FFTW_PLAN_CACHE_SIZE) ? fftw_plan_cache + fftw_plan_cache_count : transient;
+	plan->rows = rows;
+	plan->cols = cols;
+	plan->ch = ch;
+	plan->type = type;
+	_ccv_fftw_plan_new(plan);
+	if (plan != transient)
+		__atomic_store_n(&fftw_plan_cache_count, fftw_plan_cache_count + 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&fftw_plan_mutex);
+	return plan;
+}
+
+static void _ccv_fftw_plan_done(const ccv_fftw_plan_t* plan, ccv_fftw_plan_t* transient)
+{
+	if (plan != transient)
+		return;
+	pthread_mutex_lock(&fftw_plan_mutex);
+	if (plan->type == CCV_32F)
+	{
+		fftwf_destroy_plan((fftwf_plan)plan->p);
+		fftwf_destroy_plan((fftwf_plan)plan->pinv);
+	} else {
+		fftw_destroy_plan((fftw_plan)plan->p);
+		fftw_destroy_plan((fftw_plan)plan->pinv);
 	}
-	ccv_matrix_typeof(fft_type, ccv_matrix_getter, b->type, for_block);
+	pthread_mutex_unlock(&fftw_plan_mutex);
+}
+
+static void _ccv_filter_fftw(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t* d, int padding_pattern)
+{
+	int ch = CCV_GET_CHANNEL(a->type);
+	int fft_type = (CCV_GET_DATA_TYPE(d->type) == CCV_8U || CCV_GET_DATA_TYPE(d->type) == CCV_32F) ? CCV_32F : CCV_64F;
+	int rows = ccv_min(a->rows + b->rows - 1, _ccv_get_optimal_fft_size(b->rows * 3));
+	int cols = ccv_min(a->cols + b->cols - 1, _ccv_get_optimal_fft_size(b->cols * 3));
+	int cols_2c = 2 * (cols / 2 + 1);
+	ccv_fftw_plan_t transient;
+	const ccv_fftw_plan_t* plan = _ccv_fftw_plan_get(rows, cols, ch, fft_type, &transient);
+	fftw_plan p = (fftw_plan)plan->p;
+	fftw_plan pinv = (fftw_plan)plan->pinv;
+	fftwf_plan pf = (fftwf_plan)plan->p;
+	fftwf_plan pinvf = (fftwf_plan)plan->pinv;
+	/* the spectrum of the kernel only depends on the kernel and the FFT geometry, with a signature, it is kept
+	 * in the cache and reused when the same kernel is applied to other images (such as the DPM filters) */
+	ccv_declare_derived_signature(sig, b->sig != 0, ccv_sign_with_format(64, "ccv_filter_fftw(%d,%d,%d,%d)", rows, cols, ch, fft_type), b->sig, CCV_EOF_SIGN);
+	ccv_dense_matrix_t* bs = ccv_dense_matrix_new(rows, cols_2c * ch, fft_type | CCV_C1, 0, sig);
+	if (bs->type & CCV_GARBAGE)
+	{
+		ccv_revive_object_if_cached(bs);
+	} else {
+		const size_t size = rows * cols_2c * ch * CCV_GET_DATA_TYPE_SIZE(fft_type);
+		void* fftw_b = (fft_type == CCV_32F) ? fftwf_malloc(size) : fftw_malloc(size);
+		memset(fftw_b, 0, size);
+		int i, j, k;
+		unsigned char* m_ptr = b->data.u8;
+		// to flip matrix b is crucial, this problem only shows when I changed to a more sophisticated test case
+#define for_block(_for_type, _for_get) \
+		_for_type* fftw_ptr = (_for_type*)fftw_b + (b->rows - 1) * cols_2c * ch; \
+		for (i = 0; i < b->rows; i++) \
+		{ \
+			for (j = 0; j < b->cols; j++) \
+				for (k = 0; k < ch; k++) \
+					fftw_ptr[(b->cols - 1 - j) * ch + k] = _for_get(m_ptr, j * ch + k); \
+			fftw_ptr -= cols_2c * ch; \
+			m_ptr += b->step; \
+		}
+		ccv_matrix_typeof(fft_type, ccv_matrix_getter, b->type, for_block);
 #undef for_block
-	if (fft_type == CCV_32F)
-		fftwf_execute_dft_r2c(pf, (float*)fftw_b, (fftwf_complex*)fftw_b);
-	else
-		fftw_execute_dft_r2c(p, (double*)fftw_b, (fftw_complex*)fftw_b);
+		if (fft_type == CCV_32F)
+		{
+			fftwf_execute_dft_r2c(pf, (float*)fftw_b, (fftwf_complex*)fftw_b);
+			memcpy(bs->data.u8, fftw_b, size);
+			fftwf_free(fftw_b);
+		} else {
+			fftw_execute_dft_r2c(p, (double*)fftw_b, (fftw_complex*)fftw_b);
+			memcpy(bs->data.u8, fftw_b, size);
+			fftw_free(fftw_b);
+		}
+		ccv_cache_cost_hint(bs->sig, (uint64_t)size * 16);
+	}
 	/* why a->cols + cols - 2 * (b->cols & ~1) ?
 	 * what we really want is ceiling((a->cols - (b->cols & ~1)) / (cols - (b->cols & ~1)))
 	 * in this case, we strip out paddings on the left/right, and compute how many tiles
 	 * we need. It then be interpreted in the above integer division form */
 	int tile_x = ccv_max(1, (a->cols + cols - 2 * (b->cols & ~1)) / (cols - (b->cols & ~1)));
 	int tile_y = ccv_max(1, (a->rows + rows - 2 * (b->rows & ~1)) / (rows - (b->rows & ~1)));
+	/* the tiles before these are not clamped to the border of a, their output regions don't overlap, thus
+	 * can be computed in parallel, the clamped ones overlap with their neighbors and follow in order */
+	int tile_x0 = ccv_min(tile_x, ccv_max(a->cols - cols, 0) / (cols - (b->cols & ~1)) + 1);
+	int tile_y0 = ccv_min(tile_y, ccv_max(a->rows - rows, 0) / (rows - (b->rows & ~1)) + 1);
 	int brows2 = b->rows / 2;
 	int bcols2 = b->cols / 2;
-#define for_block(_for_type, _cpx_type, _for_set, _for_get) \
-	_for_type scale = 1.0 / (rows * cols); \
-	for (i = 0; i < tile_y; i++) \
-		for (j = 0; j < tile_x; j++) \
+	int i, j;
+#define fftw_tile(_for_type, _cpx_type, _for_set, _for_get) \
+	{ \
+		int x, y; \
+		_for_type* fftw_a = (_for_type*)fft_malloc(rows * cols_2c * ch * sizeof(_for_type)); \
+		memset(fftw_a, 0, rows * cols_2c * ch * sizeof(_for_type)); \
+		int iy = ccv_min(i * (rows - (b->rows & ~1)), ccv_max(a->rows - rows, 0)); \
+		int ix = ccv_min(j * (cols - (b->cols & ~1)), ccv_max(a->cols - cols, 0)); \
+		_for_type* fftw_ptr = fftw_a; \
+		int end_y = ccv_min(rows, a->rows - iy); \
+		int end_x = ccv_min(cols, a->cols - ix); \
+		unsigned char* m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(a, iy, ix, 0); \
+		for (y = 0; y < end_y; y++) \
 		{ \
-			int x, y; \
-			memset(fftw_a, 0, rows * cols_2c * ch * sizeof(_for_type)); \
-			int iy = ccv_min(i * (rows - (b->rows & ~1)), ccv_max(a->rows - rows, 0)); \
-			int ix = ccv_min(j * (cols - (b->cols & ~1)), ccv_max(a->cols - cols, 0)); \
-			_for_type* fftw_ptr = (_for_type*)fftw_a; \
-			int end_y = ccv_min(rows, a->rows - iy); \
-			int end_x = ccv_min(cols, a->cols - ix); \
-			m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(a, iy, ix, 0); \
-			for (y = 0; y < end_y; y++) \
+			for (x = 0; x < end_x * ch; x++) \
+				fftw_ptr[x] = _for_get(m_ptr, x); \
+			fftw_ptr += cols_2c * ch; \
+			m_ptr += a->step; \
+		} \
+		_cpx_type* fftw_ac = (_cpx_type*)fftw_a; \
+		_cpx_type* fftw_bc = (_cpx_type*)bs->data.u8; \
+		fft_execute_dft_r2c(fftw_a, fftw_ac); \
+		for (x = 0; x < rows * ch * (cols / 2 + 1); x++) \
+			fftw_ac[x] = (fftw_ac[x] * fftw_bc[x]) * scale; \
+		fft_execute_dft_c2r(fftw_ac, fftw_a); \
+		fftw_ptr = fftw_a + ((1 + (i > 0)) * brows2 * cols_2c + (1 + (j > 0)) * bcols2) * ch; \
+		end_y = ccv_min(d->rows - (iy + (i > 0) * brows2), \
+						(rows - (b->rows & ~1)) + (i == 0) * brows2); \
+		end_x = ccv_min(d->cols - (ix + (j > 0) * bcols2), \
+						(cols - (b->cols & ~1)) + (j == 0) * bcols2); \
+		m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2, ix + (j > 0) * bcols2, 0); \
+		for (y = 0; y < end_y; y++) \
+		{ \
+			for (x = 0; x < end_x * ch; x++) \
+				_for_set(m_ptr, x, fftw_ptr[x]); \
+			m_ptr += d->step; \
+			fftw_ptr += cols_2c * ch; \
+		} \
+		int end_tile_y, end_tile_x; \
+		/* handle edge cases: */ \
+		if (i + 1 == tile_y && end_y + iy + (i > 0) * brows2 < d->rows) \
+		{ \
+			end_tile_y = ccv_min(brows2, d->rows - (iy + (i > 0) * brows2 + end_y)); \
+			fftw_ptr = fftw_a + (1 + (j > 0)) * bcols2 * ch; \
+			m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2 + end_y, ix + (j > 0) * bcols2, 0); \
+			for (y = 0; y < end_tile_y; y++) \
 			{ \
 				for (x = 0; x < end_x * ch; x++) \
-					fftw_ptr[x] = _for_get(m_ptr, x); \
+					_for_set(m_ptr, x, fftw_ptr[x]); \
+				m_ptr += d->step; \
 				fftw_ptr += cols_2c * ch; \
-				m_ptr += a->step; \
 			} \
-			_cpx_type* fftw_ac = (_cpx_type*)fftw_a; \
-			_cpx_type* fftw_bc = (_cpx_type*)fftw_b; \
-			_cpx_type* fftw_dc = (_cpx_type*)fftw_d; \
-			fft_execute_dft_r2c((_for_type*)fftw_a, (_cpx_type*)fftw_ac); \
-			for (x = 0; x < rows * ch * (cols / 2 + 1); x++) \
-				fftw_dc[x] = (fftw_ac[x] * fftw_bc[x]) * scale; \
-			fft_execute_dft_c2r((_cpx_type*)fftw_dc, (_for_type*)fftw_d); \
-			fftw_ptr = (_for_type*)fftw_d + ((1 + (i > 0)) * brows2 * cols_2c + (1 + (j > 0)) * bcols2) * ch; \
-			end_y = ccv_min(d->rows - (iy + (i > 0) * brows2), \
-							(rows - (b->rows & ~1)) + (i == 0) * brows2); \
-			end_x = ccv_min(d->cols - (ix + (j > 0) * bcols2), \
-							(cols - (b->cols & ~1)) + (j == 0) * bcols2); \
-			m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2, ix + (j > 0) * bcols2, 0); \
+		} \
+		if (j + 1 == tile_x && end_x + ix + (j > 0) * bcols2 < d->cols) \
+		{ \
+			end_tile_x = ccv_min(bcols2, d->cols - (ix + (j > 0) * bcols2 + end_x)); \
+			fftw_ptr = fftw_a + (1 + (i > 0)) * brows2 * cols_2c * ch; \
+			m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2, ix + (j > 0) * bcols2 + end_x, 0); \
 			for (y = 0; y < end_y; y++) \
 			{ \
-				for (x = 0; x < end_x * ch; x++) \
+				for (x = 0; x < end_tile_x * ch; x++) \
 					_for_set(m_ptr, x, fftw_ptr[x]); \
 				m_ptr += d->step; \
 				fftw_ptr += cols_2c * ch; \
 			} \
-			int end_tile_y, end_tile_x; \
-			/* handle edge cases: */ \
-			if (i + 1 == tile_y && end_y + iy + (i > 0) * brows2 < d->rows) \
-			{ \
-				end_tile_y = ccv_min(brows2, d->rows - (iy + (i > 0) * brows2 + end_y)); \
-				fftw_ptr = (_for_type*)fftw_d + (1 + (j > 0)) * bcols2 * ch; \
-				m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2 + end_y, ix + (j > 0) * bcols2, 0); \
-				for (y = 0; y < end_tile_y; y++) \
-				{ \
-					for (x = 0; x < end_x * ch; x++) \
-						_for_set(m_ptr, x, fftw_ptr[x]); \
-					m_ptr += d->step; \
-					fftw_ptr += cols_2c * ch; \
-				} \
-			} \
-			if (j + 1 == tile_x && end_x + ix + (j > 0) * bcols2 < d->cols) \
-			{ \
-				end_tile_x = ccv_min(bcols2, d->cols - (ix + (j > 0) * bcols2 + end_x)); \
-				fftw_ptr = (_for_type*)fftw_d + (1 + (i > 0)) * brows2 * cols_2c * ch; \
-				m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2, ix + (j > 0) * bcols2 + end_x, 0); \
-				for (y = 0; y < end_y; y++) \
-				{ \
-					for (x = 0; x < end_tile_x * ch; x++) \
-						_for_set(m_ptr, x, fftw_ptr[x]); \
-					m_ptr += d->step; \
-					fftw_ptr += cols_2c * ch; \
-				} \
-			} \
-			if (i + 1 == tile_y && end_y + iy + (i > 0) * brows2 < d->rows && \
-				j + 1 == tile_x && end_x + ix + (j > 0) * bcols2 < d->cols) \
+		} \
+		if (i + 1 == tile_y && end_y + iy + (i > 0) * brows2 < d->rows && \
+			j + 1 == tile_x && end_x + ix + (j > 0) * bcols2 < d->cols) \
+		{ \
+			fftw_ptr = fftw_a; \
+			m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2 + end_y, ix + (j > 0) * bcols2 + end_x, 0); \
+			for (y = 0; y < end_tile_y; y++) \
 			{ \
-				fftw_ptr = (_for_type*)fftw_d; \
-				m_ptr = (unsigned char*)ccv_get_dense_matrix_cell(d, iy + (i > 0) * brows2 + end_y, ix + (j > 0) * bcols2 + end_x, 0); \
-				for (y = 0; y < end_tile_y; y++) \
-				{ \
-					for (x = 0; x < end_tile_x * ch; x++) \
-						_for_set(m_ptr, x, fftw_ptr[x]); \
-					m_ptr += d->step; \
-					fftw_ptr += cols_2c * ch; \
-				} \
+				for (x = 0; x < end_tile_x * ch; x++) \
+					_for_set(m_ptr, x, fftw_ptr[x]); \
+				m_ptr += d->step; \
+				fftw_ptr += cols_2c * ch; \
 			} \
-		}
+		} \
+		fft_free(fftw_a); \
+	}
+#define for_block(_for_type, _cpx_type, _for_set, _for_get) \
+	_for_type scale = 1.0 / (rows * cols); \
+	parallel_for(t, tile_y0 * tile_x0) { \
+		int i = t / tile_x0; \
+		int j = t % tile_x0; \
+		fftw_tile(_for_type, _cpx_type, _for_set, _for_get); \
+	} parallel_endfor \
+	for (i = 0; i < tile_y; i++) \
+		for (j = 0; j < tile_x; j++) \
+			if (i >= tile_y0 || j >= tile_x0) \
+				fftw_tile(_for_type, _cpx_type, _for_set, _for_get);
 	if (fft_type == CCV_32F)
 	{
+#define fft_malloc fftwf_malloc
+#define fft_free fftwf_free
 #define fft_execute_dft_r2c(r, c) fftwf_execute_dft_r2c(pf, r, c)
 #define fft_execute_dft_c2r(c, r) fftwf_execute_dft_c2r(pinvf, c, r)
 		ccv_matrix_setter(d->type, ccv_matrix_getter, a->type, for_block, float, fftwf_complex);
+#undef fft_malloc
+#undef fft_free
 #undef fft_execute_dft_r2c
 #undef fft_execute_dft_c2r
-		pthread_mutex_lock(&fftw_plan_mutex);
-		fftwf_destroy_plan(pf);
-		fftwf_destroy_plan(pinvf);
-		pthread_mutex_unlock(&fftw_plan_mutex);
-		fftwf_free(fftw_a);
-		fftwf_free(fftw_b);
-		fftwf_free(fftw_d);
 	} else {
+#define fft_malloc fftw_malloc
+#define fft_free fftw_free
 #define fft_execute_dft_r2c(r, c) fftw_execute_dft_r2c(p, r, c)
 #define fft_execute_dft_c2r(c, r) fftw_execute_dft_c2r(pinv, c, r)
 		ccv_matrix_setter(d->type, ccv_matrix_getter, a->type, for_block, double, fftw_complex);
+#undef fft_malloc
+#undef fft_free
 #undef fft_execute_dft_r2c
 #undef fft_execute_dft_c2r
-		pthread_mutex_lock(&fftw_plan_mutex);
-		fftw_destroy_plan(p);
-		fftw_destroy_plan(pinv);
-		pthread_mutex_unlock(&fftw_plan_mutex);
-		fftw_free(fftw_a);
-		fftw_free(fftw_b);
-		fftw_free(fftw_d);
 	}
 #undef for_block
+#undef fftw_tile
+	ccv_matrix_free(bs);
+	_ccv_fftw_plan_done(plan, &transient);
 }
 #else
 static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_dense_matrix_t* d, int padding_pattern)
@@ -776,10 +873,8 @@ static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, cc
 	int cols = ((ccv_min(a->cols + b->cols - 1, kiss_fftr_next_fast_size_real(b->cols * 3)) + 1) >> 1) << 1;
 	int ndim[] = {rows, cols};
 	void* kiss_a;
-	void* kiss_b;
 	void* kiss_d;
 	void* kiss_ac;
-	void* kiss_bc;
 	void* kiss_dc;
 	kiss_fftndr_cfg p;
 	kiss_fftndr_cfg pinv;
@@ -790,45 +885,53 @@ static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, cc
 		pf = kissf_fftndr_alloc(ndim, 2, 0, 0, 0);
 		pinvf = kissf_fftndr_alloc(ndim, 2, 1, 0, 0);
 		kiss_a = ccmalloc(rows * cols * ch * sizeof(kissf_fft_scalar));
-		kiss_b = ccmalloc(rows * cols * ch * sizeof(kissf_fft_scalar));
 		kiss_d = ccmalloc(rows * cols * ch * sizeof(kissf_fft_scalar));
 		kiss_ac = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kissf_fft_cpx));
-		kiss_bc = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kissf_fft_cpx));
 		kiss_dc = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kissf_fft_cpx));
-		memset(kiss_b, 0, rows * cols * ch * sizeof(kissf_fft_scalar));
 	} else {
 		p = kiss_fftndr_alloc(ndim, 2, 0, 0, 0);
 		pinv = kiss_fftndr_alloc(ndim, 2, 1, 0, 0);
 		kiss_a = ccmalloc(rows * cols * ch * sizeof(kiss_fft_scalar));
-		kiss_b = ccmalloc(rows * cols * ch * sizeof(kiss_fft_scalar));
 		kiss_d = ccmalloc(rows * cols * ch * sizeof(kiss_fft_scalar));
 		kiss_ac = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kiss_fft_cpx));
-		kiss_bc = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kiss_fft_cpx));
 		kiss_dc = ccmalloc(rows * (cols / 2 + 1) * ch * sizeof(kiss_fft_cpx));
-		memset(kiss_b, 0, rows * cols * ch * sizeof(kiss_fft_scalar));
 	}
 	int nch = rows * cols, nchc = rows * (cols / 2 + 1);
 	int i, j, k;
-	unsigned char* m_ptr = b->data.u8;
-	// to flip matrix b is crucial, this problem only shows when I changed to a more sophisticated test case
+	unsigned char* m_ptr;
+	/* the spectrum of the kernel only depends on the kernel and the FFT geometry, with a signature, it is kept
+	 * in the cache and reused when the same kernel is applied to other images (such as the DPM filters) */
+	ccv_declare_derived_signature(sig, b->sig != 0, ccv_sign_with_format(64, "ccv_filter_kissfft(%d,%d,%d,%d)", rows, cols, ch, fft_type), b->sig, CCV_EOF_SIGN);
+	ccv_dense_matrix_t* bs = ccv_dense_matrix_new(rows, (cols / 2 + 1) * ch * 2, fft_type | CCV_C1, 0, sig);
+	void* kiss_bc = bs->data.u8;
+	if (bs->type & CCV_GARBAGE)
+	{
+		ccv_revive_object_if_cached(bs);
+	} else {
+		void* kiss_b = cccalloc(rows * cols * ch, CCV_GET_DATA_TYPE_SIZE(fft_type));
+		m_ptr = b->data.u8;
+		// to flip matrix b is crucial, this problem only shows when I changed to a more sophisticated test case
 #define for_block(_for_type, _for_get) \
-	_for_type* kiss_ptr = (_for_type*)kiss_b + (b->rows - 1) * cols; \
-	for (i = 0; i < b->rows; i++) \
-	{ \
-		for (j = 0; j < b->cols; j++) \
-			for (k = 0; k < ch; k++) \
-				kiss_ptr[k * nch + b->cols - 1 - j] = _for_get(m_ptr, j * ch + k); \
-		kiss_ptr -= cols; \
-		m_ptr += b->step; \
-	}
-	ccv_matrix_typeof(fft_type, ccv_matrix_getter, b->type, for_block);
+		_for_type* kiss_ptr = (_for_type*)kiss_b + (b->rows - 1) * cols; \
+		for (i = 0; i < b->rows; i++) \
+		{ \
+			for (j = 0; j < b->cols; j++) \
+				for (k = 0; k < ch; k++) \
+					kiss_ptr[k * nch + b->cols - 1 - j] = _for_get(m_ptr, j * ch + k); \
+			kiss_ptr -= cols; \
+			m_ptr += b->step; \
+		}
+		ccv_matrix_typeof(fft_type, ccv_matrix_getter, b->type, for_block);
 #undef for_block
-	if (fft_type == CCV_32F)
-		for (k = 0; k < ch; k++)
-			kissf_fftndr(pf, (kissf_fft_scalar*)kiss_b + nch * k, (kissf_fft_cpx*)kiss_bc + nchc * k);
-	else
-		for (k = 0; k < ch; k++)
-			kiss_fftndr(p, (kiss_fft_scalar*)kiss_b + nch * k, (kiss_fft_cpx*)kiss_bc + nchc * k);
+		if (fft_type == CCV_32F)
+			for (k = 0; k < ch; k++)
+				kissf_fftndr(pf, (kissf_fft_scalar*)kiss_b + nch * k, (kissf_fft_cpx*)kiss_bc + nchc * k);
+		else
+			for (k = 0; k < ch; k++)
+				kiss_fftndr(p, (kiss_fft_scalar*)kiss_b + nch * k, (kiss_fft_cpx*)kiss_bc + nchc * k);
+		ccfree(kiss_b);
+		ccv_cache_cost_hint(bs->sig, (uint64_t)rows * cols * ch * CCV_GET_DATA_TYPE_SIZE(fft_type) * 16);
+	}
 	/* why a->cols + cols - 2 * (b->cols & ~1) ?
 	 * what we really want is ceiling((a->cols - (b->cols & ~1)) / (cols - (b->cols & ~1)))
 	 * in this case, we strip out paddings on the left/right, and compute how many tiles
@@ -948,11 +1051,10 @@ static void _ccv_filter_kissfft(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, cc
 		kiss_fft_free(pinv);
 	}
 #undef for_block
+	ccv_matrix_free(bs);
 	ccfree(kiss_dc);
-	ccfree(kiss_bc);
 	ccfree(kiss_ac);
 	ccfree(kiss_d);
-	ccfree(kiss_b);
 	ccfree(kiss_a);
 }
 #endif
@@ -1082,6 +1184,11 @@ void ccv_filter_kernel(ccv_dense_matrix_t* x, ccv_filter_kernel_f func, void* da
 	ccv_make_matrix_immutable(x);
 }
 
+/* the rows of the distance transform are done in bands of this many rows, and the columns in blocks of this many
+ * columns, 16 columns of 32-bit floats are exactly a cache line */
+#define CCV_DISTANCE_TRANSFORM_BAND_ROWS (16)
+#define CCV_DISTANCE_TRANSFORM_BLOCK_COLS (16)
+
 void ccv_distance_transform(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, ccv_dense_matrix_t** x, int x_type, ccv_dense_matrix_t** y, int y_type, double dx, double dy, double dxx, double dyy, int flag)
 {
 	assert(!(flag & CCV_L2_NORM) && (flag & CCV_GSEDT));
@@ -1102,145 +1209,182 @@ void ccv_distance_transform(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int t
 	}
 	ccv_object_return_if_cached(, db, mx, my);
 	ccv_revive_object_if_cached(db, mx, my);
-	int i, j, k;
-	unsigned char* a_ptr = a->data.u8;
-	unsigned char* b_ptr = db->data.u8;
-	int* v = (int*)alloca(sizeof(int) * ccv_max(db->rows, db->cols));
-	unsigned char* c_ptr = (unsigned char*)alloca(CCV_GET_DATA_TYPE_SIZE(db->type) * db->rows);
-	int* x_ptr = mx ? mx->data.i32 : 0;
-	int* y_ptr = my ? my->data.i32 : 0;
+	int i, j;
+	/* the first pass runs along the rows, each row is independent, thus, bands of rows are done in parallel.
+	 * the second pass runs along the columns, a block of columns is transposed into a contiguous buffer (and
+	 * transposed back after), thus, columns are scanned in cache-friendly order and blocks are done in parallel */
 #define for_block(_for_max, _for_type_b, _for_set_b, _for_get_b, _for_get_a) \
 	_for_type_b _dx = dx, _dy = dy, _dxx = dxx, _dyy = dyy; \
-	_for_type_b* z = (_for_type_b*)alloca(sizeof(_for_type_b) * (ccv_max(db->rows, db->cols) + 1)); \
 	if (_dxx > 1e-6) \
 	{ \
-		for (i = 0; i < a->rows; i++) \
-		{ \
-			k = 0; \
-			v[0] = 0; \
-			z[0] = (_for_type_b)-_for_max; \
-			z[1] = (_for_type_b)_for_max; \
-			for (j = 1; j < a->cols; j++) \
-			{ \
-				_for_type_b s; \
-				for (;;) \
-				{ \
-					assert(k >= 0 && k < ccv_max(db->rows, db->cols)); \
-					s = ((SGN _for_get_a(a_ptr, j) + _dxx * j * j - _dx * j) - (SGN _for_get_a(a_ptr, v[k]) + _dxx * v[k] * v[k] - _dx * v[k])) / (2.0 * _dxx * (j - v[k])); \
-					if (s > z[k]) break; \
-					--k; \
-				} \
-				++k; \
-				assert(k >= 0 && k < ccv_max(db->rows, db->cols)); \
-				v[k] = j; \
-				z[k] = s; \
-				z[k + 1] = (_for_type_b)_for_max; \
-			} \
-			assert(z[k + 1] >= a->cols - 1); \
-			k = 0; \
-			if (mx) \
+		parallel_for(t, (a->rows + CCV_DISTANCE_TRANSFORM_BAND_ROWS - 1) / CCV_DISTANCE_TRANSFORM_BAND_ROWS) { \
+			int i, j, k; \
+			_for_type_b* z = (_for_type_b*)ccmalloc((sizeof(_for_type_b) * 2 + sizeof(int)) * (a->cols + 1)); \
+			_for_type_b* h = z + a->cols + 1; \
+			int* v = (int*)(h + a->cols + 1); \
+			for (i = t * CCV_DISTANCE_TRANSFORM_BAND_ROWS; i < ccv_min(a->rows, (t + 1) * CCV_DISTANCE_TRANSFORM_BAND_ROWS); i++) \
 			{ \
+				unsigned char* a_ptr = a->data.u8 + i * a->step; \
+				unsigned char* b_ptr = db->data.u8 + i * db->step; \
+				/* the height of the parabola at each point only need to be computed once */ \
 				for (j = 0; j < a->cols; j++) \
+					h[j] = SGN _for_get_a(a_ptr, j) + _dxx * j * j - _dx * j; \
+				k = 0; \
+				v[0] = 0; \
+				z[0] = (_for_type_b)-_for_max; \
+				z[1] = (_for_type_b)_for_max; \
+				for (j = 1; j < a->cols; j++) \
 				{ \
-					while (z[k + 1] < j) \
+					_for_type_b s; \
+					for (;;) \
 					{ \
-						assert(k >= 0 && k < ccv_max(db->rows, db->cols) - 1); \
-						++k; \
+						assert(k >= 0 && k < a->cols); \
+						s = (h[j] - h[v[k]]) / (2.0 * _dxx * (j - v[k])); \
+						if (s > z[k]) break; \
+						--k; \
 					} \
-					_for_set_b(b_ptr, j, _dx * (j - v[k]) + _dxx * (j - v[k]) * (j - v[k]) SGN _for_get_a(a_ptr, v[k])); \
-					x_ptr[j] = j - v[k]; \
+					++k; \
+					assert(k >= 0 && k < a->cols); \
+					v[k] = j; \
+					z[k] = s; \
+					z[k + 1] = (_for_type_b)_for_max; \
 				} \
-				x_ptr += mx->cols; \
-			} else { \
-				for (j = 0; j < a->cols; j++) \
+				assert(z[k + 1] >= a->cols - 1); \
+				k = 0; \
+				if (mx) \
 				{ \
-					while (z[k + 1] < j) \
+					int* x_ptr = mx->data.i32 + i * mx->cols; \
+					for (j = 0; j < a->cols; j++) \
 					{ \
-						assert(k >= 0 && k < ccv_max(db->rows, db->cols) - 1); \
-						++k; \
+						while (z[k + 1] < j) \
+						{ \
+							assert(k >= 0 && k < a->cols - 1); \
+							++k; \
+						} \
+						_for_set_b(b_ptr, j, _dx * (j - v[k]) + _dxx * (j - v[k]) * (j - v[k]) SGN _for_get_a(a_ptr, v[k])); \
+						x_ptr[j] = j - v[k]; \
+					} \
+				} else { \
+					for (j = 0; j < a->cols; j++) \
+					{ \
+						while (z[k + 1] < j) \
+						{ \
+							assert(k >= 0 && k < a->cols - 1); \
+							++k; \
+						} \
+						_for_set_b(b_ptr, j, _dx * (j - v[k]) + _dxx * (j - v[k]) * (j - v[k]) SGN _for_get_a(a_ptr, v[k])); \
 					} \
-					_for_set_b(b_ptr, j, _dx * (j - v[k]) + _dxx * (j - v[k]) * (j - v[k]) SGN _for_get_a(a_ptr, v[k])); \
 				} \
 			} \
-			a_ptr += a->step; \
-			b_ptr += db->step; \
-		} \
+			ccfree(z); \
+		} parallel_endfor \
 	} else { /* above algorithm cannot handle dxx == 0 properly, below is special casing for that */ \
 		assert(mx == 0); \
-		for (i = 0; i < a->rows; i++) \
-		{ \
+		parallel_for(i, a->rows) { \
+			int j; \
+			unsigned char* a_ptr = a->data.u8 + i * a->step; \
+			unsigned char* b_ptr = db->data.u8 + i * db->step; \
 			for (j = 0; j < a->cols; j++) \
 				_for_set_b(b_ptr, j, SGN _for_get_a(a_ptr, j)); \
 			for (j = 1; j < a->cols; j++) \
 				_for_set_b(b_ptr, j, ccv_min(_for_get_b(b_ptr, j), _for_get_b(b_ptr, j - 1) + _dx)); \
 			for (j = a->cols - 2; j >= 0; j--) \
 				_for_set_b(b_ptr, j, ccv_min(_for_get_b(b_ptr, j), _for_get_b(b_ptr, j + 1) - _dx)); \
-			a_ptr += a->step; \
-			b_ptr += db->step; \
-		} \
+		} parallel_endfor \
 	} \
-	b_ptr = db->data.u8; \
 	if (_dyy > 1e-6) \
 	{ \
-		for (j = 0; j < db->cols; j++) \
-		{ \
+		parallel_for(t, (db->cols + CCV_DISTANCE_TRANSFORM_BLOCK_COLS - 1) / CCV_DISTANCE_TRANSFORM_BLOCK_COLS) { \
+			int i, j, k; \
+			const int j0 = t * CCV_DISTANCE_TRANSFORM_BLOCK_COLS; \
+			const int jn = ccv_min(CCV_DISTANCE_TRANSFORM_BLOCK_COLS, db->cols - j0); \
+			/* z, the transposed input (c) and output (e) of the block, then v and the transposed y (argmax) */ \
+			_for_type_b* z = (_for_type_b*)ccmalloc((sizeof(_for_type_b) + sizeof(int)) * (db->rows * (jn * 2 + 1) + 1)); \
+			_for_type_b* c = z + db->rows + 1; \
+			_for_type_b* e = c + db->rows * jn; \
+			int* v = (int*)(e + db->rows * jn); \
+			int* yt = v + db->rows; \
+			unsigned char* b_ptr = db->data.u8; \
 			for (i = 0; i < db->rows; i++) \
-				_for_set_b(c_ptr, i, _for_get_b(b_ptr + i * db->step, j)); \
-			k = 0; \
-			v[0] = 0; \
-			z[0] = (_for_type_b)-_for_max; \
-			z[1] = (_for_type_b)_for_max; \
-			for (i = 1; i < db->rows; i++) \
 			{ \
-				_for_type_b s; \
-				for (;;) \
-				{ \
-					assert(k >= 0 && k < ccv_max(db->rows, db->cols)); \
-					s = ((_for_get_b(c_ptr, i) + _dyy * i * i - _dy * i) - (_for_get_b(c_ptr, v[k]) + _dyy * v[k] * v[k] - _dy * v[k])) / (2.0 * _dyy * (i - v[k])); \
-					if (s > z[k]) break; \
-					--k; \
-				} \
-				++k; \
-				assert(k >= 0 && k < ccv_max(db->rows, db->cols)); \
-				v[k] = i; \
-				z[k] = s; \
-				z[k + 1] = (_for_type_b)_for_max; \
+				for (j = 0; j < jn; j++) \
+					c[j * db->rows + i] = _for_get_b(b_ptr, j0 + j); \
+				b_ptr += db->step; \
 			} \
-			assert(z[k + 1] >= db->rows - 1); \
-			k = 0; \
-			if (my) \
+			for (j = 0; j < jn; j++) \
 			{ \
+				_for_type_b* c_ptr = c + j * db->rows; \
+				_for_type_b* e_ptr = e + j * db->rows; \
+				int* y_ptr = yt + j * db->rows; \
+				/* the output of the column is not written yet, use it to hold the height of the parabolas */ \
 				for (i = 0; i < db->rows; i++) \
+					e_ptr[i] = c_ptr[i] + _dyy * i * i - _dy * i; \
+				k = 0; \
+				v[0] = 0; \
+				z[0] = (_for_type_b)-_for_max; \
+				z[1] = (_for_type_b)_for_max; \
+				for (i = 1; i < db->rows; i++) \
 				{ \
-					while (z[k + 1] < i) \
+					_for_type_b s; \
+					for (;;) \
 					{ \
-						assert(k >= 0 && k < ccv_max(db->rows, db->cols) - 1); \
-						++k; \
+						assert(k >= 0 && k < db->rows); \
+						s = (e_ptr[i] - e_ptr[v[k]]) / (2.0 * _dyy * (i - v[k])); \
+						if (s > z[k]) break; \
+						--k; \
 					} \
-					_for_set_b(b_ptr + i * db->step, j, _dy * (i - v[k]) + _dyy * (i - v[k]) * (i - v[k]) + _for_get_b(c_ptr, v[k])); \
-					y_ptr[i * my->cols] = i - v[k]; \
+					++k; \
+					assert(k >= 0 && k < db->rows); \
+					v[k] = i; \
+					z[k] = s; \
+					z[k + 1] = (_for_type_b)_for_max; \
 				} \
-				++y_ptr; \
-			} else { \
+				assert(z[k + 1] >= db->rows - 1); \
+				k = 0; \
 				for (i = 0; i < db->rows; i++) \
 				{ \
 					while (z[k + 1] < i) \
 					{ \
-						assert(k >= 0 && k < ccv_max(db->rows, db->cols) - 1); \
+						assert(k >= 0 && k < db->rows - 1); \
 						++k; \
 					} \
-					_for_set_b(b_ptr + i * db->step, j, _dy * (i - v[k]) + _dyy * (i - v[k]) * (i - v[k]) + _for_get_b(c_ptr, v[k])); \
+					e_ptr[i] = _dy * (i - v[k]) + _dyy * (i - v[k]) * (i - v[k]) + c_ptr[v[k]]; \
+					y_ptr[i] = i - v[k]; \
 				} \
 			} \
-		} \
+			b_ptr = db->data.u8; \
+			for (i = 0; i < db->rows; i++) \
+			{ \
+				for (j = 0; j < jn; j++) \
+					_for_set_b(b_ptr, j0 + j, e[j * db->rows + i]); \
+				b_ptr += db->step; \
+			} \
+			if (my) \
+			{ \
+				int* y_ptr = my->data.i32 + j0; \
+				for (i = 0; i < db->rows; i++) \
+				{ \
+					for (j = 0; j < jn; j++) \
+						y_ptr[j] = yt[j * db->rows + i]; \
+					y_ptr += my->cols; \
+				} \
+			} \
+			ccfree(z); \
+		} parallel_endfor \
 	} else { \
 		assert(my == 0); \
-		for (j = 0; j < db->cols; j++) \
+		unsigned char* b_ptr = db->data.u8; \
+		for (i = 1; i < db->rows; i++) \
+		{ \
+			for (j = 0; j < db->cols; j++) \
+				_for_set_b(b_ptr + db->step, j, ccv_min(_for_get_b(b_ptr + db->step, j), _for_get_b(b_ptr, j) + _dy)); \
+			b_ptr += db->step; \
+		} \
+		for (i = db->rows - 2; i >= 0; i--) \
 		{ \
-			for (i = 1; i < db->rows; i++) \
-				_for_set_b(b_ptr + i * db->step, j, ccv_min(_for_get_b(b_ptr + i * db->step, j), _for_get_b(b_ptr + (i - 1) * db->step, j) + _dy)); \
-			for (i = db->rows - 2; i >= 0; i--) \
-				_for_set_b(b_ptr + i * db->step, j, ccv_min(_for_get_b(b_ptr + i * db->step, j), _for_get_b(b_ptr + (i + 1) * db->step, j) - _dy)); \
+			for (j = 0; j < db->cols; j++) \
+				_for_set_b(b_ptr - db->step, j, ccv_min(_for_get_b(b_ptr - db->step, j), _for_get_b(b_ptr, j) - _dy)); \
+			b_ptr -= db->step; \
 		} \
 	}
 	if (flag & CCV_NEGATIVE)
@@ -1,5 +1,10 @@
 #include "ccv.h"
 #include "ccv_internal.h"
+#if defined(HAVE_SSE2)
+#include <emmintrin.h>
+#elif defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
 
 /* area interpolation resample is adopted from OpenCV */
 
@@ -8,6 +13,110 @@ typedef struct {
 	unsigned int alpha;
 } ccv_int_alpha;
 
+/* output rows are resampled in bands of about this many rows in parallel */
+#define CCV_RESAMPLE_BAND_ROWS (64)
+
+static int _ccv_resample_bands(int rows)
+{
+	return FOR_IS_PARALLEL ? ccv_max(rows / CCV_RESAMPLE_BAND_ROWS, 1) : 1;
+}
+
+/* area interpolation walks through source rows and writes an output row when it reaches the end of it, find
+ * these source rows first, thus, the output can be split into bands that start where the previous one ends */
+static void _ccv_resample_area_yend(int arows, int brows, double scale_y, int* yend)
+{
+	int sy, dy = 0;
+	for (sy = 0; sy < arows && dy < brows; sy++)
+		if ((dy + 1) * scale_y <= sy + 1 || sy == arows - 1)
+			yend[dy++] = sy;
+	for (; dy < brows; dy++)
+		yend[dy] = arows - 1;
+}
+
+/* the vertical pass of 8-bit area interpolation, adds a source row times its weight to the column sums (or sets them to
+ * it), weights are at most 256, thus, a weighted pixel fits into 16-bit. The sums are unsigned integers, they come out
+ * the same whether source rows are summed up horizontally first or vertically first */
+static void _ccv_resample_area_8u_vertical(const unsigned char* a_ptr, unsigned int* sum, unsigned int alpha, int accumulate, int count)
+{
+	int x = 0;
+#if defined(HAVE_SSE2)
+	__m128i z = _mm_setzero_si128();
+	__m128i w = _mm_set1_epi16(alpha);
+	for (; x < count - 15; x += 16)
+	{
+		__m128i v = _mm_loadu_si128((__m128i*)(a_ptr + x));
+		__m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(v, z), w);
+		__m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(v, z), w);
+		__m128i s0 = _mm_unpacklo_epi16(lo, z);
+		__m128i s1 = _mm_unpackhi_epi16(lo, z);
+		__m128i s2 = _mm_unpacklo_epi16(hi, z);
+		__m128i s3 = _mm_unpackhi_epi16(hi, z);
+		if (accumulate)
+		{
+			s0 = _mm_add_epi32(s0, _mm_loadu_si128((__m128i*)(sum + x)));
+			s1 = _mm_add_epi32(s1, _mm_loadu_si128((__m128i*)(sum + x + 4)));
+			s2 = _mm_add_epi32(s2, _mm_loadu_si128((__m128i*)(sum + x + 8)));
+			s3 = _mm_add_epi32(s3, _mm_loadu_si128((__m128i*)(sum + x + 12)));
+		}
+		_mm_storeu_si128((__m128i*)(sum + x), s0);
+		_mm_storeu_si128((__m128i*)(sum + x + 4), s1);
+		_mm_storeu_si128((__m128i*)(sum + x + 8), s2);
+		_mm_storeu_si128((__m128i*)(sum + x + 12), s3);
+	}
+#elif defined(HAVE_NEON)
+	uint16x4_t w = vdup_n_u16(alpha);
+	for (; x < count - 15; x += 16)
+	{
+		uint8x16_t v = vld1q_u8(a_ptr + x);
+		uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+		uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+		uint32x4_t s0 = accumulate ? vld1q_u32(sum + x) : vdupq_n_u32(0);
+		uint32x4_t s1 = accumulate ? vld1q_u32(sum + x + 4) : vdupq_n_u32(0);
+		uint32x4_t s2 = accumulate ? vld1q_u32(sum + x + 8) : vdupq_n_u32(0);
+		uint32x4_t s3 = accumulate ? vld1q_u32(sum + x + 12) : vdupq_n_u32(0);
+		vst1q_u32(sum + x, vmlal_u16(s0, vget_low_u16(lo), w));
+		vst1q_u32(sum + x + 4, vmlal_u16(s1, vget_high_u16(lo), w));
+		vst1q_u32(sum + x + 8, vmlal_u16(s2, vget_low_u16(hi), w));
+		vst1q_u32(sum + x + 12, vmlal_u16(s3, vget_high_u16(hi), w));
+	}
+#endif
+	if (accumulate)
+		for (; x < count; x++)
+			sum[x] += a_ptr[x] * alpha;
+	else
+		for (; x < count; x++)
+			sum[x] = a_ptr[x] * alpha;
+}
+
+/* divide the weighted sums by the fixed point scale, clamp and write them out. The sums are less than 2^32 and the scale
+ * is less than 2^24 (the source is less than 0x100 times larger), thus, the quotient plus half of the reciprocal in double
+ * precision stays at least 2^-25 away from any integer, and truncating it is the same as the integer division */
+static void _ccv_resample_area_8u_descale(const unsigned int* buf, unsigned char* b_ptr, unsigned int inv_scale_256, int count)
+{
+	int x = 0;
+#if defined(HAVE_SSE2)
+	__m128d r = _mm_set1_pd(1.0 / inv_scale_256);
+	__m128d h = _mm_set1_pd(0.5 / inv_scale_256);
+	__m128i sign = _mm_set1_epi32(0x80000000);
+	__m128d offset = _mm_set1_pd(2147483648.0);
+	for (; x < count - 7; x += 8)
+	{
+		__m128i v0 = _mm_xor_si128(_mm_loadu_si128((__m128i*)(buf + x)), sign);
+		__m128i v1 = _mm_xor_si128(_mm_loadu_si128((__m128i*)(buf + x + 4)), sign);
+		// unsigned to double, by way of signed with the top bit flipped
+		__m128i q0 = _mm_unpacklo_epi64(_mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_cvtepi32_pd(v0), offset), r), h)),
+										_mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_cvtepi32_pd(_mm_srli_si128(v0, 8)), offset), r), h)));
+		__m128i q1 = _mm_unpacklo_epi64(_mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_cvtepi32_pd(v1), offset), r), h)),
+										_mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_cvtepi32_pd(_mm_srli_si128(v1, 8)), offset), r), h)));
+		__m128i q = _mm_packs_epi32(q0, q1);
+		_mm_storel_epi64((__m128i*)(b_ptr + x), _mm_packus_epi16(q, q));
+	}
+#endif
+	// NEON has no double precision before ARMv8, it takes the integer division as well
+	for (; x < count; x++)
+		b_ptr[x] = ccv_clamp(buf[x] / inv_scale_256, 0, 255);
+}
+
 static void _ccv_resample_area_8u(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 {
 	assert(a->cols > 0 && b->cols > 0);
@@ -17,7 +126,7 @@ static void _ccv_resample_area_8u(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 	double scale_y = (double)a->rows / b->rows;
 	// double scale = 1.f / (scale_x * scale_y);
 	unsigned int inv_scale_256 = (int)(scale_x * scale_y * 0x10000);
-	int dx, dy, sx, sy, i, k;
+	int dx, sx, k;
 	for (dx = 0, k = 0; dx < b->cols; dx++)
 	{
 		double fsx1 = dx * scale_x, fsx2 = fsx1 + scale_x;
@@ -47,52 +156,47 @@ static void _ccv_resample_area_8u(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 		}
 	}
 	int xofs_count = k;
-	unsigned int* buf = (unsigned int*)alloca(b->cols * ch * sizeof(unsigned int));
-	unsigned int* sum = (unsigned int*)alloca(b->cols * ch * sizeof(unsigned int));
-	for (dx = 0; dx < b->cols * ch; dx++)
-		buf[dx] = sum[dx] = 0;
-	dy = 0;
-	for (sy = 0; sy < a->rows; sy++)
-	{
-		unsigned char* a_ptr = a->data.u8 + a->step * sy;
-		for (k = 0; k < xofs_count; k++)
+	int* yend = (int*)alloca(sizeof(int) * b->rows);
+	_ccv_resample_area_yend(a->rows, b->rows, scale_y, yend);
+	const int bands = _ccv_resample_bands(b->rows);
+	parallel_for(t, bands) {
+		const int dy0 = t * b->rows / bands, dy1 = (t + 1) * b->rows / bands;
+		int dx, dy, sy, i, k;
+		// the weighted column sums of the source rows for the current output row, and the row sums of them
+		unsigned int* sum = (unsigned int*)ccmalloc((a->cols + b->cols) * ch * sizeof(unsigned int));
+		unsigned int* buf = sum + a->cols * ch;
+		for (dx = 0; dx < a->cols * ch; dx++)
+			sum[dx] = 0;
+		// start from the source row where the previous band ends, only to carry over its share to this band
+		dy = ccv_max(dy0 - 1, 0);
+		for (sy = dy0 > 0 ? yend[dy0 - 1] : 0; sy < a->rows && dy < dy1; sy++)
 		{
-			int dxn = xofs[k].di;
-			unsigned int alpha = xofs[k].alpha;
-			for (i = 0; i < ch; i++)
-				buf[dxn + i] += a_ptr[xofs[k].si + i] * alpha;
-		}
-		if ((dy + 1) * scale_y <= sy + 1 || sy == a->rows - 1)
-		{
-			unsigned int beta = (int)(ccv_max(sy + 1 - (dy + 1) * scale_y, 0.f) * 256);
-			unsigned int beta1 = 256 - beta;
-			unsigned char* b_ptr = b->data.u8 + b->step * dy;
-			if (beta <= 0)
+			unsigned char* a_ptr = a->data.u8 + a->step * sy;
+			if ((dy + 1) * scale_y <= sy + 1 || sy == a->rows - 1)
 			{
-				for (dx = 0; dx < b->cols * ch; dx++)
-				{
-					b_ptr[dx] = ccv_clamp((sum[dx] + buf[dx] * 256) / inv_scale_256, 0, 255);
-					sum[dx] = buf[dx] = 0;
-				}
-			} else {
-				for (dx = 0; dx < b->cols * ch; dx++)
+				unsigned int beta = (int)(ccv_max(sy + 1 - (dy + 1) * scale_y, 0.f) * 256);
+				if (dy >= dy0)
 				{
-					b_ptr[dx] = ccv_clamp((sum[dx] + buf[dx] * beta1) / inv_scale_256, 0, 255);
-					sum[dx] = buf[dx] * beta;
-					buf[dx] = 0;
+					_ccv_resample_area_8u_vertical(a_ptr, sum, 256 - beta, 1, a->cols * ch);
+					for (dx = 0; dx < b->cols * ch; dx++)
+						buf[dx] = 0;
+					for (k = 0; k < xofs_count; k++)
+					{
+						int dxn = xofs[k].di;
+						unsigned int alpha = xofs[k].alpha;
+						for (i = 0; i < ch; i++)
+							buf[dxn + i] += sum[xofs[k].si + i] * alpha;
+					}
+					_ccv_resample_area_8u_descale(buf, b->data.u8 + b->step * dy, inv_scale_256, b->cols * ch);
 				}
-			}
-			dy++;
-		}
-		else
-		{
-			for(dx = 0; dx < b->cols * ch; dx++)
-			{
-				sum[dx] += buf[dx] * 256;
-				buf[dx] = 0;
-			}
+				// the rest of this source row goes to the next output row
+				_ccv_resample_area_8u_vertical(a_ptr, sum, beta, 0, a->cols * ch);
+				dy++;
+			} else
+				_ccv_resample_area_8u_vertical(a_ptr, sum, 256, 1, a->cols * ch);
 		}
-	}
+		ccfree(sum);
+	} parallel_endfor
 }
 
 typedef struct {
@@ -100,6 +204,62 @@ typedef struct {
 	float alpha;
 } ccv_area_alpha_t;
 
+/* the row flush of float area interpolation: writes sum + buf * beta1 to a 32-bit float row if there is one, carries
+ * buf * beta (or nothing if beta is 0) over to the sum of the next row, and clears buf. Each element takes the same float
+ * operations in the same order as the generic loop. Returns how many elements are done, the rest falls back to it */
+static int _ccv_resample_area_flush_32f(float* buf, float* sum, float* b_ptr, float beta, float beta1, int count)
+{
+	int x = 0;
+#if defined(HAVE_SSE2)
+	__m128 z = _mm_setzero_ps();
+	__m128 b1 = _mm_set1_ps(beta1);
+	__m128 b0 = _mm_set1_ps(beta);
+	for (; x < count - 3; x += 4)
+	{
+		__m128 v = _mm_loadu_ps(buf + x);
+		if (b_ptr)
+			_mm_storeu_ps(b_ptr + x, _mm_add_ps(_mm_loadu_ps(sum + x), _mm_mul_ps(v, b1)));
+		_mm_storeu_ps(sum + x, beta == 0 ? z : _mm_mul_ps(v, b0));
+		_mm_storeu_ps(buf + x, z);
+	}
+#elif defined(HAVE_NEON)
+	float32x4_t z = vdupq_n_f32(0);
+	float32x4_t b1 = vdupq_n_f32(beta1);
+	float32x4_t b0 = vdupq_n_f32(beta);
+	for (; x < count - 3; x += 4)
+	{
+		float32x4_t v = vld1q_f32(buf + x);
+		if (b_ptr)
+			vst1q_f32(b_ptr + x, vaddq_f32(vld1q_f32(sum + x), vmulq_f32(v, b1)));
+		vst1q_f32(sum + x, beta == 0 ? z : vmulq_f32(v, b0));
+		vst1q_f32(buf + x, z);
+	}
+#endif
+	return x;
+}
+
+/* adds buf to the sum of the current row and clears it, returns how many elements are done as above */
+static int _ccv_resample_area_sum_32f(float* buf, float* sum, int count)
+{
+	int x = 0;
+#if defined(HAVE_SSE2)
+	__m128 z = _mm_setzero_ps();
+	for (; x < count - 3; x += 4)
+	{
+		_mm_storeu_ps(sum + x, _mm_add_ps(_mm_loadu_ps(sum + x), _mm_loadu_ps(buf + x)));
+		_mm_storeu_ps(buf + x, z);
+	}
+#elif defined(HAVE_NEON)
+	float32x4_t z = vdupq_n_f32(0);
+	for (; x < count - 3; x += 4)
+	{
+		vst1q_f32(sum + x, vaddq_f32(vld1q_f32(sum + x), vld1q_f32(buf + x)));
+		vst1q_f32(buf + x, z);
+	}
+#endif
+	return x;
+}
+
 static void _ccv_resample_area(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 {
 	assert(a->cols > 0 && b->cols > 0);
@@ -108,7 +268,7 @@ static void _ccv_resample_area(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 	double scale_x = (double)a->cols / b->cols;
 	double scale_y = (double)a->rows / b->rows;
 	double scale = 1.f / (scale_x * scale_y);
-	int dx, dy, sx, sy, i, k;
+	int dx, sx, k;
 	for (dx = 0, k = 0; dx < b->cols; dx++)
 	{
 		double fsx1 = dx * scale_x, fsx2 = fsx1 + scale_x;
@@ -138,53 +298,72 @@ static void _ccv_resample_area(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 		}
 	}
 	int xofs_count = k;
-	float* buf = (float*)alloca(b->cols * ch * sizeof(float));
-	float* sum = (float*)alloca(b->cols * ch * sizeof(float));
-	for (dx = 0; dx < b->cols * ch; dx++)
-		buf[dx] = sum[dx] = 0;
-	dy = 0;
+	int* yend = (int*)alloca(sizeof(int) * b->rows);
+	_ccv_resample_area_yend(a->rows, b->rows, scale_y, yend);
+	const int bands = _ccv_resample_bands(b->rows);
+	const int b_32f = (CCV_GET_DATA_TYPE(b->type) == CCV_32F);
 #define for_block(_for_get, _for_set) \
-	for (sy = 0; sy < a->rows; sy++) \
-	{ \
-		unsigned char* a_ptr = a->data.u8 + a->step * sy; \
-		for (k = 0; k < xofs_count; k++) \
+	parallel_for(t, bands) { \
+		const int dy0 = t * b->rows / bands, dy1 = (t + 1) * b->rows / bands; \
+		int dx, dy, sy, i, k; \
+		float* buf = (float*)ccmalloc(b->cols * ch * sizeof(float) * 2); \
+		float* sum = buf + b->cols * ch; \
+		for (dx = 0; dx < b->cols * ch; dx++) \
+			buf[dx] = sum[dx] = 0; \
+		dy = ccv_max(dy0 - 1, 0); \
+		for (sy = dy0 > 0 ? yend[dy0 - 1] : 0; sy < a->rows && dy < dy1; sy++) \
 		{ \
-			int dxn = xofs[k].di; \
-			float alpha = xofs[k].alpha; \
-			for (i = 0; i < ch; i++) \
-				buf[dxn + i] += _for_get(a_ptr, xofs[k].si + i) * alpha; \
-		} \
-		if ((dy + 1) * scale_y <= sy + 1 || sy == a->rows - 1) \
-		{ \
-			float beta = ccv_max(sy + 1 - (dy + 1) * scale_y, 0.f); \
-			float beta1 = 1 - beta; \
-			unsigned char* b_ptr = b->data.u8 + b->step * dy; \
-			if (fabs(beta) < 1e-3) \
+			unsigned char* a_ptr = a->data.u8 + a->step * sy; \
+			for (k = 0; k < xofs_count; k++) \
 			{ \
-				for (dx = 0; dx < b->cols * ch; dx++) \
+				int dxn = xofs[k].di; \
+				float alpha = xofs[k].alpha; \
+				for (i = 0; i < ch; i++) \
+					buf[dxn + i] += _for_get(a_ptr, xofs[k].si + i) * alpha; \
+			} \
+			if ((dy + 1) * scale_y <= sy + 1 || sy == a->rows - 1) \
+			{ \
+				float beta = ccv_max(sy + 1 - (dy + 1) * scale_y, 0.f); \
+				float beta1 = 1 - beta; \
+				unsigned char* b_ptr = b->data.u8 + b->step * dy; \
+				if (dy < dy0) \
 				{ \
-					_for_set(b_ptr, dx, sum[dx] + buf[dx]); \
-					sum[dx] = buf[dx] = 0; \
+					dx = _ccv_resample_area_flush_32f(buf, sum, 0, fabs(beta) < 1e-3 ? 0 : beta, 1, b->cols * ch); \
+					for (; dx < b->cols * ch; dx++) \
+					{ \
+						sum[dx] = fabs(beta) < 1e-3 ? 0 : buf[dx] * beta; \
+						buf[dx] = 0; \
+					} \
+				} else if (fabs(beta) < 1e-3) { \
+					/* buf * 1 is buf, bit by bit */ \
+					dx = b_32f ? _ccv_resample_area_flush_32f(buf, sum, (float*)b_ptr, 0, 1, b->cols * ch) : 0; \
+					for (; dx < b->cols * ch; dx++) \
+					{ \
+						_for_set(b_ptr, dx, sum[dx] + buf[dx]); \
+						sum[dx] = buf[dx] = 0; \
+					} \
+				} else { \
+					dx = b_32f ? _ccv_resample_area_flush_32f(buf, sum, (float*)b_ptr, beta, beta1, b->cols * ch) : 0; \
+					for (; dx < b->cols * ch; dx++) \
+					{ \
+						_for_set(b_ptr, dx, sum[dx] + buf[dx] * beta1); \
+						sum[dx] = buf[dx] * beta; \
+						buf[dx] = 0; \
+					} \
 				} \
-			} else { \
-				for (dx = 0; dx < b->cols * ch; dx++) \
+				dy++; \
+			} \
+			else \
+			{ \
+				for(dx = _ccv_resample_area_sum_32f(buf, sum, b->cols * ch); dx < b->cols * ch; dx++) \
 				{ \
-					_for_set(b_ptr, dx, sum[dx] + buf[dx] * beta1); \
-					sum[dx] = buf[dx] * beta; \
+					sum[dx] += buf[dx]; \
 					buf[dx] = 0; \
 				} \
 			} \
-			dy++; \
-		} \
-		else \
-		{ \
-			for(dx = 0; dx < b->cols * ch; dx++) \
-			{ \
-				sum[dx] += buf[dx]; \
-				buf[dx] = 0; \
-			} \
 		} \
-	}
+		ccfree(buf); \
+	} parallel_endfor
 	ccv_matrix_getter(a->type, ccv_matrix_setter, b->type, for_block);
 #undef for_block
 }
@@ -213,10 +392,46 @@ static void _ccv_init_cubic_coeffs(int si, int sz, float s, ccv_cubic_coeffs_t*
 	coeff->coeffs[3] = 1.f - coeff->coeffs[0] - coeff->coeffs[1] - coeff->coeffs[2];
 }
 
+/* the vertical pass of float cubic interpolation into a 32-bit float matrix, each element takes the same float operations
+ * in the same order as the generic loop is written (-ffast-math may reassociate the latter by an ulp or so). Returns how
+ * many elements are done, the rest falls back to the generic loop */
+static int _ccv_resample_cubic_vertical_32f(unsigned char** buf, const float* coeffs, unsigned char* b_ptr, int count)
+{
+	int j = 0;
+#if defined(HAVE_SSE2)
+	float* row[4] = { (float*)buf[0], (float*)buf[1], (float*)buf[2], (float*)buf[3] };
+	__m128 c0 = _mm_set1_ps(coeffs[0]);
+	__m128 c1 = _mm_set1_ps(coeffs[1]);
+	__m128 c2 = _mm_set1_ps(coeffs[2]);
+	__m128 c3 = _mm_set1_ps(coeffs[3]);
+	for (; j < count - 3; j += 4)
+	{
+		__m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(row[0] + j), c0), _mm_mul_ps(_mm_loadu_ps(row[1] + j), c1));
+		v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(row[2] + j), c2));
+		v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(row[3] + j), c3));
+		_mm_storeu_ps((float*)b_ptr + j, v);
+	}
+#elif defined(HAVE_NEON)
+	float* row[4] = { (float*)buf[0], (float*)buf[1], (float*)buf[2], (float*)buf[3] };
+	float32x4_t c0 = vdupq_n_f32(coeffs[0]);
+	float32x4_t c1 = vdupq_n_f32(coeffs[1]);
+	float32x4_t c2 = vdupq_n_f32(coeffs[2]);
+	float32x4_t c3 = vdupq_n_f32(coeffs[3]);
+	for (; j < count - 3; j += 4)
+	{
+		float32x4_t v = vaddq_f32(vmulq_f32(vld1q_f32(row[0] + j), c0), vmulq_f32(vld1q_f32(row[1] + j), c1));
+		v = vaddq_f32(v, vmulq_f32(vld1q_f32(row[2] + j), c2));
+		v = vaddq_f32(v, vmulq_f32(vld1q_f32(row[3] + j), c3));
+		vst1q_f32((float*)b_ptr + j, v);
+	}
+#endif
+	return j;
+}
+
 static void _ccv_resample_cubic_float_only(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 {
 	assert(CCV_GET_DATA_TYPE(b->type) == CCV_32F || CCV_GET_DATA_TYPE(b->type) == CCV_64F);
-	int i, j, k, ch = CCV_GET_CHANNEL(a->type);
+	int i, ch = CCV_GET_CHANNEL(a->type);
 	assert(b->cols > 0 && b->step > 0);
 	ccv_cubic_coeffs_t* xofs = (ccv_cubic_coeffs_t*)alloca(sizeof(ccv_cubic_coeffs_t) * b->cols);
 	float scale_x = (float)a->cols / b->cols;
@@ -226,45 +441,51 @@ static void _ccv_resample_cubic_float_only(ccv_dense_matrix_t* a, ccv_dense_matr
 		_ccv_init_cubic_coeffs((int)sx, a->cols, sx, xofs + i);
 	}
 	float scale_y = (float)a->rows / b->rows;
-	unsigned char* buf = (unsigned char*)alloca(b->step * 4);
-#ifdef __clang_analyzer__
-	memset(buf, 0, b->step * 4);
-#endif
-	unsigned char* a_ptr = a->data.u8;
-	unsigned char* b_ptr = b->data.u8;
-	int psi = -1, siy = 0;
+	const int bands = _ccv_resample_bands(b->rows);
+	const int b_32f = (CCV_GET_DATA_TYPE(b->type) == CCV_32F);
 #define for_block(_for_get, _for_set_b, _for_get_b) \
-	for (i = 0; i < b->rows; i++) \
-	{ \
+	parallel_for(t, bands) { \
+		const int i0 = t * b->rows / bands, i1 = (t + 1) * b->rows / bands; \
+		int i, j, k; \
+		unsigned char* buf = (unsigned char*)ccmalloc(b->step * 4); \
 		ccv_cubic_coeffs_t yofs; \
-		float sy = (i + 0.5) * scale_y - 0.5; \
-		_ccv_init_cubic_coeffs((int)sy, a->rows, sy, &yofs); \
-		if (yofs.si[3] > psi) \
+		_ccv_init_cubic_coeffs((int)((i0 + 0.5) * scale_y - 0.5), a->rows, (i0 + 0.5) * scale_y - 0.5, &yofs); \
+		int psi = -1, siy = yofs.si[0]; \
+		unsigned char* a_ptr = a->data.u8 + a->step * siy; \
+		unsigned char* b_ptr = b->data.u8 + b->step * i0; \
+		for (i = i0; i < i1; i++) \
 		{ \
-			for (; siy <= yofs.si[3]; siy++) \
+			float sy = (i + 0.5) * scale_y - 0.5; \
+			_ccv_init_cubic_coeffs((int)sy, a->rows, sy, &yofs); \
+			if (yofs.si[3] > psi) \
 			{ \
-				unsigned char* row = buf + (siy & 0x3) * b->step; \
-				for (j = 0; j < b->cols; j++) \
-					for (k = 0; k < ch; k++) \
-						_for_set_b(row, j * ch + k, _for_get(a_ptr, xofs[j].si[0] * ch + k) * xofs[j].coeffs[0] + \
-													_for_get(a_ptr, xofs[j].si[1] * ch + k) * xofs[j].coeffs[1] + \
-													_for_get(a_ptr, xofs[j].si[2] * ch + k) * xofs[j].coeffs[2] + \
-													_for_get(a_ptr, xofs[j].si[3] * ch + k) * xofs[j].coeffs[3]); \
-				a_ptr += a->step; \
+				for (; siy <= yofs.si[3]; siy++) \
+				{ \
+					unsigned char* row = buf + (siy & 0x3) * b->step; \
+					for (j = 0; j < b->cols; j++) \
+						for (k = 0; k < ch; k++) \
+							_for_set_b(row, j * ch + k, _for_get(a_ptr, xofs[j].si[0] * ch + k) * xofs[j].coeffs[0] + \
+														_for_get(a_ptr, xofs[j].si[1] * ch + k) * xofs[j].coeffs[1] + \
+														_for_get(a_ptr, xofs[j].si[2] * ch + k) * xofs[j].coeffs[2] + \
+														_for_get(a_ptr, xofs[j].si[3] * ch + k) * xofs[j].coeffs[3]); \
+					a_ptr += a->step; \
+				} \
+				psi = yofs.si[3]; \
 			} \
-			psi = yofs.si[3]; \
+			unsigned char* row[4] = { \
+				buf + (yofs.si[0] & 0x3) * b->step, \
+				buf + (yofs.si[1] & 0x3) * b->step, \
+				buf + (yofs.si[2] & 0x3) * b->step, \
+				buf + (yofs.si[3] & 0x3) * b->step, \
+			}; \
+			j = b_32f ? _ccv_resample_cubic_vertical_32f(row, yofs.coeffs, b_ptr, b->cols * ch) : 0; \
+			for (; j < b->cols * ch; j++) \
+				_for_set_b(b_ptr, j, _for_get_b(row[0], j, 0) * yofs.coeffs[0] + _for_get_b(row[1], j) * yofs.coeffs[1] + \
+									 _for_get_b(row[2], j, 0) * yofs.coeffs[2] + _for_get_b(row[3], j) * yofs.coeffs[3]); \
+			b_ptr += b->step; \
 		} \
-		unsigned char* row[4] = { \
-			buf + (yofs.si[0] & 0x3) * b->step, \
-			buf + (yofs.si[1] & 0x3) * b->step, \
-			buf + (yofs.si[2] & 0x3) * b->step, \
-			buf + (yofs.si[3] & 0x3) * b->step, \
-		}; \
-		for (j = 0; j < b->cols * ch; j++) \
-			_for_set_b(b_ptr, j, _for_get_b(row[0], j, 0) * yofs.coeffs[0] + _for_get_b(row[1], j) * yofs.coeffs[1] + \
-								 _for_get_b(row[2], j, 0) * yofs.coeffs[2] + _for_get_b(row[3], j) * yofs.coeffs[3]); \
-		b_ptr += b->step; \
-	}
+		ccfree(buf); \
+	} parallel_endfor
 	ccv_matrix_getter(a->type, ccv_matrix_setter_getter_float_only, b->type, for_block);
 #undef for_block
 }
@@ -284,10 +505,58 @@ static void _ccv_init_cubic_integer_coeffs(int si, int sz, float s, ccv_cubic_in
 	coeff->coeffs[3] = W_BITS - coeff->coeffs[0] - coeff->coeffs[1] - coeff->coeffs[2];
 }
 
+/* the vertical pass of 8-bit cubic interpolation, rows hold horizontal results of 8-bit pixels with weights summed
+ * up to 64, thus, they fit into 16-bit, and the saturated pack is the same as clamping to 0~255. Returns how many
+ * pixels are done, the rest falls back to the generic loop */
+static int _ccv_resample_cubic_vertical_8u(unsigned char** buf, const int* coeffs, unsigned char* b_ptr, int count)
+{
+	int j = 0;
+#if defined(HAVE_SSE2)
+	int* row[4] = { (int*)buf[0], (int*)buf[1], (int*)buf[2], (int*)buf[3] };
+	__m128i c01 = _mm_set_epi16(coeffs[1], coeffs[0], coeffs[1], coeffs[0], coeffs[1], coeffs[0], coeffs[1], coeffs[0]);
+	__m128i c23 = _mm_set_epi16(coeffs[3], coeffs[2], coeffs[3], coeffs[2], coeffs[3], coeffs[2], coeffs[3], coeffs[2]);
+	__m128i delta = _mm_set1_epi32(1 << 11);
+	for (; j < count - 7; j += 8)
+	{
+		__m128i r0 = _mm_packs_epi32(_mm_loadu_si128((__m128i*)(row[0] + j)), _mm_loadu_si128((__m128i*)(row[0] + j + 4)));
+		__m128i r1 = _mm_packs_epi32(_mm_loadu_si128((__m128i*)(row[1] + j)), _mm_loadu_si128((__m128i*)(row[1] + j + 4)));
+		__m128i r2 = _mm_packs_epi32(_mm_loadu_si128((__m128i*)(row[2] + j)), _mm_loadu_si128((__m128i*)(row[2] + j + 4)));
+		__m128i r3 = _mm_packs_epi32(_mm_loadu_si128((__m128i*)(row[3] + j)), _mm_loadu_si128((__m128i*)(row[3] + j + 4)));
+		__m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(r0, r1), c01), _mm_madd_epi16(_mm_unpacklo_epi16(r2, r3), c23));
+		__m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(r0, r1), c01), _mm_madd_epi16(_mm_unpackhi_epi16(r2, r3), c23));
+		lo = _mm_srai_epi32(_mm_add_epi32(lo, delta), 12);
+		hi = _mm_srai_epi32(_mm_add_epi32(hi, delta), 12);
+		__m128i v = _mm_packs_epi32(lo, hi);
+		_mm_storel_epi64((__m128i*)(b_ptr + j), _mm_packus_epi16(v, v));
+	}
+#elif defined(HAVE_NEON)
+	int* row[4] = { (int*)buf[0], (int*)buf[1], (int*)buf[2], (int*)buf[3] };
+	int16x4_t c = vmovn_s32(vld1q_s32(coeffs));
+	for (; j < count - 7; j += 8)
+	{
+		int16x8_t r0 = vcombine_s16(vmovn_s32(vld1q_s32(row[0] + j)), vmovn_s32(vld1q_s32(row[0] + j + 4)));
+		int16x8_t r1 = vcombine_s16(vmovn_s32(vld1q_s32(row[1] + j)), vmovn_s32(vld1q_s32(row[1] + j + 4)));
+		int16x8_t r2 = vcombine_s16(vmovn_s32(vld1q_s32(row[2] + j)), vmovn_s32(vld1q_s32(row[2] + j + 4)));
+		int16x8_t r3 = vcombine_s16(vmovn_s32(vld1q_s32(row[3] + j)), vmovn_s32(vld1q_s32(row[3] + j + 4)));
+		int32x4_t lo = vmull_lane_s16(vget_low_s16(r0), c, 0);
+		lo = vmlal_lane_s16(lo, vget_low_s16(r1), c, 1);
+		lo = vmlal_lane_s16(lo, vget_low_s16(r2), c, 2);
+		lo = vmlal_lane_s16(lo, vget_low_s16(r3), c, 3);
+		int32x4_t hi = vmull_lane_s16(vget_high_s16(r0), c, 0);
+		hi = vmlal_lane_s16(hi, vget_high_s16(r1), c, 1);
+		hi = vmlal_lane_s16(hi, vget_high_s16(r2), c, 2);
+		hi = vmlal_lane_s16(hi, vget_high_s16(r3), c, 3);
+		int16x8_t v = vcombine_s16(vrshrn_n_s32(lo, 12), vrshrn_n_s32(hi, 12));
+		vst1_u8(b_ptr + j, vqmovun_s16(v));
+	}
+#endif
+	return j;
+}
+
 static void _ccv_resample_cubic_integer_only(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b)
 {
 	assert(CCV_GET_DATA_TYPE(b->type) == CCV_8U || CCV_GET_DATA_TYPE(b->type) == CCV_32S || CCV_GET_DATA_TYPE(b->type) == CCV_64S);
-	int i, j, k, ch = CCV_GET_CHANNEL(a->type);
+	int i, ch = CCV_GET_CHANNEL(a->type);
 	int no_8u_type = (b->type & CCV_8U) ? CCV_32S : b->type;
 	assert(b->cols > 0);
 	ccv_cubic_integer_coeffs_t* xofs = (ccv_cubic_integer_coeffs_t*)alloca(sizeof(ccv_cubic_integer_coeffs_t) * b->cols);
@@ -299,45 +568,51 @@ static void _ccv_resample_cubic_integer_only(ccv_dense_matrix_t* a, ccv_dense_ma
 	}
 	float scale_y = (float)a->rows / b->rows;
 	int bufstep = b->cols * ch * CCV_GET_DATA_TYPE_SIZE(no_8u_type);
-	unsigned char* buf = (unsigned char*)alloca(bufstep * 4);
-#ifdef __clang_analyzer__
-	memset(buf, 0, bufstep * 4);
-#endif
-	unsigned char* a_ptr = a->data.u8;
-	unsigned char* b_ptr = b->data.u8;
-	int psi = -1, siy = 0;
+	const int bands = _ccv_resample_bands(b->rows);
+	const int vectorized = (CCV_GET_DATA_TYPE(b->type) == CCV_8U && CCV_GET_DATA_TYPE(a->type) == CCV_8U);
 #define for_block(_for_get_a, _for_set, _for_get, _for_set_b) \
-	for (i = 0; i < b->rows; i++) \
-	{ \
+	parallel_for(t, bands) { \
+		const int i0 = t * b->rows / bands, i1 = (t + 1) * b->rows / bands; \
+		int i, j, k; \
+		unsigned char* buf = (unsigned char*)ccmalloc(bufstep * 4); \
 		ccv_cubic_integer_coeffs_t yofs; \
-		float sy = (i + 0.5) * scale_y - 0.5; \
-		_ccv_init_cubic_integer_coeffs((int)sy, a->rows, sy, &yofs); \
-		if (yofs.si[3] > psi) \
+		_ccv_init_cubic_integer_coeffs((int)((i0 + 0.5) * scale_y - 0.5), a->rows, (i0 + 0.5) * scale_y - 0.5, &yofs); \
+		int psi = -1, siy = yofs.si[0]; \
+		unsigned char* a_ptr = a->data.u8 + a->step * siy; \
+		unsigned char* b_ptr = b->data.u8 + b->step * i0; \
+		for (i = i0; i < i1; i++) \
 		{ \
-			for (; siy <= yofs.si[3]; siy++) \
+			float sy = (i + 0.5) * scale_y - 0.5; \
+			_ccv_init_cubic_integer_coeffs((int)sy, a->rows, sy, &yofs); \
+			if (yofs.si[3] > psi) \
 			{ \
-				unsigned char* row = buf + (siy & 0x3) * bufstep; \
-				for (j = 0; j < b->cols; j++) \
-					for (k = 0; k < ch; k++) \
-						_for_set(row, j * ch + k, _for_get_a(a_ptr, xofs[j].si[0] * ch + k) * xofs[j].coeffs[0] + \
-												  _for_get_a(a_ptr, xofs[j].si[1] * ch + k) * xofs[j].coeffs[1] + \
-												  _for_get_a(a_ptr, xofs[j].si[2] * ch + k) * xofs[j].coeffs[2] + \
-												  _for_get_a(a_ptr, xofs[j].si[3] * ch + k) * xofs[j].coeffs[3]); \
-				a_ptr += a->step; \
+				for (; siy <= yofs.si[3]; siy++) \
+				{ \
+					unsigned char* row = buf + (siy & 0x3) * bufstep; \
+					for (j = 0; j < b->cols; j++) \
+						for (k = 0; k < ch; k++) \
+							_for_set(row, j * ch + k, _for_get_a(a_ptr, xofs[j].si[0] * ch + k) * xofs[j].coeffs[0] + \
+													  _for_get_a(a_ptr, xofs[j].si[1] * ch + k) * xofs[j].coeffs[1] + \
+													  _for_get_a(a_ptr, xofs[j].si[2] * ch + k) * xofs[j].coeffs[2] + \
+													  _for_get_a(a_ptr, xofs[j].si[3] * ch + k) * xofs[j].coeffs[3]); \
+					a_ptr += a->step; \
+				} \
+				psi = yofs.si[3]; \
 			} \
-			psi = yofs.si[3]; \
+			unsigned char* row[4] = { \
+				buf + (yofs.si[0] & 0x3) * bufstep, \
+				buf + (yofs.si[1] & 0x3) * bufstep, \
+				buf + (yofs.si[2] & 0x3) * bufstep, \
+				buf + (yofs.si[3] & 0x3) * bufstep, \
+			}; \
+			j = vectorized ? _ccv_resample_cubic_vertical_8u(row, yofs.coeffs, b_ptr, b->cols * ch) : 0; \
+			for (; j < b->cols * ch; j++) \
+				_for_set_b(b_ptr, j, ccv_descale(_for_get(row[0], j) * yofs.coeffs[0] + _for_get(row[1], j) * yofs.coeffs[1] + \
+												 _for_get(row[2], j) * yofs.coeffs[2] + _for_get(row[3], j) * yofs.coeffs[3], 12)); \
+			b_ptr += b->step; \
 		} \
-		unsigned char* row[4] = { \
-			buf + (yofs.si[0] & 0x3) * bufstep, \
-			buf + (yofs.si[1] & 0x3) * bufstep, \
-			buf + (yofs.si[2] & 0x3) * bufstep, \
-			buf + (yofs.si[3] & 0x3) * bufstep, \
-		}; \
-		for (j = 0; j < b->cols * ch; j++) \
-			_for_set_b(b_ptr, j, ccv_descale(_for_get(row[0], j) * yofs.coeffs[0] + _for_get(row[1], j) * yofs.coeffs[1] + \
-											 _for_get(row[2], j) * yofs.coeffs[2] + _for_get(row[3], j) * yofs.coeffs[3], 12)); \
-		b_ptr += b->step; \
-	}
+		ccfree(buf); \
+	} parallel_endfor
 	ccv_matrix_getter(a->type, ccv_matrix_setter_getter_integer_only, no_8u_type, ccv_matrix_setter_integer_only, b->type, for_block);
 #undef for_block
 }
@@ -349,6 +624,8 @@ void ccv_resample(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int btype, int
 	btype = (btype == 0) ? CCV_GET_DATA_TYPE(a->type) | CCV_GET_CHANNEL(a->type) : CCV_GET_DATA_TYPE(btype) | CCV_GET_CHANNEL(a->type);
 	ccv_dense_matrix_t* db = *b = ccv_dense_matrix_renew(*b, rows, cols, CCV_ALL_DATA_TYPE | CCV_GET_CHANNEL(a->type), btype, sig);
 	ccv_object_return_if_cached(, db);
+	// area touches every pixel of the larger one, cubic takes 16 samples per output pixel
+	ccv_cache_cost_hint(db->sig, (uint64_t)ccv_max(a->rows * a->cols, db->rows * db->cols) * CCV_GET_CHANNEL(a->type) * ((type & CCV_INTER_CUBIC) ? 16 : 1));
 	if (a->rows == db->rows && a->cols == db->cols)
 	{
 		if (CCV_GET_CHANNEL(a->type) == CCV_GET_CHANNEL(db->type) && CCV_GET_DATA_TYPE(db->type) == CCV_GET_DATA_TYPE(a->type))
@@ -586,3 +863,75 @@ void ccv_sample_up(ccv_dense_matrix_t* a, ccv_dense_matrix_t** b, int type, int
 	}
 #undef for_block
 }
+
+typedef struct {
+	ccv_dense_matrix_t* source;
+	int type; // 0 for ccv_sample_down, otherwise the interpolation method of ccv_resample
+	int rows; // the row of ccv_resample, or src_y of ccv_sample_down
+	int cols; // the column of ccv_resample, or src_x of ccv_sample_down
+	ccv_dense_matrix_t* level;
+} ccv_pyramid_level_t;
+
+ccv_pyramid_t* ccv_pyramid_new(ccv_dense_matrix_t* a)
+{
+	ccv_pyramid_t* pyramid = (ccv_pyramid_t*)ccmalloc(sizeof(ccv_pyramid_t));
+	pyramid->a = a;
+	pyramid->levels = ccv_array_new(sizeof(ccv_pyramid_level_t), 32, 0);
+	return pyramid;
+}
+
+static ccv_dense_matrix_t* _ccv_pyramid_find(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* source, int type, int rows, int cols)
+{
+	int i;
+	for (i = 0; i < pyramid->levels->rnum; i++)
+	{
+		ccv_pyramid_level_t* level = (ccv_pyramid_level_t*)ccv_array_get(pyramid->levels, i);
+		if (level->source == source && level->type == type && level->rows == rows && level->cols == cols)
+			return level->level;
+	}
+	return 0;
+}
+
+ccv_dense_matrix_t* ccv_pyramid_resample(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* level, int rows, int cols, int type)
+{
+	assert(type != 0);
+	ccv_dense_matrix_t* b = _ccv_pyramid_find(pyramid, level, type, rows, cols);
+	if (b)
+		return b;
+	ccv_resample(level, &b, 0, rows, cols, type);
+	ccv_pyramid_level_t new_level = {
+		.source = level,
+		.type = type,
+		.rows = rows,
+		.cols = cols,
+		.level = b,
+	};
+	ccv_array_push(pyramid->levels, &new_level);
+	return b;
+}
+
+ccv_dense_matrix_t* ccv_pyramid_sample_down(ccv_pyramid_t* pyramid, ccv_dense_matrix_t* level, int src_x, int src_y)
+{
+	ccv_dense_matrix_t* b = _ccv_pyramid_find(pyramid, level, 0, src_y, src_x);
+	if (b)
+		return b;
+	ccv_sample_down(level, &b, 0, src_x, src_y);
+	ccv_pyramid_level_t new_level = {
+		.source = level,
+		.type = 0,
+		.rows = src_y,
+		.cols = src_x,
+		.level = b,
+	};
+	ccv_array_push(pyramid->levels, &new_level);
+	return b;
+}
+
+void ccv_pyramid_free(ccv_pyramid_t* pyramid)
+{
+	int i;
+	for (i = 0; i < pyramid->levels->rnum; i++)
+		ccv_matrix_free(((ccv_pyramid_level_t*)ccv_array_get(pyramid->levels, i))->level);
+	ccv_array_free(pyramid->levels);
+	ccfree(pyramid);
+}
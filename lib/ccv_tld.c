@@ -84,7 +84,7 @@ static float _ccv_tld_norm_cross_correlate(ccv_dense_matrix_t* r0, ccv_dense_mat
 	return r0r1 / sqrtf(r0r0 * r1r1);
 }
 
-static ccv_rect_t _ccv_tld_short_term_track(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_rect_t box, ccv_tld_param_t params)
+static ccv_rect_t _ccv_tld_short_term_track(ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_optical_flow_pyramid_t* pyr_a, ccv_optical_flow_pyramid_t* pyr_b, ccv_rect_t box, ccv_tld_param_t params)
 {
 	ccv_rect_t newbox = ccv_rect(0, 0, 0, 0);
 	ccv_array_t* point_a = ccv_array_new(sizeof(ccv_decimal_point_t), (TLD_GRID_SPARSITY - 1) * (TLD_GRID_SPARSITY - 1), 0);
@@ -103,7 +103,7 @@ static ccv_rect_t _ccv_tld_short_term_track(ccv_dense_matrix_t* a, ccv_dense_mat
 		return newbox;
 	}
 	ccv_array_t* point_b = 0;
-	ccv_optical_flow_lucas_kanade(a, b, point_a, &point_b, params.win_size, params.level, params.min_eigen);
+	ccv_optical_flow_lucas_kanade_pyramid(pyr_a, pyr_b, point_a, &point_b, params.win_size, params.min_eigen);
 	if (point_b->rnum <= 0)
 	{
 		ccv_array_free(point_b);
@@ -111,7 +111,7 @@ static ccv_rect_t _ccv_tld_short_term_track(ccv_dense_matrix_t* a, ccv_dense_mat
 		return newbox;
 	}
 	ccv_array_t* point_c = 0;
-	ccv_optical_flow_lucas_kanade(b, a, point_b, &point_c, params.win_size, params.level, params.min_eigen);
+	ccv_optical_flow_lucas_kanade_pyramid(pyr_b, pyr_a, point_b, &point_c, params.win_size, params.min_eigen);
 	// compute forward-backward error
 	ccv_dense_matrix_t* r0 = (ccv_dense_matrix_t*)alloca(ccv_compute_dense_matrix_size(TLD_PATCH_SIZE, TLD_PATCH_SIZE, CCV_8U | CCV_C1));
 	ccv_dense_matrix_t* r1 = (ccv_dense_matrix_t*)alloca(ccv_compute_dense_matrix_size(TLD_PATCH_SIZE, TLD_PATCH_SIZE, CCV_8U | CCV_C1));
@@ -609,6 +609,7 @@ ccv_tld_t* ccv_tld_new(ccv_dense_matrix_t* a, ccv_rect_t box, ccv_tld_param_t pa
 	tld->params = params;
 	tld->nnc_verify_thres = params.nnc_verify;
 	tld->frame_signature = a->sig;
+	tld->pyr = 0;
 	tld->sfmt = ccmalloc(sizeof(sfmt_t));
 	tld->dsfmt = ccmalloc(sizeof(dsfmt_t));
 	tld->box.rect = box;
@@ -651,12 +652,8 @@ ccv_tld_t* ccv_tld_new(ccv_dense_matrix_t* a, ccv_rect_t box, ccv_tld_param_t pa
 	tld->var_thres = ccv_variance(b) * 0.5;
 	ccv_array_push(tld->sv[1], &b);
 	ccv_dense_matrix_t* sat = 0;
-	ccv_sat(a, &sat, 0, CCV_NO_PADDING);
-	ccv_dense_matrix_t* sq = 0;
-	ccv_multiply(a, a, (ccv_matrix_t**)&sq, 0);
 	ccv_dense_matrix_t* sqsat = 0;
-	ccv_sat(sq, &sqsat, 0, CCV_NO_PADDING);
-	ccv_matrix_free(sq);
+	ccv_sat_sqsat(a, &sat, 0, &sqsat, 0, CCV_NO_PADDING);
 	dsfmt_t* dsfmt = (dsfmt_t*)tld->dsfmt;
 	dsfmt_init_gen_rand(dsfmt, (uint32_t)(uintptr_t)tld);
 	{ // save stack fr alloca
@@ -882,6 +879,12 @@ static int _ccv_is_equal(const void* _r1, const void* _r2, void* data)
 	return _ccv_tld_rect_intersect(r1->rect, r2->rect) > 0.5;
 }
 
+/* r1 and r2 have to overlap to be equal */
+static ccv_rect_t _ccv_is_equal_bound(const void* _r, void* data)
+{
+	return ((const ccv_comp_t*)_r)->rect;
+}
+
 // since there is no refcount syntax for ccv yet, we won't implicitly retain any matrix in ccv_tld_t
 // instead, you should pass the previous frame and the current frame into the track function
 ccv_comp_t ccv_tld_track_object(ccv_tld_t* tld, ccv_dense_matrix_t* a, ccv_dense_matrix_t* b, ccv_tld_info_t* info)
@@ -894,9 +897,14 @@ ccv_comp_t ccv_tld_track_object(ccv_tld_t* tld, ccv_dense_matrix_t* a, ccv_dense
 	ccv_blur(b, &gb, 0, 1.5);
 	if (info)
 		info->perform_track = tld->found;
+	ccv_optical_flow_pyramid_t* pyr_b = 0;
 	if (tld->found)
 	{
-		result.rect = _ccv_tld_short_term_track(a, b, tld->box.rect, tld->params);
+		// the pyramid of the previous frame is kept from the last call, only the one of the current frame is new
+		if (!tld->pyr)
+			tld->pyr = ccv_optical_flow_pyramid_new(a, tld->params.win_size, tld->params.level);
+		pyr_b = ccv_optical_flow_pyramid_new(b, tld->params.win_size, tld->params.level);
+		result.rect = _ccv_tld_short_term_track(a, b, tld->pyr, pyr_b, tld->box.rect, tld->params);
 		if (!ccv_rect_is_zero(result.rect))
 		{
 			float scale = sqrtf((float)(result.rect.width * result.rect.height) / (tld->patch.width * tld->patch.height));
@@ -919,12 +927,8 @@ ccv_comp_t ccv_tld_track_object(ccv_tld_t* tld, ccv_dense_matrix_t* a, ccv_dense
 	if (info)
 		info->track_success = tracked;
 	ccv_dense_matrix_t* sat = 0;
-	ccv_sat(b, &sat, 0, CCV_NO_PADDING);
-	ccv_dense_matrix_t* sq = 0;
-	ccv_multiply(b, b, (ccv_matrix_t**)&sq, 0);
 	ccv_dense_matrix_t* sqsat = 0;
-	ccv_sat(sq, &sqsat, 0, CCV_NO_PADDING);
-	ccv_matrix_free(sq);
+	ccv_sat_sqsat(b, &sat, 0, &sqsat, 0, CCV_NO_PADDING);
 	ccv_array_t* dd = _ccv_tld_long_term_detect(tld, gb, sat, sqsat, info);
 	if (info)
 	{
@@ -937,7 +941,7 @@ ccv_comp_t ccv_tld_track_object(ccv_tld_t* tld, ccv_dense_matrix_t* a, ccv_dense
 	{
 		ccv_array_t* idx_dd = 0;
 		// group retrieved rectangles in order to filter out noise
-		int ncomp = ccv_array_group(dd, &idx_dd, _ccv_is_equal, 0);
+		int ncomp = ccv_array_group_with_bound(dd, &idx_dd, _ccv_is_equal, _ccv_is_equal_bound, 0);
 		ccv_comp_t* comps = (ccv_comp_t*)ccmalloc(ncomp * sizeof(ccv_comp_t));
 		memset(comps, 0, ncomp * sizeof(ccv_comp_t));
 		for (i = 0; i < dd->rnum; i++)
@@ -1042,6 +1046,9 @@ ccv_comp_t ccv_tld_track_object(ccv_tld_t* tld, ccv_dense_matrix_t* a, ccv_dense
 	tld->verified = verified;
 	tld->box = result;
 	tld->frame_signature = b->sig;
+	if (tld->pyr)
+		ccv_optical_flow_pyramid_free(tld->pyr);
+	tld->pyr = pyr_b;
 	++tld->count;
 	return result;
 }
@@ -1059,5 +1066,7 @@ void ccv_tld_free(ccv_tld_t* tld)
 	ccv_array_free(tld->sv[1]);
 	ccv_array_free(tld->top);
 	ccv_ferns_free(tld->ferns);
+	if (tld->pyr)
+		ccv_optical_flow_pyramid_free(tld->pyr);
 	ccfree(tld);
 }
@@ -1695,6 +1695,32 @@ typedef struct ccv_ptree_node_t
 } ccv_ptree_node_t;
 
 /* the code for grouping array is adopted from OpenCV's cvSeqPartition func, it is essentially a find-union algorithm */
+static int _ccv_ptree_index(ccv_ptree_node_t* node, int rnum, ccv_array_t** index)
+{
+	if (*index == 0)
+		*index = ccv_array_new(sizeof(int), rnum, 0);
+	else
+		ccv_array_clear(*index);
+	ccv_array_t* idx = *index;
+
+	int i, j, class_idx = 0;
+	for(i = 0; i < rnum; i++)
+	{
+		j = -1;
+		ccv_ptree_node_t* node1 = node + i;
+		if(node1->element)
+		{
+			while(node1->parent)
+				node1 = node1->parent;
+			if(node1->rank >= 0)
+				node1->rank = ~class_idx++;
+			j = ~node1->rank;
+		}
+		ccv_array_push(idx, &j);
+	}
+	return class_idx;
+}
+
 int ccv_array_group(ccv_array_t* array, ccv_array_t** index, ccv_array_group_f gfunc, void* data)
 {
 	int i, j;
@@ -1753,27 +1779,161 @@ int ccv_array_group(ccv_array_t* array, ccv_array_t** index, ccv_array_group_f g
 			}
 		}
 	}
-	if (*index == 0)
-		*index = ccv_array_new(sizeof(int), array->rnum, 0);
-	else
-		ccv_array_clear(*index);
-	ccv_array_t* idx = *index;
+	int class_idx = _ccv_ptree_index(node, array->rnum, index);
+	ccfree(node);
+	return class_idx;
+}
 
-	int class_idx = 0;
-	for(i = 0; i < array->rnum; i++)
+static void _ccv_ptree_union(ccv_ptree_node_t* node1, ccv_ptree_node_t* node2)
+{
+	ccv_ptree_node_t* root1 = node1;
+	while (root1->parent)
+		root1 = root1->parent;
+	ccv_ptree_node_t* root2 = node2;
+	while (root2->parent)
+		root2 = root2->parent;
+	if (root1 == root2)
+		return;
+	ccv_ptree_node_t* root;
+	if (root1->rank > root2->rank)
+		root = root2->parent = root1;
+	else {
+		root = root1->parent = root2;
+		root2->rank += root1->rank == root2->rank;
+	}
+	/* compress paths from both nodes to the root */
+	while (node1->parent)
 	{
-		j = -1;
-		ccv_ptree_node_t* node1 = node + i;
-		if(node1->element)
+		ccv_ptree_node_t* temp = node1;
+		node1 = node1->parent;
+		temp->parent = root;
+	}
+	while (node2->parent)
+	{
+		ccv_ptree_node_t* temp = node2;
+		node2 = node2->parent;
+		temp->parent = root;
+	}
+}
+
+/* elements are put into a hierarchical grid, an element goes to the level where the cell size is no
+ * smaller than its bound, thus, it takes at most 2x2 cells. Pairs are searched from the smaller one of
+ * the two, in the levels that are not finer than its own, therefore, only a few cells are looked up.
+ * The grid is a sorted array of (hashed cell, element) pairs, hash collisions only add candidates that
+ * will be filtered out by the bound. */
+typedef struct {
+	uint64_t cell;
+	int i;
+} ccv_array_group_cell_t;
+
+#define less_than(a, b, aux) ((a).cell < (b).cell)
+static CCV_IMPLEMENT_QSORT(_ccv_array_group_cell_qsort, ccv_array_group_cell_t, less_than)
+#undef less_than
+
+static int _ccv_array_group_level(ccv_rect_t bound)
+{
+	const int size = ccv_max(bound.width, bound.height);
+	return size <= 1 ? 0 : 32 - __builtin_clz((unsigned int)(size - 1)); // 2^level >= size
+}
+
+static uint64_t _ccv_array_group_cell(int level, int x, int y)
+{
+	return ((uint64_t)level << 58) ^ ((uint64_t)(uint32_t)x << 29) ^ (uint64_t)(uint32_t)y;
+}
+
+static int _ccv_array_group_cell_search(const ccv_array_group_cell_t* cells, int rnum, uint64_t cell)
+{
+	int low = 0, high = rnum;
+	while (low < high)
+	{
+		int middle = (low + high) / 2;
+		if (cells[middle].cell < cell)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+static int _ccv_rect_is_intersect(ccv_rect_t r1, ccv_rect_t r2)
+{
+	return r1.x < r2.x + r2.width && r2.x < r1.x + r1.width &&
+		r1.y < r2.y + r2.height && r2.y < r1.y + r1.height;
+}
+
+int ccv_array_group_with_bound(ccv_array_t* array, ccv_array_t** index, ccv_array_group_f gfunc, ccv_array_group_bound_f bfunc, void* data)
+{
+	int i, j, k, x, y;
+	ccv_ptree_node_t* node = (ccv_ptree_node_t*)ccmalloc(array->rnum * sizeof(ccv_ptree_node_t));
+	ccv_rect_t* bounds = (ccv_rect_t*)ccmalloc(array->rnum * sizeof(ccv_rect_t));
+	int* levels = (int*)ccmalloc(array->rnum * sizeof(int) * 2);
+	int* visited = levels + array->rnum;
+	ccv_array_group_cell_t* cells = (ccv_array_group_cell_t*)ccmalloc(array->rnum * 4 * sizeof(ccv_array_group_cell_t));
+	ccv_array_t* unbounded = ccv_array_new(sizeof(int), 0, 0);
+	uint64_t level_mask = 0;
+	int rnum = 0;
+	for (i = 0; i < array->rnum; i++)
+	{
+		node[i].parent = 0;
+		node[i].element = ccv_array_get(array, i);
+		node[i].rank = 0;
+		visited[i] = -1;
+		bounds[i] = bfunc(node[i].element, data);
+		if (bounds[i].width <= 0 || bounds[i].height <= 0)
 		{
-			while(node1->parent)
-				node1 = node1->parent;
-			if(node1->rank >= 0)
-				node1->rank = ~class_idx++;
-			j = ~node1->rank;
+			// it can be grouped with anything
+			levels[i] = -1;
+			ccv_array_push(unbounded, &i);
+			continue;
 		}
-		ccv_array_push(idx, &j);
+		const int level = levels[i] = _ccv_array_group_level(bounds[i]);
+		level_mask |= (uint64_t)1 << level;
+		for (y = bounds[i].y >> level; y <= (bounds[i].y + bounds[i].height - 1) >> level; y++)
+			for (x = bounds[i].x >> level; x <= (bounds[i].x + bounds[i].width - 1) >> level; x++)
+			{
+				cells[rnum].cell = _ccv_array_group_cell(level, x, y);
+				cells[rnum].i = i;
+				++rnum;
+			}
+	}
+	_ccv_array_group_cell_qsort(cells, rnum, 0);
+	for (i = 0; i < array->rnum; i++)
+	{
+		if (levels[i] < 0)
+			continue;
+		const ccv_rect_t bound = bounds[i];
+		for (k = levels[i]; k < 32; k++)
+			if (level_mask & ((uint64_t)1 << k))
+				for (y = bound.y >> k; y <= (bound.y + bound.height - 1) >> k; y++)
+					for (x = bound.x >> k; x <= (bound.x + bound.width - 1) >> k; x++)
+					{
+						const uint64_t cell = _ccv_array_group_cell(k, x, y);
+						int p;
+						for (p = _ccv_array_group_cell_search(cells, rnum, cell); p < rnum && cells[p].cell == cell; p++)
+						{
+							j = cells[p].i;
+							// pairs on the same level are visited from both sides, one is enough
+							if (visited[j] == i || (levels[j] == levels[i] && j <= i))
+								continue;
+							visited[j] = i;
+							if (_ccv_rect_is_intersect(bound, bounds[j]) &&
+								(gfunc(node[i].element, node[j].element, data) || gfunc(node[j].element, node[i].element, data)))
+								_ccv_ptree_union(node + i, node + j);
+						}
+					}
+	}
+	for (k = 0; k < unbounded->rnum; k++)
+	{
+		i = *(int*)ccv_array_get(unbounded, k);
+		for (j = 0; j < array->rnum; j++)
+			if (i != j && (gfunc(node[i].element, node[j].element, data) || gfunc(node[j].element, node[i].element, data)))
+				_ccv_ptree_union(node + i, node + j);
 	}
+	ccv_array_free(unbounded);
+	ccfree(cells);
+	ccfree(levels);
+	ccfree(bounds);
+	int class_idx = _ccv_ptree_index(node, array->rnum, index);
 	ccfree(node);
 	return class_idx;
 }
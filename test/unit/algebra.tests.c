@@ -1,5 +1,6 @@
 #include "ccv.h"
 #include "case.h"
+#include "ccv_case.h"
 
 TEST_CASE("matrix multiplication")
 { 
@@ -26,6 +27,43 @@ TEST_CASE("matrix multiplication")
 	ccv_matrix_free(y);
 }
 
+TEST_CASE("matrix multiplication with transpose on odd sizes")
+{
+	int i, j, k, t;
+	for (t = 0; t < 4; t++)
+	{
+		const int transpose = (t & 1 ? CCV_A_TRANSPOSE : 0) | (t & 2 ? CCV_B_TRANSPOSE : 0);
+		const int m = 103, n = 37, l = 301;
+		ccv_dense_matrix_t* a = (transpose & CCV_A_TRANSPOSE) ? ccv_dense_matrix_new(l, m, CCV_32F | CCV_C1, 0, 0) : ccv_dense_matrix_new(m, l, CCV_32F | CCV_C1, 0, 0);
+		ccv_dense_matrix_t* b = (transpose & CCV_B_TRANSPOSE) ? ccv_dense_matrix_new(n, l, CCV_32F | CCV_C1, 0, 0) : ccv_dense_matrix_new(l, n, CCV_32F | CCV_C1, 0, 0);
+		ccv_dense_matrix_t* c = ccv_dense_matrix_new(m, n, CCV_32F | CCV_C1, 0, 0);
+		for (i = 0; i < m * l; i++)
+			a->data.f32[i] = (float)((i * 7) % 13) / 13 - 0.5;
+		for (i = 0; i < l * n; i++)
+			b->data.f32[i] = (float)((i * 5) % 11) / 11 - 0.5;
+		for (i = 0; i < m * n; i++)
+			c->data.f32[i] = (float)(i % 3);
+		ccv_dense_matrix_t* y = 0;
+		ccv_gemm(a, b, 0.5, c, 2, transpose, (ccv_matrix_t**)&y, 0);
+		float* hy = (float*)ccmalloc(sizeof(float) * m * n);
+		for (i = 0; i < m; i++)
+			for (j = 0; j < n; j++)
+			{
+				double sum = 0;
+				for (k = 0; k < l; k++)
+					sum += ((transpose & CCV_A_TRANSPOSE) ? a->data.f32[k * m + i] : a->data.f32[i * l + k]) *
+						((transpose & CCV_B_TRANSPOSE) ? b->data.f32[j * l + k] : b->data.f32[k * n + j]);
+				hy[i * n + j] = 0.5 * sum + 2 * c->data.f32[i * n + j];
+			}
+		REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, hy, y->data.f32, m * n, 1e-4, "103x301, 301x37 matrix multiplication failure with transpose %d", transpose);
+		ccfree(hy);
+		ccv_matrix_free(a);
+		ccv_matrix_free(b);
+		ccv_matrix_free(c);
+		ccv_matrix_free(y);
+	}
+}
+
 TEST_CASE("matrix addition")
 {
 	ccv_dense_matrix_t* a = ccv_dense_matrix_new(3, 2, CCV_64F | CCV_C1, 0, 0);
@@ -164,4 +202,42 @@ TEST_CASE("summed area table with padding")
 	ccv_matrix_free(b);
 }
 
+TEST_CASE("summed area table and squared summed area table in one pass")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	int i, j, padding;
+	for (padding = 0; padding < 2; padding++)
+	{
+		const int padding_pattern = padding ? CCV_PADDING_ZERO : CCV_NO_PADDING;
+		ccv_dense_matrix_t* sat = 0;
+		ccv_dense_matrix_t* sqsat = 0;
+		ccv_sat_sqsat(image, &sat, 0, &sqsat, 0, padding_pattern);
+		REQUIRE(CCV_GET_DATA_TYPE(sat->type) == CCV_32S && CCV_GET_DATA_TYPE(sqsat->type) == CCV_64S, "should be 32-bit integer summed area table and 64-bit integer squared summed area table");
+		ccv_dense_matrix_t* x = 0;
+		ccv_sat(image, &x, 0, padding_pattern);
+		REQUIRE_MATRIX_EQ(sat, x, "should be the same as summed area table");
+		ccv_dense_matrix_t* sq = 0;
+		ccv_multiply(image, image, (ccv_matrix_t**)&sq, 0);
+		ccv_dense_matrix_t* y = 0;
+		ccv_sat(sq, &y, 0, padding_pattern);
+		REQUIRE_MATRIX_EQ(sqsat, y, "should be the same as summed area table of squares");
+		int64_t sum = 0, sqsum = 0;
+		for (i = 0; i < image->rows; i++)
+			for (j = 0; j < image->cols; j++)
+			{
+				sum += image->data.u8[i * image->step + j];
+				sqsum += image->data.u8[i * image->step + j] * image->data.u8[i * image->step + j];
+			}
+		REQUIRE_EQ(sat->data.i32[sat->rows * sat->cols - 1], sum, "the last element should be the sum");
+		REQUIRE_EQ(sqsat->data.i64[sqsat->rows * sqsat->cols - 1], sqsum, "the last element should be the squared sum");
+		ccv_matrix_free(sat);
+		ccv_matrix_free(sqsat);
+		ccv_matrix_free(x);
+		ccv_matrix_free(sq);
+		ccv_matrix_free(y);
+	}
+	ccv_matrix_free(image);
+}
+
 #include "case_main.h"
@@ -41,6 +41,43 @@ TEST_CASE("sobel operation")
 	ccv_matrix_free(y5);
 }
 
+TEST_CASE("gradient operation agrees with sobel operation")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_ANY_FILE);
+	int i, j, size;
+	for (size = 1; size <= 3; size += 2)
+	{
+		ccv_dense_matrix_t* x = 0;
+		ccv_sobel(image, &x, CCV_32F, size, 0);
+		ccv_dense_matrix_t* y = 0;
+		ccv_sobel(image, &y, CCV_32F, 0, size);
+		ccv_dense_matrix_t* theta = 0;
+		ccv_dense_matrix_t* m = 0;
+		ccv_gradient(image, &theta, 0, &m, 0, size, size);
+		double max_m = 0, max_theta = 0;
+		for (i = 0; i < image->rows; i++)
+			for (j = 0; j < image->cols * 3; j++)
+			{
+				float xf = x->data.f32[i * image->cols * 3 + j], yf = y->data.f32[i * image->cols * 3 + j];
+				max_m = ccv_max(max_m, fabs(m->data.f32[i * image->cols * 3 + j] - sqrtf(xf * xf + yf * yf)));
+				if (xf * xf + yf * yf > 1)
+				{
+					double e = fabs(theta->data.f32[i * image->cols * 3 + j] - (atan2(yf, xf) * 180 / CCV_PI + 360));
+					e = fmod(e, 360);
+					max_theta = ccv_max(max_theta, ccv_min(e, 360 - e));
+				}
+			}
+		REQUIRE(max_m < 1e-3, "magnitude should be the length of sobel vector with size %d", size);
+		REQUIRE(max_theta < 0.5, "angle should be the direction of sobel vector with size %d", size);
+		ccv_matrix_free(x);
+		ccv_matrix_free(y);
+		ccv_matrix_free(theta);
+		ccv_matrix_free(m);
+	}
+	ccv_matrix_free(image);
+}
+
 TEST_CASE("resample operation of CCV_INTER_AREA")
 {
 	ccv_dense_matrix_t* image = 0;
@@ -52,6 +89,71 @@ TEST_CASE("resample operation of CCV_INTER_AREA")
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("resample operation of CCV_INTER_AREA at a non-integer ratio")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/chessbox.png", &image, CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* x = 0;
+	ccv_resample(image, &x, 0, image->rows * 10 / 27, image->cols * 10 / 27, CCV_INTER_AREA);
+	REQUIRE_MATRIX_FILE_EQ(x, "data/chessbox.resample.2.7.bin", "should be the same as the scalar area resample of the color image");
+	ccv_matrix_free(image);
+	ccv_matrix_free(x);
+	image = 0;
+	ccv_read("../../samples/chessbox.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	x = 0;
+	ccv_resample(image, &x, 0, image->rows * 10 / 27, image->cols * 10 / 27, CCV_INTER_AREA);
+	REQUIRE_MATRIX_FILE_EQ(x, "data/chessbox.gray.resample.2.7.bin", "should be the same as the scalar area resample of the gray image");
+	ccv_matrix_free(image);
+	ccv_matrix_free(x);
+}
+
+TEST_CASE("resample operation of CCV_INTER_AREA to CCV_32F")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/chessbox.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* x = 0;
+	ccv_resample(image, &x, CCV_32F, image->rows * 10 / 23, image->cols * 10 / 23, CCV_INTER_AREA);
+	REQUIRE_MATRIX_FILE_EQ(x, "data/chessbox.gray.resample.32f.bin", "should be the same as the scalar area resample to float");
+	ccv_matrix_free(image);
+	ccv_matrix_free(x);
+}
+
+TEST_CASE("resample operation of CCV_INTER_CUBIC to CCV_32F")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/chessbox.png", &image, CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* x = 0;
+	ccv_resample(image, &x, CCV_32F, image->rows / 4 + 3, image->cols / 4 - 1, CCV_INTER_CUBIC);
+	ccv_dense_matrix_t* y = 0;
+	ccv_read("data/chessbox.cubic.32f.bin", &y, CCV_IO_ANY_FILE);
+	REQUIRE(x->rows == y->rows && x->cols == y->cols && CCV_GET_CHANNEL(x->type) == CCV_GET_CHANNEL(y->type), "should be the same size as the recorded result");
+	/* -ffast-math is free to reassociate the scalar sums, the ringing around black lands on both sides of 0 */
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, x->data.f32, y->data.f32, x->rows * x->cols * 3, 1e-3, "should be the same as the scalar cubic resample to float");
+	ccv_matrix_free(image);
+	ccv_matrix_free(x);
+	ccv_matrix_free(y);
+}
+
+TEST_CASE("resample operation of CCV_INTER_CUBIC on 8-bit is the clamped integer result")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/chessbox.png", &image, CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* x = 0;
+	ccv_resample(image, &x, 0, image->rows * 2 + 3, image->cols * 2 - 1, CCV_INTER_CUBIC);
+	ccv_dense_matrix_t* y = 0;
+	ccv_resample(image, &y, CCV_32S, image->rows * 2 + 3, image->cols * 2 - 1, CCV_INTER_CUBIC);
+	ccv_dense_matrix_t* z = ccv_dense_matrix_new(y->rows, y->cols, CCV_8U | CCV_C3, 0, 0);
+	int i, j;
+	for (i = 0; i < y->rows; i++)
+		for (j = 0; j < y->cols * 3; j++)
+			z->data.u8[i * z->step + j] = ccv_clamp(y->data.i32[i * y->cols * 3 + j], 0, 255);
+	REQUIRE_MATRIX_EQ(x, z, "8-bit cubic interpolation should match the 32-bit integer one");
+	ccv_matrix_free(image);
+	ccv_matrix_free(x);
+	ccv_matrix_free(y);
+	ccv_matrix_free(z);
+}
+
 TEST_CASE("sample down operation with source offset (10, 10)")
 {
 	ccv_dense_matrix_t* image = 0;
@@ -74,6 +176,39 @@ TEST_CASE("sample up operation with source offset (10, 10)")
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("image pyramid builds each level once, the same as resample and sample down")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/chessbox.png", &image, CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* x = 0;
+	ccv_resample(image, &x, 0, image->rows / 3, image->cols / 3, CCV_INTER_AREA);
+	ccv_dense_matrix_t* y = 0;
+	ccv_sample_down(x, &y, 0, 0, 0);
+	ccv_dense_matrix_t* z = 0;
+	ccv_sample_down(x, &z, 0, 1, 1);
+	// levels go to the cache when they are freed, thus, the cache tells whether the pyramid frees all of them
+	ccv_enable_default_cache();
+	ccv_pyramid_t* pyramid = ccv_pyramid_new(image);
+	ccv_dense_matrix_t* px = ccv_pyramid_resample(pyramid, image, image->rows / 3, image->cols / 3, CCV_INTER_AREA);
+	REQUIRE(px == ccv_pyramid_resample(pyramid, image, image->rows / 3, image->cols / 3, CCV_INTER_AREA), "should return the resampled level built the first time");
+	ccv_dense_matrix_t* py = ccv_pyramid_sample_down(pyramid, px, 0, 0);
+	REQUIRE(py == ccv_pyramid_sample_down(pyramid, px, 0, 0), "should return the downsampled level built the first time");
+	ccv_dense_matrix_t* pz = ccv_pyramid_sample_down(pyramid, px, 1, 1);
+	REQUIRE(pz != py, "should build another level for another source offset");
+	REQUIRE_EQ(3, pyramid->levels->rnum, "should have built 3 levels");
+	REQUIRE_MATRIX_EQ(px, x, "resampled level should be the same as ccv_resample");
+	REQUIRE_MATRIX_EQ(py, y, "downsampled level should be the same as ccv_sample_down");
+	REQUIRE_MATRIX_EQ(pz, z, "downsampled level with source offset (1, 1) should be the same as ccv_sample_down");
+	REQUIRE_EQ(0, ccv_cache_usage().rnum, "should have no level freed before the pyramid is");
+	ccv_pyramid_free(pyramid);
+	REQUIRE_EQ(3, ccv_cache_usage().rnum, "should have freed all 3 levels with the pyramid");
+	ccv_disable_cache();
+	ccv_matrix_free(image);
+	ccv_matrix_free(x);
+	ccv_matrix_free(y);
+	ccv_matrix_free(z);
+}
+
 TEST_CASE("blur operation with sigma 10")
 {
 	ccv_dense_matrix_t* image = 0;
@@ -85,6 +220,33 @@ TEST_CASE("blur operation with sigma 10")
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("recursive blur operation approximates blur operation")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_ANY_FILE);
+	double sigmas[] = {3, 5, 10};
+	int i, j;
+	for (i = 0; i < 3; i++)
+	{
+		ccv_dense_matrix_t* x = 0;
+		ccv_blur(image, &x, CCV_32F, sigmas[i]);
+		ccv_dense_matrix_t* y = 0;
+		ccv_blur_recursive(image, &y, CCV_32F, sigmas[i]);
+		double sum = 0, max = 0;
+		for (j = 0; j < x->rows * x->cols * 3; j++)
+		{
+			double e = fabs(x->data.f32[j] - y->data.f32[j]);
+			sum += e;
+			max = ccv_max(max, e);
+		}
+		REQUIRE(sum / (x->rows * x->cols * 3) < 1, "mean error should be within 1 with sigma %lf", sigmas[i]);
+		REQUIRE(max < 20, "max error should be within 20 with sigma %lf", sigmas[i]);
+		ccv_matrix_free(x);
+		ccv_matrix_free(y);
+	}
+	ccv_matrix_free(image);
+}
+
 TEST_CASE("flip operation")
 {
 	ccv_dense_matrix_t* image = 0;
@@ -115,6 +277,37 @@ TEST_CASE("canny edge detector")
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("histogram of oriented gradients")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/blackbox.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* x = 0;
+	ccv_hog(image, &x, 0, 9, 8);
+	REQUIRE_MATRIX_FILE_EQ(x, "data/blackbox.hog.bin", "HOG on artificial image");
+	ccv_matrix_free(image);
+	ccv_matrix_free(x);
+}
+
+TEST_CASE("histogram of oriented gradients on a pyramid is the same as on each level")
+{
+	ccv_dense_matrix_t* pyr[3] = {0};
+	ccv_read("../../samples/nature.png", &pyr[0], CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_sample_down(pyr[0], &pyr[1], 0, 0, 0);
+	ccv_sample_down(pyr[1], &pyr[2], 0, 0, 0);
+	ccv_dense_matrix_t* hog[3] = {0};
+	ccv_hog_pyramid(pyr, hog, 3, 0, 9, 8);
+	int i;
+	for (i = 0; i < 3; i++)
+	{
+		ccv_dense_matrix_t* x = 0;
+		ccv_hog(pyr[i], &x, 0, 9, 8);
+		REQUIRE_MATRIX_EQ(hog[i], x, "HOG of level %d should be the same", i);
+		ccv_matrix_free(x);
+		ccv_matrix_free(hog[i]);
+		ccv_matrix_free(pyr[i]);
+	}
+}
+
 TEST_CASE("otsu threshold")
 {
 	ccv_dense_matrix_t* image = ccv_dense_matrix_new(6, 6, CCV_32S | CCV_C1, 0, 0);
@@ -132,4 +325,132 @@ TEST_CASE("otsu threshold")
 	ccv_matrix_free(image);
 }
 
+TEST_CASE("lucas kanade optical flow on a translated image")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* a = 0;
+	ccv_slice(image, (ccv_matrix_t**)&a, 0, 8, 8, image->rows - 16, image->cols - 16);
+	ccv_dense_matrix_t* b = 0;
+	ccv_slice(image, (ccv_matrix_t**)&b, 0, 6, 11, image->rows - 16, image->cols - 16);
+	ccv_array_t* point_a = ccv_array_new(sizeof(ccv_decimal_point_t), 64, 0);
+	int x, y;
+	for (y = 1; y < 8; y++)
+		for (x = 1; x < 8; x++)
+		{
+			ccv_decimal_point_t point = ccv_decimal_point(a->cols * x / 8.0 + 0.25, a->rows * y / 8.0 + 0.5);
+			ccv_array_push(point_a, &point);
+		}
+	ccv_array_t* point_b = 0;
+	ccv_optical_flow_lucas_kanade(a, b, point_a, &point_b, ccv_size(15, 15), 5, 0.0001);
+	REQUIRE_EQ(point_b->rnum, point_a->rnum, "should have a tracked point for each point");
+	int i, good = 0;
+	for (i = 0; i < point_a->rnum; i++)
+	{
+		ccv_decimal_point_t* pa = (ccv_decimal_point_t*)ccv_array_get(point_a, i);
+		ccv_decimal_point_with_status_t* pb = (ccv_decimal_point_with_status_t*)ccv_array_get(point_b, i);
+		if (pb->status && fabsf(pb->point.x - (pa->x - 3)) < 0.1 && fabsf(pb->point.y - (pa->y + 2)) < 0.1)
+			++good;
+	}
+	// points on the bottom row are too close to the border on the coarsest level
+	REQUIRE(good >= point_a->rnum * 4 / 5, "most points should move by (-3, 2), but only %d of %d did", good, point_a->rnum);
+	// the pyramids give the same result as the frames
+	ccv_optical_flow_pyramid_t* pyr_a = ccv_optical_flow_pyramid_new(a, ccv_size(15, 15), 5);
+	ccv_optical_flow_pyramid_t* pyr_b = ccv_optical_flow_pyramid_new(b, ccv_size(15, 15), 5);
+	ccv_array_t* point_c = 0;
+	ccv_optical_flow_lucas_kanade_pyramid(pyr_a, pyr_b, point_a, &point_c, ccv_size(15, 15), 0.0001);
+	REQUIRE_EQ(point_c->rnum, point_b->rnum, "should have the same number of points");
+	for (i = 0; i < point_b->rnum; i++)
+	{
+		ccv_decimal_point_with_status_t* pb = (ccv_decimal_point_with_status_t*)ccv_array_get(point_b, i);
+		ccv_decimal_point_with_status_t* pc = (ccv_decimal_point_with_status_t*)ccv_array_get(point_c, i);
+		REQUIRE(pb->status == pc->status && pb->point.x == pc->point.x && pb->point.y == pc->point.y, "point %d should be the same from the pyramids", i);
+	}
+	ccv_array_free(point_c);
+	ccv_optical_flow_pyramid_free(pyr_b);
+	ccv_optical_flow_pyramid_free(pyr_a);
+	ccv_array_free(point_b);
+	ccv_array_free(point_a);
+	ccv_matrix_free(b);
+	ccv_matrix_free(a);
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("daisy descriptors on a sparse grid and at points are the same as the dense ones")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/chessbox.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_daisy_param_t params = {
+		.radius = 15,
+		.rad_q_no = 3,
+		.th_q_no = 8,
+		.hist_th_q_no = 8,
+		.normalize_threshold = 0.154,
+		.normalize_method = CCV_DAISY_NORMAL_PARTIAL,
+	};
+	const int desc_size = (params.rad_q_no * params.th_q_no + 1) * params.hist_th_q_no;
+	ccv_dense_matrix_t* dense = 0;
+	ccv_daisy(image, &dense, 0, params);
+	REQUIRE_EQ(dense->rows, image->rows, "should have a row of descriptors for each row");
+	REQUIRE_EQ(dense->cols, image->cols * desc_size, "should have a descriptor for each pixel");
+	params.step = 7;
+	ccv_dense_matrix_t* sparse = 0;
+	ccv_daisy(image, &sparse, 0, params);
+	REQUIRE_EQ(sparse->rows, (image->rows + 6) / 7, "should have a row of descriptors for every 7 rows");
+	REQUIRE_EQ(sparse->cols, (image->cols + 6) / 7 * desc_size, "should have a descriptor for every 7 pixels");
+	int i, j;
+	for (i = 0; i < sparse->rows; i++)
+		for (j = 0; j < sparse->cols / desc_size; j++)
+			REQUIRE_ARRAY_EQ(float, sparse->data.f32 + i * sparse->cols + j * desc_size, dense->data.f32 + i * 7 * dense->cols + j * 7 * desc_size, desc_size, "descriptor at (%d, %d) should be the same", j * 7, i * 7);
+	ccv_array_t* points = ccv_array_new(sizeof(ccv_point_t), 3, 0);
+	ccv_point_t point = ccv_point(image->cols / 2, image->rows / 3);
+	ccv_array_push(points, &point);
+	point = ccv_point(image->cols - 1, image->rows - 1);
+	ccv_array_push(points, &point);
+	point = ccv_point(-1, 0);
+	ccv_array_push(points, &point);
+	ccv_dense_matrix_t* at = 0;
+	ccv_daisy_points(image, points, &at, 0, params);
+	REQUIRE_EQ(at->rows, 3, "should have a descriptor for each point");
+	REQUIRE_ARRAY_EQ(float, at->data.f32, dense->data.f32 + image->rows / 3 * dense->cols + image->cols / 2 * desc_size, desc_size, "descriptor at the first point should be the same");
+	REQUIRE_ARRAY_EQ(float, at->data.f32 + at->cols, dense->data.f32 + (image->rows - 1) * dense->cols + (image->cols - 1) * desc_size, desc_size, "descriptor at the bottom right corner should be the same");
+	float zero[desc_size];
+	memset(zero, 0, sizeof(zero));
+	REQUIRE_ARRAY_EQ(float, at->data.f32 + at->cols * 2, zero, desc_size, "descriptor outside of the image should be zero");
+	ccv_array_free(points);
+	ccv_matrix_free(at);
+	ccv_matrix_free(sparse);
+	ccv_matrix_free(dense);
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("daisy histograms of every ring are sampled from their own smoothing level")
+{
+	// a horizontal ramp has the same gradient everywhere, thus, every smoothing level has the same histogram
+	ccv_dense_matrix_t* image = ccv_dense_matrix_new(100, 100, CCV_8U | CCV_C1, 0, 0);
+	int i, j;
+	for (i = 0; i < image->rows; i++)
+		for (j = 0; j < image->cols; j++)
+			image->data.u8[i * image->step + j] = j * 2;
+	ccv_daisy_param_t params = {
+		.radius = 15,
+		.rad_q_no = 3,
+		.th_q_no = 8,
+		.hist_th_q_no = 8,
+		.normalize_threshold = 0.154,
+		.normalize_method = CCV_DAISY_NORMAL_PARTIAL,
+	};
+	const int grid_point_number = params.rad_q_no * params.th_q_no + 1;
+	ccv_array_t* points = ccv_array_new(sizeof(ccv_point_t), 1, 0);
+	ccv_point_t point = ccv_point(50, 50);
+	ccv_array_push(points, &point);
+	ccv_dense_matrix_t* desc = 0;
+	ccv_daisy_points(image, points, &desc, 0, params);
+	for (i = 1; i < grid_point_number; i++)
+		REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, desc->data.f32 + i * params.hist_th_q_no, desc->data.f32, params.hist_th_q_no, 1e-4, "histogram of grid point %d should be the same as the center one", i);
+	ccv_array_free(points);
+	ccv_matrix_free(desc);
+	ccv_matrix_free(image);
+}
+
 #include "case_main.h"
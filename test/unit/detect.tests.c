@@ -0,0 +1,239 @@
+#include "ccv.h"
+#include "case.h"
+#include "ccv_case.h"
+
+static ccv_dense_matrix_t* _ccv_comps_to_matrix(ccv_array_t* seq)
+{
+	ccv_dense_matrix_t* x = ccv_dense_matrix_new(ccv_max(seq->rnum, 1), 6, CCV_32F | CCV_C1, 0, 0);
+	ccv_zero(x);
+	int i;
+	for (i = 0; i < seq->rnum; i++)
+	{
+		ccv_comp_t* comp = (ccv_comp_t*)ccv_array_get(seq, i);
+		x->data.f32[i * 6] = comp->rect.x;
+		x->data.f32[i * 6 + 1] = comp->rect.y;
+		x->data.f32[i * 6 + 2] = comp->rect.width;
+		x->data.f32[i * 6 + 3] = comp->rect.height;
+		x->data.f32[i * 6 + 4] = comp->neighbors;
+		x->data.f32[i * 6 + 5] = comp->classification.confidence;
+	}
+	return x;
+}
+
+TEST_CASE("BBF face detection is the same as the recorded scalar result")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_bbf_classifier_cascade_t* cascade = ccv_bbf_read_classifier_cascade("../../samples/face");
+	ccv_array_t* seq = ccv_bbf_detect_objects(image, &cascade, 1, ccv_bbf_default_params);
+	REQUIRE_EQ(1, seq->rnum, "should detect one face");
+	ccv_dense_matrix_t* x = _ccv_comps_to_matrix(seq);
+	REQUIRE_MATRIX_FILE_EQ(x, "data/nature.bbf.bin", "should be the same detection and confidence as the scalar code");
+	ccv_matrix_free(x);
+	ccv_array_free(seq);
+	ccv_bbf_classifier_cascade_free(cascade);
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("BBF windows through the first 8 stages are the same as the recorded scalar result")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_bbf_classifier_cascade_t* cascade = ccv_bbf_read_classifier_cascade("../../samples/face");
+	// a truncated cascade lets thousands of windows through, thus, every lane of the vectorized scan has to agree with the scalar one
+	int count = cascade->count;
+	cascade->count = 8;
+	ccv_bbf_param_t params = ccv_bbf_default_params;
+	params.min_neighbors = 0;
+	ccv_array_t* seq = ccv_bbf_detect_objects(image, &cascade, 1, params);
+	cascade->count = count;
+	REQUIRE_EQ(2468, seq->rnum, "should have 2468 windows");
+	ccv_dense_matrix_t* x = _ccv_comps_to_matrix(seq);
+	REQUIRE_MATRIX_FILE_EQ(x, "data/nature.bbf.8.bin", "should be the same windows and confidences as the scalar code");
+	ccv_matrix_free(x);
+	ccv_array_free(seq);
+	ccv_bbf_classifier_cascade_free(cascade);
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("integral channel features are the same as the recorded scalar result")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/pedestrian.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* x = 0;
+	ccv_icf(image, &x, 0);
+	REQUIRE_MATRIX_FILE_EQ(x, "data/pedestrian.icf.bin", "should be the same LUV, gradient magnitude and orientation channels as the scalar code");
+	ccv_matrix_free(x);
+	// 37 is not a multiple of 4, thus, the last pixels of each row are not in a full vector
+	ccv_dense_matrix_t* slice = 0;
+	ccv_slice(image, (ccv_matrix_t**)&slice, 0, 20, 10, 120, 37);
+	x = 0;
+	ccv_icf(slice, &x, 0);
+	REQUIRE_MATRIX_FILE_EQ(x, "data/pedestrian.slice.icf.bin", "should be the same channels as the scalar code on a 37 pixels wide slice");
+	ccv_matrix_free(x);
+	ccv_matrix_free(slice);
+	ccv_matrix_free(image);
+	image = 0;
+	ccv_read("../../samples/pedestrian.png", &image, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	x = 0;
+	ccv_icf(image, &x, 0);
+	REQUIRE_MATRIX_FILE_EQ(x, "data/pedestrian.gray.icf.bin", "should be the same grayscale, gradient magnitude and orientation channels as the scalar code");
+	ccv_matrix_free(x);
+	ccv_matrix_free(image);
+}
+
+// we probably won't cover all static functions in this test, disable annoying warnings
+#pragma GCC diagnostic ignored "-Wunused-function"
+// so that we can test static functions
+#include "ccv_icf.c"
+
+TEST_CASE("approximated ICF summed area table at scale 1 is the same as the exact one")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/pedestrian.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_margin_t margin = ccv_margin(3, 2, 5, 4);
+	ccv_dense_matrix_t* bordered = 0;
+	ccv_border(image, (ccv_matrix_t**)&bordered, 0, margin);
+	ccv_dense_matrix_t* icf = 0;
+	ccv_icf(bordered, &icf, 0);
+	ccv_dense_matrix_t* sat = 0;
+	ccv_sat(icf, &sat, 0, CCV_PADDING_ZERO);
+	ccv_dense_matrix_t* x = 0;
+	_ccv_icf_approximate_sat(sat, &x, margin, sat->rows - 1, sat->cols - 1, 1);
+	REQUIRE_MATRIX_EQ(x, sat, "should sample the summed area table at its own grid points");
+	ccv_matrix_free(image);
+	ccv_matrix_free(bordered);
+	ccv_matrix_free(icf);
+	ccv_matrix_free(sat);
+	ccv_matrix_free(x);
+}
+
+TEST_CASE("approximated ICF summed area table is the area resampled channels scaled by the power law")
+{
+	// channels are 1 in the rectangle (8, 10) - (30, 50) of the octave and 0 elsewhere, thus, the summed area table
+	// at any position is the overlap of the rectangle with everything above and to the left of that position
+	ccv_dense_matrix_t* icf = ccv_dense_matrix_new(60, 40, CCV_32F | 10, 0, 0);
+	int i, j, k;
+	for (i = 0; i < icf->rows; i++)
+		for (j = 0; j < icf->cols; j++)
+			for (k = 0; k < 10; k++)
+				icf->data.f32[(i * icf->cols + j) * 10 + k] = (i >= 10 && i < 50 && j >= 8 && j < 30);
+	ccv_dense_matrix_t* sat = 0;
+	ccv_sat(icf, &sat, 0, CCV_PADDING_ZERO);
+	ccv_margin_t margin = ccv_margin(3, 2, 5, 4);
+	double scale = pow(2., 1. / 9);
+	int rows = (int)((icf->rows - margin.top - margin.bottom) / scale + 0.5) + margin.top + margin.bottom;
+	int cols = (int)((icf->cols - margin.left - margin.right) / scale + 0.5) + margin.left + margin.right;
+	ccv_dense_matrix_t* x = 0;
+	_ccv_icf_approximate_sat(sat, &x, margin, rows, cols, scale);
+	REQUIRE_EQ(rows + 1, x->rows, "should have a row of zeros on top");
+	REQUIRE_EQ(cols + 1, x->cols, "should have a column of zeros on the left");
+	ccv_dense_matrix_t* y = ccv_dense_matrix_new(rows + 1, cols + 1, CCV_32F | 10, 0, 0);
+	for (i = 0; i <= rows; i++)
+	{
+		double v = ccv_clamp((i - margin.top) * scale + margin.top, 0, icf->rows);
+		double h = ccv_clamp(v, 10, 50) - 10;
+		for (j = 0; j <= cols; j++)
+		{
+			double u = ccv_clamp((j - margin.left) * scale + margin.left, 0, icf->cols);
+			double w = ccv_clamp(u, 8, 30) - 8;
+			// luv channels are scale invariant, gradient magnitude and orientations follow the power law with exponent 0.11
+			for (k = 0; k < 10; k++)
+				y->data.f32[(i * y->cols + j) * 10 + k] = h * w * (k < 3 ? 1 : pow(scale, 0.11)) / (scale * scale);
+		}
+	}
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, x->data.f32, y->data.f32, (rows + 1) * (cols + 1) * 10, 1e-3, "should be the area of the rectangle at 1 / scale, scaled by the power law");
+	ccv_matrix_free(icf);
+	ccv_matrix_free(sat);
+	ccv_matrix_free(x);
+	ccv_matrix_free(y);
+}
+
+static double _ccv_sat_box(ccv_dense_matrix_t* sat, int k, int x0, int y0, int x1, int y1)
+{
+	int ch = CCV_GET_CHANNEL(sat->type);
+	return (double)sat->data.f32[(y1 * sat->cols + x1) * ch + k] - sat->data.f32[(y0 * sat->cols + x1) * ch + k] - sat->data.f32[(y1 * sat->cols + x0) * ch + k] + sat->data.f32[(y0 * sat->cols + x0) * ch + k];
+}
+
+TEST_CASE("approximated ICF summed area table at 2^(1/9) is close to the exact one of the resampled image")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/street.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_margin_t margin = ccv_margin(6, 6, 6, 6);
+	ccv_dense_matrix_t* bordered = 0;
+	ccv_border(image, (ccv_matrix_t**)&bordered, 0, margin);
+	ccv_dense_matrix_t* icf = 0;
+	ccv_icf(bordered, &icf, 0);
+	ccv_matrix_free(bordered);
+	ccv_dense_matrix_t* octave = 0;
+	ccv_sat(icf, &octave, 0, CCV_PADDING_ZERO);
+	ccv_matrix_free(icf);
+	double scale = pow(2., 1. / 9);
+	int rows = (int)(image->rows / scale + 0.5);
+	int cols = (int)(image->cols / scale + 0.5);
+	ccv_dense_matrix_t* x = 0;
+	_ccv_icf_approximate_sat(octave, &x, margin, rows + margin.top + margin.bottom, cols + margin.left + margin.right, scale);
+	ccv_dense_matrix_t* resampled = 0;
+	ccv_resample(image, &resampled, 0, rows, cols, CCV_INTER_AREA);
+	bordered = 0;
+	ccv_border(resampled, (ccv_matrix_t**)&bordered, 0, margin);
+	icf = 0;
+	ccv_icf(bordered, &icf, 0);
+	ccv_dense_matrix_t* sat = 0;
+	ccv_sat(icf, &sat, 0, CCV_PADDING_ZERO);
+	REQUIRE_EQ(sat->rows, x->rows, "should have the rows of the exact summed area table");
+	REQUIRE_EQ(sat->cols, x->cols, "should have the columns of the exact summed area table");
+	// the power law holds for the sum over a large area rather than for each pixel, compare the sums over the image and over its center
+	int k, q;
+	for (q = 0; q < 2; q++)
+	{
+		int x0 = margin.left + q * cols / 4, y0 = margin.top + q * rows / 4;
+		int x1 = margin.left + cols - q * cols / 4, y1 = margin.top + rows - q * rows / 4;
+		for (k = 0; k < 3; k++)
+			REQUIRE_EQ_WITH_TOLERANCE(_ccv_sat_box(x, k, x0, y0, x1, y1) / _ccv_sat_box(sat, k, x0, y0, x1, y1), 1, 0.01, "luv channel %d should be within 1%%", k);
+		REQUIRE_EQ_WITH_TOLERANCE(_ccv_sat_box(x, 3, x0, y0, x1, y1) / _ccv_sat_box(sat, 3, x0, y0, x1, y1), 1, 0.05, "gradient magnitude should be within 5%%");
+		double approximated = 0, exact = 0;
+		for (k = 4; k < 10; k++)
+			approximated += _ccv_sat_box(x, k, x0, y0, x1, y1), exact += _ccv_sat_box(sat, k, x0, y0, x1, y1);
+		REQUIRE_EQ_WITH_TOLERANCE(approximated / exact, 1, 0.05, "gradient orientations should be within 5%% altogether");
+	}
+	ccv_matrix_free(image);
+	ccv_matrix_free(octave);
+	ccv_matrix_free(x);
+	ccv_matrix_free(resampled);
+	ccv_matrix_free(bordered);
+	ccv_matrix_free(icf);
+	ccv_matrix_free(sat);
+}
+
+TEST_CASE("approximated ICF feature pyramid finds the pedestrians the exact one does")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/street.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_icf_classifier_cascade_t* cascade = ccv_icf_read_classifier_cascade("../../samples/pedestrian.icf");
+	ccv_icf_param_t params = ccv_icf_default_params;
+	params.step_through = 1;
+	ccv_array_t* seq = ccv_icf_detect_objects(image, &cascade, 1, params);
+	params.flags = CCV_ICF_APPROXIMATE;
+	ccv_array_t* approximated = ccv_icf_detect_objects(image, &cascade, 1, params);
+	REQUIRE(seq->rnum > 0, "should find pedestrians");
+	int i, j;
+	for (i = 0; i < seq->rnum; i++)
+	{
+		ccv_comp_t* comp = (ccv_comp_t*)ccv_array_get(seq, i);
+		int found = 0;
+		for (j = 0; j < approximated->rnum && !found; j++)
+		{
+			ccv_comp_t* other = (ccv_comp_t*)ccv_array_get(approximated, j);
+			int x = other->rect.x + other->rect.width / 2, y = other->rect.y + other->rect.height / 2;
+			found = x >= comp->rect.x && x < comp->rect.x + comp->rect.width && y >= comp->rect.y && y < comp->rect.y + comp->rect.height;
+		}
+		REQUIRE(found, "should find the pedestrian at (%d, %d, %d, %d) with the approximated feature pyramid", comp->rect.x, comp->rect.y, comp->rect.width, comp->rect.height);
+	}
+	ccv_array_free(seq);
+	ccv_array_free(approximated);
+	ccv_icf_classifier_cascade_free(cascade);
+	ccv_matrix_free(image);
+}
+
+#include "case_main.h"
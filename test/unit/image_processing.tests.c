@@ -32,4 +32,64 @@ TEST_CASE("image contrast")
 	ccv_matrix_free(image);
 }
 
+TEST_CASE("color transform from RGB to gray is the same as reading raw RGB data as gray")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* b = 0;
+	ccv_color_transform(image, &b, 0, CCV_RGB_TO_GRAY);
+	ccv_dense_matrix_t* x = 0;
+	ccv_read(image->data.u8, &x, CCV_IO_RGB_RAW | CCV_IO_GRAY, image->rows, image->cols, image->step);
+	REQUIRE_MATRIX_EQ(b, x, "gray image from color transform should be the same as from raw data");
+	int i, j;
+	for (i = 0; i < image->rows; i++)
+		for (j = 0; j < image->cols; j++)
+		{
+			unsigned char* rgb = image->data.u8 + i * image->step + j * 3;
+			REQUIRE_EQ(b->data.u8[i * b->step + j], (rgb[0] * 6969 + rgb[1] * 23434 + rgb[2] * 2365) >> 15, "gray value at (%d, %d) should be computed with BT.709 coefficients", j, i);
+		}
+	ccv_matrix_free(x);
+	ccv_matrix_free(b);
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("color transform from RGB to YUV and back")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/nature.png", &image, CCV_IO_RGB_COLOR | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* yuv = 0;
+	ccv_color_transform(image, &yuv, CCV_32S, CCV_RGB_TO_YUV);
+	ccv_dense_matrix_t* b = 0;
+	ccv_color_transform(yuv, &b, CCV_8U, CCV_YUV_TO_RGB);
+	int i, max = 0;
+	for (i = 0; i < image->rows * image->cols * 3; i++)
+		max = ccv_max(max, abs((int)image->data.u8[i] - (int)b->data.u8[i]));
+	// both directions truncate, the error on chroma is amplified by 4096 / 2015 on the way back
+	REQUIRE(max <= 4, "RGB to YUV and back should be within the rounding error, but is %d", max);
+	ccv_matrix_free(yuv);
+	ccv_matrix_free(b);
+	ccv_matrix_free(image);
+}
+
+TEST_CASE("color transform from RGB to LUV")
+{
+	ccv_dense_matrix_t* image = ccv_dense_matrix_new(1, 5, CCV_8U | CCV_C3, 0, 0);
+	unsigned char rgb[15] = {0, 0, 0, 255, 255, 255, 255, 0, 0, 0, 255, 0, 0, 0, 255};
+	memcpy(image->data.u8, rgb, 15);
+	ccv_dense_matrix_t* b = 0;
+	ccv_color_transform(image, &b, 0, CCV_RGB_TO_LUV);
+	REQUIRE(CCV_GET_DATA_TYPE(b->type) == CCV_32F, "LUV should be in float by default");
+	// L in [0, 100], U in [-134, 220], V in [-140, 122], all scaled to 0~255
+	float luv[15] = {
+		0, 134 * 255.f / 354, 140 * 255.f / 262,
+		100 * 255.f / 100, 134 * 255.f / 354, 140 * 255.f / 262,
+		53.24 * 255.f / 100, (175.01 + 134) * 255.f / 354, (37.76 + 140) * 255.f / 262,
+		87.73 * 255.f / 100, (-83.07 + 134) * 255.f / 354, (107.41 + 140) * 255.f / 262,
+		32.30 * 255.f / 100, (-9.40 + 134) * 255.f / 354, (-130.35 + 140) * 255.f / 262,
+	};
+	REQUIRE_ARRAY_EQ_WITH_TOLERANCE(float, luv, b->data.f32, 15, 1.5, "LUV of black, white, red, green and blue");
+	ccv_matrix_free(b);
+	ccv_matrix_free(image);
+}
+
 #include "case_main.h"
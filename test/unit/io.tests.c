@@ -353,6 +353,68 @@ TEST_CASE("read JPEG from memory")
 	ccv_matrix_free(x);
 }
 
+TEST_CASE("read JPEG scaled down to max dimension")
+{
+	ccv_dense_matrix_t* x = 0;
+	ccv_read_scaled("../../samples/cmyk-jpeg-format.jpg", &x, CCV_IO_ANY_FILE, 0, 500);
+	// 2400x1745 at 1/4 is the smallest scale that is no smaller than 500
+	REQUIRE_EQ(600, x->cols, "should decode at 1/4 scale");
+	REQUIRE_EQ(437, x->rows, "should decode at 1/4 scale");
+	ccv_dense_matrix_t* y = 0;
+	ccv_read_scaled("../../samples/cmyk-jpeg-format.jpg", &y, CCV_IO_ANY_FILE, 0, 2400);
+	REQUIRE_EQ(2400, y->cols, "should decode at full scale");
+	REQUIRE_EQ(1745, y->rows, "should decode at full scale");
+	ccv_matrix_free(y);
+	ccv_matrix_free(x);
+}
+
+TEST_CASE("read a batch of images concurrently")
+{
+	const char* files[] = {
+		"../../samples/chessbox.png",
+		"../../samples/cmyk-jpeg-format.jpg",
+		"../../samples/does-not-exist.png",
+		"../../samples/nature.png",
+	};
+	ccv_dense_matrix_t* xs[4];
+	int status[4];
+	ccv_read_batch((const void* const*)files, 0, 4, xs, status, CCV_IO_ANY_FILE | CCV_IO_GRAY, 0, 2);
+	REQUIRE_EQ(CCV_IO_ERROR, status[2], "should fail to read the file that doesn't exist");
+	REQUIRE(xs[2] == 0, "should have no image for the file that doesn't exist");
+	int i;
+	for (i = 0; i < 4; i++)
+		if (i != 2)
+		{
+			REQUIRE_EQ(CCV_IO_FINAL, status[i], "should read %s", files[i]);
+			ccv_dense_matrix_t* x = 0;
+			ccv_read(files[i], &x, CCV_IO_ANY_FILE | CCV_IO_GRAY);
+			REQUIRE_MATRIX_EQ(x, xs[i], "should be the same as ccv_read %s", files[i]);
+			ccv_matrix_free(x);
+			ccv_matrix_free(xs[i]);
+		}
+}
+
+TEST_CASE("map binary file with no copy mode")
+{
+	ccv_dense_matrix_t* x = ccv_dense_matrix_new(31, 17, CCV_32F | CCV_C3, 0, 0);
+	int i;
+	for (i = 0; i < 31 * 17 * 3; i++)
+		x->data.f32[i] = i * 0.5;
+	ccv_write(x, "io.tests.bin", 0, CCV_IO_BINARY_FILE, 0);
+	ccv_dense_matrix_t* y = 0;
+	ccv_read("io.tests.bin", &y, CCV_IO_ANY_FILE | CCV_IO_NO_COPY);
+	REQUIRE(y->type & CCV_NO_DATA_ALLOC, "should point to the mapping");
+	REQUIRE_MATRIX_EQ(x, y, "should be the same as the one written");
+	y->data.f32[0] = 1; // copy-on-write
+	ccv_matrix_free(y);
+	y = 0;
+	ccv_read("io.tests.bin", &y, CCV_IO_ANY_FILE | CCV_IO_NO_COPY);
+	REQUIRE_MATRIX_EQ(x, y, "should be unchanged on disk");
+	ccv_matrix_free(y);
+	ccv_matrix_free(x);
+	remove("io.tests.bin");
+}
+
 TEST_CASE("read PNG from memory")
 {
 	ccv_dense_matrix_t* x = 0;
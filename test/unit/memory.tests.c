@@ -1,6 +1,10 @@
 #include "ccv.h"
 #include "ccv_internal.h"
 #include "case.h"
+#include "ccv_case.h"
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 uint64_t uniqid()
 {
@@ -173,4 +177,218 @@ TEST_CASE("multi-type garbage collector 92\% hit rate")
 	ccv_disable_cache();
 }
 
+TEST_CASE("cache statistics count hits, misses and evictions")
+{
+	ccv_cache_t cache;
+	ccv_cache_init(&cache, 4, 2, ccfree, ccfree);
+	int i;
+	for (i = 0; i < 6; i++)
+		ccv_cache_put(&cache, i + 1, ccmalloc(4), 1, i % 2);
+	REQUIRE_EQ(4, cache.rnum, "should keep 4 objects");
+	REQUIRE_EQ(3, cache.stats[0].put, "should put 3 objects of type 0");
+	REQUIRE_EQ(3, cache.stats[1].put, "should put 3 objects of type 1");
+	REQUIRE_EQ(2, cache.stats[0].evict + cache.stats[1].evict, "should evict 2 objects");
+	uint8_t type = 1;
+	void* x = ccv_cache_out(&cache, 6, &type);
+	REQUIRE(x != 0, "should find the last object");
+	ccfree(x);
+	type = 0;
+	REQUIRE(ccv_cache_get(&cache, 1024, &type) == 0, "should not find this object");
+	REQUIRE_EQ(1, cache.stats[1].hit, "should hit type 1 once");
+	REQUIRE_EQ(1, cache.stats[1].saved, "should save 1 byte");
+	REQUIRE_EQ(1, cache.stats[0].miss, "should miss type 0 once");
+	ccv_cache_close(&cache);
+}
+
+TEST_CASE("cost-aware cache keeps expensive objects over cheap ones")
+{
+	ccv_cache_t cache;
+	ccv_cache_init(&cache, 64 * 16, 1, ccfree);
+	cache.policy = CCV_CACHE_GDSF;
+	int i;
+	/* the first object takes 1024 units of work to compute per 64 bytes */
+	ccv_cache_put_with_cost(&cache, 1, ccmalloc(64), 64, 0, 64 * 1024);
+	for (i = 0; i < 256; i++)
+		ccv_cache_put_with_cost(&cache, i + 2, ccmalloc(64), 64, 0, 64);
+	REQUIRE_EQ(16, cache.rnum, "should keep 16 objects");
+	REQUIRE(ccv_cache_get(&cache, 1, 0) != 0, "should keep the expensive object");
+	REQUIRE(ccv_cache_get(&cache, 2, 0) == 0, "should evict cheap objects");
+	REQUIRE(ccv_cache_get(&cache, 257, 0) != 0, "should keep the recent cheap object");
+	ccv_cache_close(&cache);
+	ccv_cache_init(&cache, 64 * 16, 1, ccfree);
+	ccv_cache_put_with_cost(&cache, 1, ccmalloc(64), 64, 0, 64 * 1024);
+	for (i = 0; i < 256; i++)
+		ccv_cache_put_with_cost(&cache, i + 2, ccmalloc(64), 64, 0, 64);
+	REQUIRE(ccv_cache_get(&cache, 1, 0) == 0, "LRU should ignore the cost");
+	ccv_cache_close(&cache);
+}
+
+TEST_CASE("cache switches from cost-aware to LRU policy with objects in it")
+{
+	ccv_cache_t cache;
+	ccv_cache_init(&cache, 64 * 16, 1, ccfree);
+	cache.policy = CCV_CACHE_GDSF;
+	int i;
+	/* objects put with GDSF are older than the ones put after with LRU, and sit after them in the tree */
+	for (i = 0; i < 8; i++)
+		ccv_cache_put_with_cost(&cache, i + 57, ccmalloc(64), 64, 0, 64 * 1024);
+	cache.policy = CCV_CACHE_LRU;
+	for (i = 0; i < 56; i++)
+		ccv_cache_put_with_cost(&cache, i + 1, ccmalloc(64), 64, 0, 64 * 1024);
+	REQUIRE_EQ(16, cache.rnum, "should keep 16 objects");
+	REQUIRE(ccv_cache_get(&cache, 56, 0) != 0, "should keep the last object");
+	REQUIRE(ccv_cache_get(&cache, 1, 0) == 0, "should evict objects put with LRU in order");
+	ccv_cache_close(&cache);
+}
+
+TEST_CASE("application-wide cache usage with breakdown by operation")
+{
+	ccv_enable_default_cache();
+	ccv_enable_cache_origin_stats();
+	ccv_dense_matrix_t* a = ccv_dense_matrix_new(16, 16, CCV_8U | CCV_C1, 0, 0);
+	memset(a->data.u8, 1, a->rows * a->step);
+	ccv_make_matrix_immutable(a);
+	ccv_dense_matrix_t* b = 0;
+	ccv_sobel(a, &b, 0, 1, 0);
+	ccv_matrix_free(b);
+	b = 0;
+	ccv_sobel(a, &b, 0, 1, 0);
+	ccv_matrix_free(b);
+	ccv_cache_usage_t usage = ccv_cache_usage();
+	REQUIRE_EQ(1, usage.rnum, "should have the derived matrix in the cache");
+	REQUIRE_EQ(1, usage.matrix.hit, "should hit the second time");
+	REQUIRE_EQ(1, usage.matrix.miss, "should miss the first time");
+	ccv_cache_origin_stats_t origins[4];
+	int count = ccv_cache_origin_stats(origins, 4);
+	REQUIRE_EQ(2, count, "should record ccv_sobel besides unknown");
+	REQUIRE(strcmp(origins[1].name, "ccv_sobel") == 0, "should be ccv_sobel");
+	REQUIRE_EQ(1, origins[1].hit, "ccv_sobel should hit once");
+	REQUIRE_EQ(1, origins[1].miss, "ccv_sobel should miss once");
+	REQUIRE_EQ(2, origins[1].put, "ccv_sobel should put twice");
+	ccv_disable_cache_origin_stats();
+	ccv_matrix_free(a);
+	ccv_disable_cache();
+}
+
+TEST_CASE("disk cache persists derived matrices after reopen")
+{
+	remove("memory.tests.cache");
+	REQUIRE_EQ(0, ccv_enable_disk_cache("memory.tests.cache", 1024 * 1024), "should create the disk cache");
+	ccv_dense_matrix_t* a = ccv_dense_matrix_new(16, 16, CCV_8U | CCV_C1, 0, 0);
+	int i;
+	for (i = 0; i < a->rows * a->step; i++)
+		a->data.u8[i] = i;
+	ccv_make_matrix_immutable(a);
+	ccv_dense_matrix_t* b = 0;
+	ccv_sobel(a, &b, 0, 1, 0);
+	ccv_dense_matrix_t* c = ccv_dense_matrix_new(b->rows, b->cols, b->type, 0, 0);
+	memcpy(c->data.u8, b->data.u8, b->rows * b->step);
+	ccv_matrix_free(b);
+	ccv_disk_cache_stats_t stats = ccv_disk_cache_stats();
+	REQUIRE_EQ(1, stats.miss, "should miss the first time");
+	REQUIRE_EQ(1, stats.put, "should write the derived matrix");
+	ccv_disable_disk_cache();
+	REQUIRE_EQ(0, ccv_enable_disk_cache("memory.tests.cache", 1024), "should open the disk cache again");
+	b = 0;
+	ccv_sobel(a, &b, 0, 1, 0);
+	stats = ccv_disk_cache_stats();
+	REQUIRE_EQ(1, stats.hit, "should read it from the disk");
+	REQUIRE_EQ(1, stats.rnum, "should have one matrix");
+	REQUIRE_MATRIX_EQ(b, c, "should be the same as computed");
+	ccv_matrix_free(b);
+	ccv_matrix_free(c);
+	ccv_matrix_free(a);
+	ccv_disable_disk_cache();
+	remove("memory.tests.cache");
+}
+
+TEST_CASE("matrix pool recycles buffers of the same size class")
+{
+	ccv_enable_matrix_pool(1024 * 1024);
+	int i;
+	for (i = 0; i < 100; i++)
+	{
+		ccv_dense_matrix_t* a = ccv_dense_matrix_new(64, 64, CCV_8U | CCV_C1, 0, 0);
+		// slightly smaller ones fall into the same size class
+		ccv_dense_matrix_t* b = ccv_dense_matrix_new(63, 64 - (i % 4), CCV_8U | CCV_C1, 0, 0);
+		memset(a->data.u8, i, a->rows * a->step);
+		memset(b->data.u8, i, b->rows * b->step);
+		ccv_matrix_free(a);
+		ccv_matrix_free_immediately(b);
+	}
+	ccv_matrix_pool_stats_t stats = ccv_matrix_pool_stats();
+	REQUIRE_EQ(200, stats.alloc, "should allocate 200 matrices through the pool");
+	REQUIRE_EQ(2, stats.malloc, "should only call ccmalloc for the first two matrices");
+	REQUIRE_EQ(198, stats.reuse, "should reuse buffers for the rest");
+	REQUIRE_EQ(200, stats.recycle, "should return all buffers to the pool");
+	REQUIRE(stats.size >= ccv_compute_dense_matrix_size(64, 64, CCV_8U | CCV_C1) * 2, "should retain both buffers");
+	ccv_disable_matrix_pool();
+	stats = ccv_matrix_pool_stats();
+	REQUIRE_EQ(0, stats.size, "should release everything after disabled");
+}
+
+TEST_CASE("shared cache bounds the total, not the share of each shard")
+{
+	const size_t size = ccv_compute_dense_matrix_size(256, 256, CCV_32S | CCV_C1);
+	// 4 objects fit in total, each of them is larger than 1/16 of the budget
+	ccv_enable_shared_cache(size * 4);
+	int i;
+	for (i = 0; i < 16; i++)
+	{
+		ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(256, 256, CCV_32S | CCV_C1, 0, 0);
+		dmt->data.i32[0] = i;
+		dmt->sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+		dmt->type |= CCV_REUSABLE;
+		ccv_matrix_free(dmt);
+		ccv_cache_usage_t usage = ccv_cache_usage();
+		REQUIRE_EQ(size * 4, usage.up, "the upper limit should be the total budget");
+		REQUIRE(usage.size <= usage.up, "should fit in the budget after %d objects", i + 1);
+	}
+	ccv_cache_usage_t usage = ccv_cache_usage();
+	REQUIRE(usage.rnum > 0, "should keep objects larger than 1/16 of the budget");
+	i = 15;
+	uint64_t sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+	ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(256, 256, CCV_32S | CCV_C1, 0, sig);
+	REQUIRE_EQ(15, dmt->data.i32[0], "should keep the last object");
+	ccv_matrix_free_immediately(dmt);
+	ccv_disable_cache();
+}
+
+#ifdef HAVE_PTHREAD
+static void* _shared_cache_fill(void* arg)
+{
+	int i;
+	for (i = 0; i < N; i++)
+	{
+		ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(1, 1, CCV_32S | CCV_C1, 0, 0);
+		dmt->data.i32[0] = i;
+		dmt->sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+		dmt->type |= CCV_REUSABLE;
+		ccv_matrix_free(dmt);
+	}
+	return 0;
+}
+
+TEST_CASE("shared garbage collector 90\% hit rate across threads")
+{
+	int i;
+	ccv_enable_shared_cache(ccv_compute_dense_matrix_size(1, 1, CCV_32S | CCV_C1) * N);
+	pthread_t thread;
+	pthread_create(&thread, 0, _shared_cache_fill, 0);
+	pthread_join(thread, 0);
+	int percent = 0, total = 0;
+	for (i = N - 1; i > N * 6 / 100; i--)
+	{
+		uint64_t sig = ccv_cache_generate_signature((const char*)&i, 4, CCV_EOF_SIGN);
+		ccv_dense_matrix_t* dmt = ccv_dense_matrix_new(1, 1, CCV_32S | CCV_C1, 0, sig);
+		if (i == dmt->data.i32[0])
+			++percent;
+		++total;
+		ccv_matrix_free_immediately(dmt);
+	}
+	REQUIRE((double)percent / (double)total > 0.9, "the cache hit (%lf) should be greater than 90%%", (double)percent / (double)total);
+	ccv_disable_cache();
+}
+#endif
+
 #include "case_main.h"
@@ -107,6 +107,31 @@ TEST_CASE("Gaussian blur with kernel size even & odd")
 	ccv_matrix_free(y);
 }
 
+TEST_CASE("ccv_filter with the kernel spectrum from cache")
+{
+	ccv_dense_matrix_t* image = 0;
+	ccv_read("../../samples/street.png", &image, CCV_IO_ANY_FILE);
+	// only the kernel has a signature, thus, only its spectrum is cached, not the filter response
+	image->sig = 0;
+	ccv_dense_matrix_t* kernel = ccv_dense_matrix_new(40, 41, CCV_32F | CCV_GET_CHANNEL(image->type), 0, 0);
+	ccv_filter_kernel(kernel, gaussian, 0);
+	ccv_dense_matrix_t* x = 0;
+	ccv_filter(image, kernel, &x, CCV_32F, 0);
+	ccv_enable_default_cache();
+	ccv_dense_matrix_t* y = 0;
+	ccv_filter(image, kernel, &y, CCV_32F, 0);
+	ccv_dense_matrix_t* z = 0;
+	ccv_filter(image, kernel, &z, CCV_32F, 0);
+	ccv_disable_cache();
+	ccv_matrix_free(kernel);
+	ccv_matrix_free(image);
+	REQUIRE_MATRIX_EQ(x, y, "filter response should be the same when the kernel spectrum is computed and cached");
+	REQUIRE_MATRIX_EQ(x, z, "filter response should be the same when the kernel spectrum is from cache");
+	ccv_matrix_free(x);
+	ccv_matrix_free(y);
+	ccv_matrix_free(z);
+}
+
 TEST_CASE("ccv_filter centre point for even number window size, hint: (size - 1) / 2")
 {
 	ccv_dense_matrix_t* x = ccv_dense_matrix_new(10, 10, CCV_32F | CCV_C1, 0, 0);
@@ -398,4 +423,34 @@ TEST_CASE("ccv_distance_transform to compute max distance")
 	ccv_matrix_free(distance);
 }
 
+TEST_CASE("ccv_distance_transform with the displacement of max distance")
+{
+	ccv_dense_matrix_t* geometry = 0;
+	ccv_read("../../samples/geometry.png", &geometry, CCV_IO_GRAY | CCV_IO_ANY_FILE);
+	ccv_dense_matrix_t* distance = 0;
+	ccv_dense_matrix_t* mx = 0;
+	ccv_dense_matrix_t* my = 0;
+	double dx = 0.5;
+	double dy = -0.5;
+	double dxx = 0.4;
+	double dyy = 0.3;
+	ccv_distance_transform(geometry, &distance, 0, &mx, 0, &my, 0, dx, dy, dxx, dyy, CCV_NEGATIVE | CCV_GSEDT);
+	// the distance at each point should be the one from the point it is displaced from
+	ccv_dense_matrix_t* ref = ccv_dense_matrix_new(distance->rows, distance->cols, CCV_32F | CCV_C1, 0, 0);
+	int i, j;
+	for (i = 0; i < distance->rows; i++)
+		for (j = 0; j < distance->cols; j++)
+		{
+			int y = my->data.i32[i * my->cols + j];
+			int x = mx->data.i32[(i - y) * mx->cols + j];
+			ref->data.f32[i * ref->cols + j] = dy * y + dyy * y * y + dx * x + dxx * x * x - geometry->data.u8[(i - y) * geometry->step + j - x];
+		}
+	ccv_matrix_free(geometry);
+	ccv_matrix_free(mx);
+	ccv_matrix_free(my);
+	REQUIRE_MATRIX_EQ(distance, ref, "distance transform should match the distance from the displaced point");
+	ccv_matrix_free(ref);
+	ccv_matrix_free(distance);
+}
+
 #include "case_main.h"
@@ -105,6 +105,59 @@ TEST_CASE("group array with is_equal function")
 	ccv_array_free(idx);
 }
 
+int is_equal_window(const void* _r1, const void* _r2, void* data)
+{
+	const ccv_comp_t* r1 = (const ccv_comp_t*)_r1;
+	const ccv_comp_t* r2 = (const ccv_comp_t*)_r2;
+	int distance = (int)(r1->rect.width * 0.25 + 0.5);
+
+	return r2->classification.id == r1->classification.id &&
+		r2->rect.x <= r1->rect.x + distance &&
+		r2->rect.x >= r1->rect.x - distance &&
+		r2->rect.y <= r1->rect.y + distance &&
+		r2->rect.y >= r1->rect.y - distance &&
+		r2->rect.width <= (int)(r1->rect.width * 1.5 + 0.5) &&
+		(int)(r2->rect.width * 1.5 + 0.5) >= r1->rect.width;
+}
+
+ccv_rect_t is_equal_window_bound(const void* _r, void* data)
+{
+	const ccv_comp_t* r = (const ccv_comp_t*)_r;
+	if (r->rect.width == 0) // let it be compared against everything
+		return ccv_rect(0, 0, 0, 0);
+	int distance = (int)(r->rect.width * 0.25 + 0.5);
+	return ccv_rect(r->rect.x - distance, r->rect.y - distance, distance * 2 + 1, distance * 2 + 1);
+}
+
+TEST_CASE("group dense windows with bound")
+{
+	dsfmt_t dsfmt;
+	dsfmt_init_gen_rand(&dsfmt, 0);
+	ccv_array_t* array = ccv_array_new(sizeof(ccv_comp_t), 4096, 0);
+	int i;
+	for (i = 0; i < 4096; i++)
+	{
+		ccv_comp_t comp;
+		comp.rect.width = comp.rect.height = (int)(24 * pow(1.2, (int)(dsfmt_genrand_open_close(&dsfmt) * 12)));
+		comp.rect.x = (int)(dsfmt_genrand_open_close(&dsfmt) * 640) - 20;
+		comp.rect.y = (int)(dsfmt_genrand_open_close(&dsfmt) * 480) - 20;
+		comp.classification.id = (i % 4 == 0);
+		if (i % 1000 == 0)
+			comp.rect.width = 0;
+		ccv_array_push(array, &comp);
+	}
+	ccv_array_t* idx = 0;
+	int ncomp = ccv_array_group(array, &idx, is_equal_window, 0);
+	ccv_array_t* bidx = 0;
+	int bncomp = ccv_array_group_with_bound(array, &bidx, is_equal_window, is_equal_window_bound, 0);
+	REQUIRE(ncomp > 1 && ncomp < 4096, "should have some groups");
+	REQUIRE_EQ(ncomp, bncomp, "should have the same number of groups");
+	REQUIRE_ARRAY_EQ(int, idx->data, bidx->data, 4096, "should have the same groups");
+	ccv_array_free(array);
+	ccv_array_free(idx);
+	ccv_array_free(bidx);
+}
+
 TEST_CASE("specific sparse matrix insertion")
 {
 	ccv_sparse_matrix_t* mat = ccv_sparse_matrix_new(1, 70, CCV_32S | CCV_C1, CCV_SPARSE_ROW_MAJOR, 0);